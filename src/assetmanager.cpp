@@ -19,6 +19,7 @@ AssetManager::~AssetManager() {
 }
 
 void AssetManager::CreateFont(const char *name, const char *filename) {
+    TRACE_SPAN("AssetManager::CreateFont");
     Font font = LoadFontEx(filename, AssetManager::FontSize, nullptr, 0);
     fonts.insert(
         std::make_pair(std::string(name), font)
@@ -35,6 +36,7 @@ void AssetManager::DeleteFont(const char *name) {
 }
 
 void AssetManager::CreateTexture(const char *name, const char *filename) {
+    TRACE_SPAN("AssetManager::CreateTexture");
     Texture2D texture = LoadTexture(filename);
     textures.insert(
         std::make_pair(std::string(name), texture)
@@ -45,6 +47,10 @@ Texture2D& AssetManager::GetTexture(const char *name) {
     return textures.at(std::string(name));
 }
 
+bool AssetManager::HasTexture(const char *name) {
+    return textures.contains(std::string(name));
+}
+
 void AssetManager::DeleteTexture(const char *name) {
     UnloadTexture(textures.at(name));
     textures.erase(std::string(name));
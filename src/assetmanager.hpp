@@ -6,6 +6,7 @@
 #include <unordered_map>
 
 #include "raylib/raylib.h"
+#include "trace.hpp"
 
 /*
     Manages all fonts and textures, stored with string keys in separate hashmaps.
@@ -57,6 +58,9 @@ class AssetManager {
     
     /*  returns a texture from the collection under a specific name  */
     Texture2D& GetTexture(const char *name);
+
+    /*  is there a texture under this name? (generated rooms don't have images)  */
+    bool HasTexture(const char *name);
     
     /*  deletes a texture and unloads it  */
     void DeleteTexture(const char *name);
@@ -0,0 +1,145 @@
+#include "bench.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <tuple>
+
+#include "nullfrontend.hpp"
+#include "profiler.hpp"
+
+namespace {
+    /*  what the benchmarks work out goes here, so the compiler can't leave the work out  */
+    volatile uint64_t sink;
+
+    /*  three lines' worth, for Write  */
+    const std::string Paragraph =
+        "The corridor bends left and then right again, past a row of doors that all look the same, "
+        "each with a brass number and a little window too dusty to see through. Somewhere further on "
+        "a clock is ticking, slightly too slowly.";
+}
+
+std::string Bench::Result::ToJson() const {
+    auto perOp = [](double x) { return (x < 0) ? std::string("null") : fmt::format("{:.2f}", x); };
+    return fmt::format("{{\"bench\":\"{}\",\"size\":{},\"ops\":{},\"ns_per_op\":{:.1f},\"allocs_per_op\":{},\"bytes_per_op\":{}}}",
+        name, size, ops, nsPerOp, perOp(allocsPerOp), perOp(bytesPerOp));
+}
+
+Bench::Bench(Config _config) : config(std::move(_config)) { }
+
+void Bench::Run(std::function<void(Result const&)> report) {
+    for (uint32_t size : config.sizes) {
+        RunWorld(size, report);
+    }
+}
+
+template<class Op>
+Bench::Result Bench::Measure(std::string name, uint32_t size, Op&& op) {
+    using Clock = std::chrono::steady_clock;
+    auto batch = [&](uint64_t n) {
+        auto allocs = Profiler::ThreadAllocations();
+        auto start = Clock::now();
+        for (uint64_t i = 0; i < n; i++) {
+            op();
+        }
+        double ns = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+        auto after = Profiler::ThreadAllocations();
+        return std::make_tuple(ns, after.count - allocs.count, after.bytes - allocs.bytes);
+    };
+
+    /* warm up, doubling until a batch takes long enough to say how many ops fit in config.seconds */
+    uint64_t ops = 1;
+    double target = config.seconds * 1e9;
+    while (true) {
+        double ns = std::get<0>(batch(ops));
+        if (ns >= target / 8 || ops >= (uint64_t(1) << 40)) {
+            ops = std::max<uint64_t>(1, static_cast<uint64_t>(ops * target / std::max(ns, 1.0)));
+            break;
+        }
+        ops *= 2;
+    }
+
+    std::vector<std::tuple<double, uint64_t, uint64_t>> runs;
+    for (uint32_t r = 0; r < std::max<uint32_t>(config.runs, 1); r++) {
+        runs.push_back(batch(ops));
+    }
+    std::sort(runs.begin(), runs.end());
+    auto [ns, allocs, bytes] = runs[runs.size() / 2];
+    bool counted = Profiler::CountsAllocations;
+    return Result {
+        std::move(name), size, ops, ns / ops,
+        counted ? static_cast<double>(allocs) / ops : -1,
+        counted ? static_cast<double>(bytes) / ops : -1
+    };
+}
+
+void Bench::RunWorld(uint32_t size, std::function<void(Result const&)> const& report) {
+    WorldGen::Config world = config.world;
+    world.roomCount = size;
+    world.itemCount = size;
+    auto frontend = std::make_unique<NullFrontend>();
+    NullFrontend *out = frontend.get();
+    TextBasedGame game(std::move(frontend));
+    game.Init(world);
+
+    /* the loose items are added after the keys and doors, so the last ones are never a door */
+    uint32_t itemCount = game.items.Size();
+    uint32_t here = game.Current()->currentRoom;
+    for (uint32_t i = 0; i < InventoryItems + RoomItems && i < itemCount; i++) {
+        game.MoveItem(itemCount - 1 - i, (i < InventoryItems) ? Delta::Inventory : here);
+    }
+    std::string takeInput = "take " + game.items.Get(itemCount - 1 - std::min(itemCount - 1, InventoryItems)).GetRepr();
+
+    /* names to look up, spread over the whole world */
+    std::vector<std::string> roomNames, itemNames;
+    for (uint32_t i = 0; i < 1024; i++) {
+        roomNames.push_back(game.rooms.GetName(static_cast<uint32_t>((i * 7919ull) % game.rooms.Size())));
+        itemNames.push_back(game.items.GetName(static_cast<uint32_t>((i * 7919ull) % itemCount)));
+    }
+
+    uint64_t total = 0;
+    size_t n = 0;
+
+    auto commands = game.GetCommands();
+    report(Measure("Command::IsMatch", size, [&] {
+        total += commands[n++ % commands.size()].IsMatch(takeInput);
+    }));
+    report(Measure("TextBasedGame::Eval", size, [&] {
+        game.Eval("look around");
+    }));
+    out->SetTextIn("take ");
+    report(Measure("TextBasedGame::UpdateHint", size, [&] {
+        /* as if something was typed every time */
+        game.hintValid = false;
+        game.UpdateHint();
+    }));
+    out->SetTextIn("");
+    report(Measure("TextBasedGame::GetCommands", size, [&] {
+        total += game.GetCommands().size();
+    }));
+    report(Measure("TextBasedGame::Write", size, [&] {
+        game.Current()->output.clear();
+        game.Write(Paragraph);
+    }));
+    report(Measure("TextBasedGame::InventoryRepr", size, [&] {
+        total += game.InventoryRepr().size();
+    }));
+    report(Measure("TextBasedGame::CurrentRoomRepr", size, [&] {
+        total += game.CurrentRoomRepr().size();
+    }));
+    report(Measure("Collection::Get", size, [&] {
+        /* the name and the repr are both by reference, so only the lookup itself is timed */
+        std::string const& repr = game.rooms.Get(roomNames[n++ % roomNames.size()]).GetRepr();
+        total += repr.size();
+    }));
+    report(Measure("Collection::FindId", size, [&] {
+        total += game.items.FindId(itemNames[n++ % itemNames.size()]);
+    }));
+    report(Measure("PathFinder::FindPath", size, [&] {
+        /* a different pair of rooms every time, like "go to" from wherever the player happens to be */
+        uint32_t from = static_cast<uint32_t>((n * 7919ull) % size), to = static_cast<uint32_t>((n * 104729ull + size / 2) % size);
+        n++;
+        total += game.Current()->pathFinder.FindPath(*game.Current()->roomGraph, from, to).size();
+    }));
+    sink = total;
+}
@@ -0,0 +1,75 @@
+#ifndef __BENCH__
+#define __BENCH__
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "textbasedgame.hpp"
+#include "worldgen.hpp"
+
+/*
+    Microbenchmarks of what runs every frame or every command - Command::IsMatch, Eval, UpdateHint,
+    GetCommands, Write wrapping lines, InventoryRepr/CurrentRoomRepr, Collection lookups and PathFinder routes - on generated
+    worlds of a few sizes, for comparing one build with another (make bench)
+
+    Every world is the same for the same seed and size, and set up the same way before timing: the
+    player holds the last InventoryItems loose items and the room they're in has the RoomItems before
+    those. Each benchmark runs once to warm up and size its batch (enough ops to take Config::seconds),
+    then Config::runs batches - the result is the median batch, so a stray slow one doesn't count.
+    Allocations per op come from the TBG_COUNT_ALLOCS counters (-1 in builds without them).
+*/
+class Bench {
+
+    public:
+
+    struct Config {
+        /*  world sizes to run at - rooms, and as many loose items  */
+        std::vector<uint32_t> sizes = { 100, 1000, 10000 };
+        /*  everything else about the worlds (roomCount and itemCount are set from sizes)  */
+        WorldGen::Config world;
+        /*  how long a batch should take, seconds  */
+        double seconds = 0.1;
+        /*  batches timed per benchmark  */
+        uint32_t runs = 5;
+    };
+
+    /*  one benchmark at one world size  */
+    struct Result {
+        std::string name;
+        /*  rooms in the world, and loose items  */
+        uint32_t size;
+        /*  ops in a batch  */
+        uint64_t ops;
+        double nsPerOp;
+        /*  -1 if allocations aren't counted (null in the JSON)  */
+        double allocsPerOp;
+        double bytesPerOp;
+
+        /*  the result as one line of JSON, {"bench": ..., "size": ..., "ns_per_op": ..., "allocs_per_op": ...}  */
+        std::string ToJson() const;
+    };
+
+    /*  items put in the inventory, and in the current room, before timing  */
+    static inline constexpr uint32_t InventoryItems = 8;
+    static inline constexpr uint32_t RoomItems = 8;
+
+    Bench(Config _config);
+
+    /*  runs everything at every size, calls report with each result as it's done  */
+    void Run(std::function<void(Result const&)> report);
+
+    private:
+
+    Config config;
+
+    /*  runs every benchmark on one world  */
+    void RunWorld(uint32_t size, std::function<void(Result const&)> const& report);
+
+    /*  times op as described above  */
+    template<class Op>
+    Result Measure(std::string name, uint32_t size, Op&& op);
+};
+
+#endif /* __BENCH__ */
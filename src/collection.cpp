@@ -5,19 +5,66 @@ Collection<T>::Collection() { }
 
 template<class T>
 void Collection<T>::Add(std::string name, T item) {
-    items.emplace(name, item);
+    if (index.contains(name)) {
+        return;
+    }
+    index.emplace(name, static_cast<uint32_t>(entries.size()));
+    entries.emplace_back(name, item);
 }
 
 template<class T>
-T& Collection<T>::Get(std::string name) {
-    return items.at(name);
+T& Collection<T>::Get(std::string const& name) {
+    return entries[index.at(name)].second;
+}
+
+template<class T>
+T& Collection<T>::Get(uint32_t id) {
+    return entries.at(id).second;
 }
 
 template<class T>
 void Collection<T>::Delete(std::string name) {
-    items.erase(name);
+    auto it = index.find(name);
+    if (it == index.end()) {
+        return;
+    }
+    uint32_t removed = it->second;
+    entries.erase(entries.begin() + removed);
+    index.erase(it);
+    for (auto& [_, id] : index) {
+        if (id > removed) {
+            id--;
+        }
+    }
+}
+
+template<class T>
+uint32_t Collection<T>::GetId(std::string const& name) {
+    return index.at(name);
+}
+
+template<class T>
+uint32_t Collection<T>::FindId(std::string const& name) {
+    auto it = index.find(name);
+    return (it == index.end()) ? None : it->second;
+}
+
+template<class T>
+std::string& Collection<T>::GetName(uint32_t id) {
+    return entries.at(id).first;
+}
+
+template<class T>
+bool Collection<T>::Contains(std::string const& name) {
+    return index.contains(name);
+}
+
+template<class T>
+uint32_t Collection<T>::Size() {
+    return static_cast<uint32_t>(entries.size());
 }
 
 template class Collection<Command>;
 template class Collection<Item>;
-template class Collection<Room>;
\ No newline at end of file
+template class Collection<NPC>;
+template class Collection<Room>;
@@ -1,41 +1,74 @@
 #ifndef __COLLECTION__
 #define __COLLECTION__
 
+#include <cstdint>
+#include <deque>
 #include <string>
 #include <unordered_map>
+#include <utility>
 
 #include "command.hpp"
 #include "item.hpp"
+#include "npc.hpp"
 #include "room.hpp"
 
-/*  wrapper around unordered_map<T> with string keys  */
+/*
+    wrapper around a list of (name, T) pairs with string keys
+    every entry also gets an integer id (its insertion index) that never changes,
+    so other systems (like RoomGraph) can store ids instead of names
+    entries live in a deque so references to them stay valid when more are added
+*/
 template<class T>
 class Collection {
     private:
 
-    std::unordered_map<std::string, T> items;
+    /*  every entry, in insertion order - index = id  */
+    std::deque<std::pair<std::string, T>> entries;
+    /*  name -> id  */
+    std::unordered_map<std::string, uint32_t> index;
 
     public:
 
+    /*  returned by FindId() when there's nothing under that name  */
+    static inline constexpr uint32_t None = UINT32_MAX;
+
     Collection();
+    /*  adds an entry, does nothing if the name is already taken (like map::emplace)  */
     void Add(std::string name, T item);
-    T& Get(std::string name);
+    T& Get(std::string const& name);
+    /*  gets an entry by id instead of name  */
+    T& Get(uint32_t id);
+    /*
+        removes an entry - this shifts the id of every entry added after it,
+        so only use it before anything has stored ids
+    */
     void Delete(std::string name);
 
+    /*  the id of an entry, throws std::out_of_range like Get() if missing  */
+    uint32_t GetId(std::string const& name);
+    /*  the id of an entry, or None if missing  */
+    uint32_t FindId(std::string const& name);
+    /*  the name an entry was added under  */
+    std::string& GetName(uint32_t id);
+    /*  is there an entry under this name?  */
+    bool Contains(std::string const& name);
+    /*  how many entries there are (ids go from 0 to Size() - 1)  */
+    uint32_t Size();
+
     /* iterator stuff */
 
     auto inline begin() {
-        return items.begin();
+        return entries.begin();
     }
     auto inline end() {
-        return items.end();
+        return entries.end();
     }
     auto inline cbegin() const {
-        return items.cbegin();
+        return entries.cbegin();
     }
     auto inline cend() const {
-        return items.cend();
+        return entries.cend();
     }
 };
 
-#endif /* __COLLECTION__ */
\ No newline at end of file
+#endif /* __COLLECTION__ */
@@ -4,6 +4,16 @@ Command::Command(
     std::string _pattern_str,
     std::vector<std::string> _hints,
     std::function<void()> _callback
+) {
+    pattern = std::regex("^" + _pattern_str + "$", std::regex::icase);
+    hints = _hints;
+    callback = [_callback](std::smatch const&) { _callback(); };
+}
+
+Command::Command(
+    std::string _pattern_str,
+    std::vector<std::string> _hints,
+    std::function<void(std::smatch const&)> _callback
 ) {
     pattern = std::regex("^" + _pattern_str + "$", std::regex::icase);
     hints = _hints;
@@ -23,9 +33,14 @@ bool Command::IsMatch(std::string& s) {
 }
 
 bool Command::TryEval(std::string& s) {
-    bool is_match = IsMatch(s);
+    std::smatch match;
+    bool is_match;
+    {
+        TRACE_SPAN("Command::TryEval match");
+        is_match = std::regex_match(s, match, pattern);
+    }
     if (is_match) {
-        callback();
+        callback(match);
     }
     return is_match;
 }
\ No newline at end of file
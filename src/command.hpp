@@ -5,6 +5,8 @@
 #include <regex>
 #include <string>
 
+#include "trace.hpp"
+
 /*
     An in-game command. A list of these is matched against anything the player inputs.
     These are strictly internal and do not get shown to the player in any way, aside from the hints.
@@ -21,11 +23,12 @@ class Command {
     */
     std::vector<std::string> hints;
     /*
-        the function to run when this is matched, must be void -> void
+        the function to run when this is matched, gets the regex match so it can read
+        any groups (like the exit name in "go <exit>")
         every command must have one, and it can do nothing, but should
         print an error message at the very least
     */
-    std::function<void()> callback;
+    std::function<void(std::smatch const&)> callback;
 
     public:
 
@@ -42,6 +45,16 @@ class Command {
         std::vector<std::string> _hints,
         std::function<void()> _callback = []{}
     );
+    /*
+        Command constructor for commands that take an argument
+        same as above, but the callback gets the match results, so
+        for "(go|move) (.+)" the exit name is match[2]
+    */
+    Command(
+        std::string _pattern_str,
+        std::vector<std::string> _hints,
+        std::function<void(std::smatch const&)> _callback
+    );
     /*  Command destructor, empty method  */
     ~Command();
 
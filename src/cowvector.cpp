@@ -0,0 +1,84 @@
+#include "cowvector.hpp"
+
+#include <stdexcept>
+
+template<class T>
+CowVector<T>::CowVector() { }
+
+template<class T>
+void CowVector<T>::Own() {
+    if (!base) {
+        base = std::make_shared<std::vector<T>>();
+    } else if (base.use_count() > 1) {
+        base = std::make_shared<std::vector<T>>(*base);
+    }
+}
+
+template<class T>
+T const& CowVector<T>::Get(uint32_t i) const {
+    if (!changes.empty()) {
+        auto it = changes.find(i);
+        if (it != changes.end()) {
+            return it->second;
+        }
+    }
+    if (i >= Size()) {
+        throw std::out_of_range("CowVector::Get");
+    }
+    return (*base)[i];
+}
+
+template<class T>
+void CowVector<T>::Set(uint32_t i, T value) {
+    if (i >= Size()) {
+        throw std::out_of_range("CowVector::Set");
+    }
+    if ((*base)[i] == value) {
+        changes.erase(i);
+    } else {
+        changes.insert_or_assign(i, std::move(value));
+    }
+}
+
+template<class T>
+void CowVector<T>::PushBack(T value) {
+    Own();
+    base->push_back(std::move(value));
+}
+
+template<class T>
+uint32_t CowVector<T>::Size() const {
+    return base ? static_cast<uint32_t>(base->size()) : 0;
+}
+
+template<class T>
+size_t CowVector<T>::GetChangeCount() const {
+    return changes.size();
+}
+
+template<class T>
+std::unordered_map<uint32_t, T> const& CowVector<T>::GetChanges() const {
+    return changes;
+}
+
+template<class T>
+void CowVector<T>::Revert() {
+    /* not clear(), that keeps the buckets - and copies of this would get them all too */
+    std::unordered_map<uint32_t, T>().swap(changes);
+}
+
+template<class T>
+void CowVector<T>::Flatten() {
+    if (changes.empty()) {
+        return;
+    }
+    Own();
+    for (auto &[i, value] : changes) {
+        (*base)[i] = std::move(value);
+    }
+    Revert();
+}
+
+template class CowVector<uint8_t>;
+template class CowVector<uint32_t>;
+template class CowVector<std::vector<uint32_t>>;
@@ -0,0 +1,62 @@
+#ifndef __COWVECTOR__
+#define __COWVECTOR__
+
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+/*
+    A vector that can be shared between lots of owners (sessions, see TextBasedGame::Session)
+    and only remembers where it differs from the shared one
+
+    Copies share the base and copy just the changes, so an owner that changed 3 elements costs
+    3 elements no matter how long the vector is. Setting an element back to what the base has
+    forgets the change again.
+
+    The base is only written (PushBack, Flatten) by an owner that has it to itself -
+    a shared base gets copied first, so anything that was shared never changes under anyone
+    (which is also what makes reading the same base from several threads fine)
+*/
+template<class T>
+class CowVector {
+    private:
+
+    /*  what every copy starts from, nullptr = empty  */
+    std::shared_ptr<std::vector<T>> base;
+    /*  index -> value, for every element that isn't what base has  */
+    std::unordered_map<uint32_t, T> changes;
+
+    /*  makes sure base isn't shared with anyone, copying it if it is  */
+    void Own();
+
+    public:
+
+    CowVector();
+
+    /*  element i, throws std::out_of_range past the end  */
+    T const& Get(uint32_t i) const;
+
+    /*  sets element i, throws std::out_of_range past the end  */
+    void Set(uint32_t i, T value);
+
+    /*  adds an element at the end (copies the base if it's shared)  */
+    void PushBack(T value);
+
+    /*  how many elements there are  */
+    uint32_t Size() const;
+
+    /*  how many elements differ from the base  */
+    size_t GetChangeCount() const;
+
+    /*  index -> value of every element that differs from the base, in no particular order  */
+    std::unordered_map<uint32_t, T> const& GetChanges() const;
+
+    /*  forgets every change, back to the base  */
+    void Revert();
+
+    /*  merges the changes into the base (copying it if it's shared), do this before sharing  */
+    void Flatten();
+};
+
+#endif /* __COWVECTOR__ */
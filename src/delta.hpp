@@ -0,0 +1,47 @@
+#ifndef __DELTA__
+#define __DELTA__
+
+#include <cstdint>
+
+/*
+    One small, reversible change to the game state
+    every change made while playing goes through one of these (see TextBasedGame::Record),
+    which is what the journal writes down and what undo walks backwards through
+
+    "before" and "after" are both kept so a delta can be applied either way:
+    forwards = set the thing to after, backwards = set it to before
+*/
+struct Delta {
+
+    enum class Kind : uint8_t {
+        /*  the player moved - before/after are room ids  */
+        CurrentRoom = 1,
+        /*  an item moved - subject is the item id, before/after are locations (room id, Inventory or Nowhere)  */
+        ItemLocation = 2,
+        /*  an exit was set - subject is the room it leaves from, before/after are targets (None = no exit)  */
+        Exit = 3,
+        /*  an item's Attrs::isFound changed - subject is the item id, before/after are 0/1  */
+        ItemFound = 4,
+        /*
+            a turn went by while playing - before/after are turn numbers, NPCs with schedules are wherever
+            the turn puts them (see TextBasedGame::SetTurn), only recorded if any NPC has a schedule
+        */
+        Turn = 5,
+    };
+
+    /*  item location: in the player's inventory  */
+    static inline constexpr uint32_t Inventory = UINT32_MAX - 1;
+    /*  item location: nowhere at all (used up, like the red key), also "no exit" for Exit deltas  */
+    static inline constexpr uint32_t Nowhere = UINT32_MAX;
+
+    Kind kind;
+    /*  what changed, see Kind  */
+    uint32_t subject;
+    /*  Exit only - the exit's label (see RoomGraph)  */
+    uint32_t label;
+    uint32_t before;
+    uint32_t after;
+
+};
+
+#endif /* __DELTA__ */
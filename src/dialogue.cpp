@@ -0,0 +1,63 @@
+#include "dialogue.hpp"
+
+#include <stdexcept>
+
+#define FMT_HEADER_ONLY
+#include "fmt/core.h"
+
+Dialogue::Dialogue() { }
+
+uint32_t Dialogue::Add(std::vector<Line> const& lines) {
+    if (lines.empty()) {
+        return End;
+    }
+    /* check everything first, so a bad conversation adds nothing */
+    for (size_t i = 0; i < lines.size(); i++) {
+        for (auto &reply : lines[i].replies) {
+            if (reply.next != End && reply.next >= lines.size()) {
+                throw std::invalid_argument(fmt::format("line {}: \"{}\" leads to line {}, there are only {}", i, reply.text, reply.next, lines.size()));
+            }
+        }
+    }
+
+    uint32_t first = static_cast<uint32_t>(nodes.size());
+    for (auto &line : lines) {
+        nodes.push_back(Node { Intern(line.text), static_cast<uint32_t>(edges.size()), static_cast<uint32_t>(line.replies.size()) });
+        for (auto &reply : line.replies) {
+            edges.push_back(Edge { Intern(reply.text), (reply.next == End) ? End : first + reply.next });
+        }
+    }
+    return first;
+}
+
+uint32_t Dialogue::Intern(std::string const& s) {
+    auto [it, added] = textIds.emplace(s, static_cast<uint32_t>(text.size()));
+    if (added) {
+        text.push_back(s);
+    }
+    return it->second;
+}
+
+Dialogue::Node const& Dialogue::GetNode(uint32_t id) const {
+    return nodes[id];
+}
+
+Dialogue::Edge const& Dialogue::GetEdge(Node const& node, uint32_t i) const {
+    return edges[node.firstEdge + i];
+}
+
+std::string const& Dialogue::GetText(uint32_t id) const {
+    return text[id];
+}
+
+size_t Dialogue::GetNodeCount() const {
+    return nodes.size();
+}
+
+size_t Dialogue::GetEdgeCount() const {
+    return edges.size();
+}
+
+size_t Dialogue::GetTextCount() const {
+    return text.size();
+}
@@ -0,0 +1,80 @@
+#ifndef __DIALOGUE__
+#define __DIALOGUE__
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/*
+    Every NPC's conversations, for the whole world, in three flat arrays:
+    - nodes: something an NPC says, and which edges are the player's replies to it
+    - edges: a reply, and the node it leads to (End finishes the conversation)
+    - text: every line said or replied, each different one stored once (interned), nodes and edges hold ids
+
+    A conversation is added all at once (Add), so a node's replies are next to each other in edges,
+    and talking is just indexing: node -> its edges -> the next node, however many NPCs there are.
+*/
+class Dialogue {
+
+    public:
+
+    /*  where a reply leads when it finishes the conversation  */
+    static inline constexpr uint32_t End = UINT32_MAX;
+
+    /*  a reply as it's written - next is the index of a Line in the same conversation, or End  */
+    struct Reply {
+        std::string text;
+        uint32_t next;
+    };
+
+    /*
+        something the NPC says, as it's written - a conversation is a list of these,
+        it starts at the first one, and a line with no replies ends it
+    */
+    struct Line {
+        std::string text;
+        std::vector<Reply> replies;
+    };
+
+    struct Node {
+        uint32_t text;
+        uint32_t firstEdge;
+        uint32_t edgeCount;
+    };
+
+    struct Edge {
+        uint32_t text;
+        uint32_t target;
+    };
+
+    Dialogue();
+
+    /*
+        adds a conversation, returns the id of its first node (End if lines is empty)
+        throws std::invalid_argument if a reply leads to a line that isn't there
+    */
+    uint32_t Add(std::vector<Line> const& lines);
+
+    /*  the id of s in text, adding it if it's new  */
+    uint32_t Intern(std::string const& s);
+
+    Node const& GetNode(uint32_t id) const;
+    /*  the i'th reply to a node  */
+    Edge const& GetEdge(Node const& node, uint32_t i) const;
+    std::string const& GetText(uint32_t id) const;
+
+    size_t GetNodeCount() const;
+    size_t GetEdgeCount() const;
+    size_t GetTextCount() const;
+
+    private:
+
+    std::vector<Node> nodes;
+    std::vector<Edge> edges;
+    std::vector<std::string> text;
+    /*  text -> its id, only used while adding  */
+    std::unordered_map<std::string, uint32_t> textIds;
+};
+
+#endif /* __DIALOGUE__ */
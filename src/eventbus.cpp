@@ -0,0 +1,57 @@
+#include "eventbus.hpp"
+
+EventBus::EventBus() { }
+
+void EventBus::On(Event event, uint32_t subject, Handler handler) {
+    uint32_t rule = static_cast<uint32_t>(handlers.size());
+    handlers.push_back(std::move(handler));
+
+    size_t e = static_cast<size_t>(event);
+    if (subject == AnySubject) {
+        anySubject[e].push_back(rule);
+        return;
+    }
+    auto &rules = bySubject[e];
+    if (subject >= rules.size()) {
+        rules.resize(static_cast<size_t>(subject) + 1);
+    }
+    rules[subject].push_back(rule);
+}
+
+size_t EventBus::Emit(Event event, uint32_t subject, std::string &text) const {
+    size_t e = static_cast<size_t>(event);
+    size_t ran = 0;
+    auto run = [&](std::vector<uint32_t> const& rules) {
+        for (auto rule : rules) {
+            std::string said = handlers[rule](subject);
+            ran++;
+            if (said.empty()) {
+                continue;
+            }
+            if (!text.empty()) {
+                text += '\n';
+            }
+            text += said;
+        }
+    };
+
+    if (subject < bySubject[e].size()) {
+        run(bySubject[e][subject]);
+    }
+    run(anySubject[e]);
+    return ran;
+}
+
+bool EventBus::Has(Event event, uint32_t subject) const {
+    size_t e = static_cast<size_t>(event);
+    return (subject < bySubject[e].size() && !bySubject[e][subject].empty()) || !anySubject[e].empty();
+}
+
+size_t EventBus::GetRuleCount(Event event) const {
+    size_t e = static_cast<size_t>(event);
+    size_t count = anySubject[e].size();
+    for (auto &rules : bySubject[e]) {
+        count += rules.size();
+    }
+    return count;
+}
@@ -0,0 +1,68 @@
+#ifndef __EVENTBUS__
+#define __EVENTBUS__
+
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+/*
+    Rules that react to what the player does - "entering the cellar blows out the candle",
+    "using the red key in the bedroom unlocks the door" - instead of one more lambda inside a command
+
+    A rule is an event, a subject (the room or item it's about) and a handler. Rules are indexed by
+    event and then straight by subject id, so Emit() is two array lookups plus the rules that match,
+    however many rules the world has. Rules for AnySubject run on every subject, after the specific ones.
+
+    Events and their subjects:
+    - OnEnter: a room id, after the player walked into it ("go north", "go to garden")
+    - OnTake/OnDrop: an item id, after the player took/dropped it
+    - OnUse: an item id, "use <item>" (only items with OnUse rules get that command)
+    - OnTick: a room id, after every command typed while playing, wherever the player is then
+
+    Handlers see the session through the game like commands do (Current()), and return text to show
+    after what the command printed itself ("" for nothing). Rules are part of the world: add them
+    during Init, after that they're only read, so any number of sessions can Emit at once.
+*/
+class EventBus {
+
+    public:
+
+    enum class Event : uint32_t { OnEnter, OnTake, OnDrop, OnUse, OnTick };
+    static inline constexpr size_t EventCount = 5;
+
+    /*  subject of rules that run for every subject  */
+    static inline constexpr uint32_t AnySubject = UINT32_MAX;
+
+    /*  gets the subject it ran for, returns what to show  */
+    using Handler = std::function<std::string(uint32_t subject)>;
+
+    EventBus();
+
+    /*  adds a rule, rules for the same event and subject run in the order they were added  */
+    void On(Event event, uint32_t subject, Handler handler);
+
+    /*
+        runs every rule for event on subject (then the AnySubject ones), adding each non-empty
+        result to text on a line of its own, returns how many rules ran
+    */
+    size_t Emit(Event event, uint32_t subject, std::string &text) const;
+
+    /*  whether Emit would run anything  */
+    bool Has(Event event, uint32_t subject) const;
+
+    /*  how many rules there are for an event, any subject  */
+    size_t GetRuleCount(Event event) const;
+
+    private:
+
+    /*  every handler, rule ids index into this  */
+    std::vector<Handler> handlers;
+
+    /*  per event: rule ids by subject id (only as long as the biggest subject with rules), and the AnySubject ones  */
+    std::array<std::vector<std::vector<uint32_t>>, EventCount> bySubject;
+    std::array<std::vector<uint32_t>, EventCount> anySubject;
+};
+
+#endif
@@ -0,0 +1,179 @@
+#include "flow.hpp"
+
+#include <array>
+#include <new>
+#include <utility>
+
+namespace {
+    /*  frames are rounded up to a multiple of this, and each multiple has its own free list  */
+    constexpr size_t BlockSize = 128;
+    /*  frames bigger than BlockSize * SizeClasses just use the heap  */
+    constexpr size_t SizeClasses = 16;
+    /*  blocks kept per free list, more than that go back to the heap (frames freed on another thread pile up there)  */
+    constexpr size_t MaxFree = 64;
+
+    struct FreeList {
+        void *head = nullptr;
+        size_t count = 0;
+
+        ~FreeList() {
+            while (head) {
+                void *next = *static_cast<void**>(head);
+                ::operator delete(head);
+                head = next;
+            }
+        }
+    };
+
+    thread_local std::array<FreeList, SizeClasses> freeLists;
+
+    size_t SizeClass(size_t size) {
+        return (size + BlockSize - 1) / BlockSize - 1;
+    }
+}
+
+void *Flow::promise_type::operator new(size_t size) {
+    size_t c = SizeClass(size);
+    if (c >= SizeClasses) {
+        return ::operator new(size);
+    }
+    auto &list = freeLists[c];
+    if (!list.head) {
+        return ::operator new((c + 1) * BlockSize);
+    }
+    void *frame = list.head;
+    list.head = *static_cast<void**>(frame);
+    list.count--;
+    return frame;
+}
+
+void Flow::promise_type::operator delete(void *frame, size_t size) {
+    size_t c = SizeClass(size);
+    if (c >= SizeClasses || freeLists[c].count >= MaxFree) {
+        ::operator delete(frame);
+        return;
+    }
+    auto &list = freeLists[c];
+    *static_cast<void**>(frame) = list.head;
+    list.head = frame;
+    list.count++;
+}
+
+Flow Flow::promise_type::get_return_object() {
+    return Flow(Handle::from_promise(*this));
+}
+
+void Flow::promise_type::unhandled_exception() {
+    exception = std::current_exception();
+}
+
+std::coroutine_handle<> Flow::promise_type::FinalAwaiter::await_suspend(std::coroutine_handle<promise_type> handle) noexcept {
+    handle.promise().wait = Wait::Nothing;
+    auto parent = handle.promise().parent;
+    if (parent) {
+        return parent;
+    }
+    return std::noop_coroutine();
+}
+
+Flow::NextInput::NextInput(std::vector<std::string> const& _menu) : menu(&_menu), handle(nullptr) { }
+
+void Flow::NextInput::await_suspend(Handle _handle) {
+    handle = _handle;
+    handle.promise().wait = Wait::Input;
+    handle.promise().menu = menu;
+}
+
+std::string Flow::NextInput::await_resume() {
+    auto &promise = handle.promise();
+    promise.wait = Wait::Nothing;
+    promise.menu = nullptr;
+    return std::move(promise.input);
+}
+
+void Flow::KeyPress::await_suspend(Handle _handle) {
+    handle = _handle;
+    handle.promise().wait = Wait::Key;
+}
+
+void Flow::KeyPress::await_resume() {
+    handle.promise().wait = Wait::Nothing;
+}
+
+void Flow::Awaiter::await_suspend(Handle parent) {
+    parent.promise().child = child;
+    child.promise().parent = parent;
+}
+
+void Flow::Awaiter::await_resume() {
+    auto &promise = child.promise();
+    if (promise.parent) {
+        promise.parent.promise().child = nullptr;
+    }
+    if (promise.exception) {
+        std::rethrow_exception(promise.exception);
+    }
+}
+
+Flow::Flow() : handle(nullptr) { }
+
+Flow::Flow(Handle _handle) : handle(_handle) { }
+
+Flow::Flow(Flow&& other) noexcept : handle(std::exchange(other.handle, nullptr)) { }
+
+Flow& Flow::operator=(Flow&& other) noexcept {
+    if (this != &other) {
+        if (handle) {
+            handle.destroy();
+        }
+        handle = std::exchange(other.handle, nullptr);
+    }
+    return *this;
+}
+
+Flow::~Flow() {
+    if (handle) {
+        handle.destroy();
+    }
+}
+
+Flow::Awaiter Flow::operator co_await() && {
+    return Awaiter { handle };
+}
+
+bool Flow::IsWaiting() const {
+    return handle && !handle.done();
+}
+
+Flow::Handle Flow::Innermost() const {
+    Handle h = handle;
+    while (h.promise().child) {
+        h = h.promise().child;
+    }
+    return h;
+}
+
+Flow::Wait Flow::GetWait() const {
+    return IsWaiting() ? Innermost().promise().wait : Wait::Nothing;
+}
+
+std::vector<std::string> const& Flow::GetMenu() const {
+    auto menu = IsWaiting() ? Innermost().promise().menu : nullptr;
+    return menu ? *menu : NoMenu;
+}
+
+void Flow::Resume(std::string input) {
+    if (!IsWaiting()) {
+        return;
+    }
+    Handle h = Innermost();
+    h.promise().input = std::move(input);
+    h.resume();
+    Rethrow();
+}
+
+void Flow::Rethrow() {
+    if (handle && handle.done() && handle.promise().exception) {
+        std::rethrow_exception(std::exchange(handle.promise().exception, nullptr));
+    }
+}
@@ -0,0 +1,135 @@
+#ifndef __FLOW__
+#define __FLOW__
+
+#include <coroutine>
+#include <cstddef>
+#include <exception>
+#include <string>
+#include <vector>
+
+/*
+    An "ask, wait for the answer, carry on" interaction - the exit menu, the pager, talking to an NPC -
+    written as one C++20 coroutine instead of game states that commands switch between, or a loop
+    inside the game loop:
+
+        Flow TextBasedGame::ExitMenu() {
+            Write(Messages::ExitConfirmation);
+            std::string answer = co_await Flow::NextInput(ExitMenuCommands);
+            ...
+        }
+
+    A flow starts running as soon as it's called, up to the first thing it waits for, and is then
+    kept in the session (Session::flow) until it's done. Whoever has what it's waiting for Resume()s it:
+    Eval() hands it the next line typed (NextInput), Run() the next key (KeyPress). A flow can
+    co_await another flow (the pager while talking), which runs inside it - Resume() always goes to
+    the innermost one that's waiting. Anything a flow throws (ExitGameException) comes out of Resume().
+
+    Coroutine frames come from a free list per size kept for each thread, so starting a flow doesn't
+    go to the heap once a flow of that size has run before.
+*/
+class Flow {
+
+    public:
+
+    /*  what a flow is waiting for  */
+    enum class Wait { Nothing, Input, Key };
+
+    /*  menu of a NextInput that doesn't say what can be typed  */
+    static inline const std::vector<std::string> NoMenu;
+
+    struct promise_type {
+        Wait wait = Wait::Nothing;
+        /*  names of the commands that can be typed now (for hints), while waiting for Input  */
+        std::vector<std::string> const *menu = nullptr;
+        /*  the line it was resumed with  */
+        std::string input;
+        std::exception_ptr exception;
+        /*  the flow this one is co_awaiting, and the one co_awaiting this one  */
+        std::coroutine_handle<promise_type> child;
+        std::coroutine_handle<promise_type> parent;
+
+        struct FinalAwaiter {
+            bool await_ready() noexcept { return false; }
+            /*  back to the flow that was co_awaiting this one, if there is one  */
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<promise_type> handle) noexcept;
+            void await_resume() noexcept {}
+        };
+
+        static void *operator new(size_t size);
+        static void operator delete(void *frame, size_t size);
+
+        Flow get_return_object();
+        std::suspend_never initial_suspend() noexcept { return {}; }
+        FinalAwaiter final_suspend() noexcept { return {}; }
+        void return_void() {}
+        void unhandled_exception();
+    };
+
+    using Handle = std::coroutine_handle<promise_type>;
+
+    /*  co_await Flow::NextInput(menu) - the next line the player types, menu has to outlive the wait (a constant)  */
+    struct NextInput {
+        std::vector<std::string> const *menu;
+        Handle handle;
+
+        NextInput(std::vector<std::string> const& _menu = NoMenu);
+        bool await_ready() { return false; }
+        void await_suspend(Handle _handle);
+        std::string await_resume();
+    };
+
+    /*  co_await Flow::KeyPress() - the next key the player hits  */
+    struct KeyPress {
+        Handle handle;
+
+        bool await_ready() { return false; }
+        void await_suspend(Handle _handle);
+        void await_resume();
+    };
+
+    /*  co_await someFlow - runs it to the end inside this one  */
+    struct Awaiter {
+        Handle child;
+
+        bool await_ready() { return child.done(); }
+        void await_suspend(Handle parent);
+        /*  rethrows whatever the child threw  */
+        void await_resume();
+    };
+
+    /*  no flow, IsWaiting() is false  */
+    Flow();
+    Flow(Flow&& other) noexcept;
+    Flow& operator=(Flow&& other) noexcept;
+    Flow(Flow const&) = delete;
+    Flow& operator=(Flow const&) = delete;
+    ~Flow();
+
+    Awaiter operator co_await() &&;
+
+    /*  true from when it starts until it's done  */
+    bool IsWaiting() const;
+
+    /*  what the innermost flow is waiting for, Nothing if it's done  */
+    Wait GetWait() const;
+
+    /*  the menu of the NextInput it's waiting on  */
+    std::vector<std::string> const& GetMenu() const;
+
+    /*  gives the innermost flow what it was waiting for (input is ignored for a KeyPress), rethrows anything it throws  */
+    void Resume(std::string input = "");
+
+    /*  if it's done because it threw, throws that again (a flow can finish before its first co_await)  */
+    void Rethrow();
+
+    private:
+
+    Flow(Handle _handle);
+
+    /*  the flow that's actually suspended - follows child down from the outermost  */
+    Handle Innermost() const;
+
+    Handle handle;
+};
+
+#endif /* __FLOW__ */
@@ -0,0 +1,157 @@
+#ifndef __FRONTEND__
+#define __FRONTEND__
+
+#include <cstdint>
+#include <string>
+
+class Profiler;
+class Timers;
+
+/*
+    Everything TextBasedGame needs from whatever the player is looking at - the game itself
+    never touches a window, a keyboard or a terminal, it only talks to one of these:
+    - Graphics: the raylib window (the real game)
+    - StdioFrontend: plain text on stdin/stdout, for playing in a terminal or piping commands in
+    - NullFrontend: nothing at all, for replaying transcripts and tests
+
+    The game owns its frontend. TextBasedGame::Run() calls Poll() once per frame, then Step() for
+    every fixed simulation step that's come due since (StepRate a second, so animations go as fast
+    whatever the frame rate), then Draw() (SkipFrame() instead while it isn't IsVisible()), and then
+    Sleep()s until the next frame or the next timer, whichever comes first
+*/
+class Frontend {
+    public:
+
+    /*
+        Different text speeds to display textOut at
+        can be set either with s/m/f or 1/2/3
+    */
+    enum class TextSpeed : uint8_t {
+        Slow = 1,
+        Medium = 2,
+        Fast = 3,
+        Default = Medium
+    };
+
+    /*
+        Different cursor styles for the UI
+        names not visible to player, all they get is 1/2/3/4
+        cursor color (or at least color scheme) remains the same
+    */
+    enum class CursorStyle {
+        VerticalBar = 1,
+        Underline = 2,
+        OutlineBox = 3,
+        TransparentBox = 4,
+        Default = VerticalBar
+    };
+
+    /*  what happened during a Poll()  */
+    enum class Event {
+        /*  nothing the game needs to know about (typing is handled by the frontend)  */
+        None,
+        /*  the player hit ENTER - their line is in GetTextIn()  */
+        Enter,
+        /*  any other key, for "press any key" (the pager)  */
+        Key,
+        /*  the window was closed or input ran out, the game should stop  */
+        Close
+    };
+
+    /*
+        how many characters the player can type in their box
+        if len(textIn) = this, then any keyinput besides BACKSPACE will be ignored
+        not including "> " which makes it 65
+    */
+    static inline constexpr int LineInLimit = 63;
+
+    /*
+        how many characters can go on each line of game text
+        not sure about overflow/wrapping (drawing 66 characters)
+        don't try that pls, make sure all messages do not overflow
+    */
+    static inline constexpr int LineOutLimit = 65;
+
+    /*  how many lines of game text there are  */
+    static inline constexpr int LineOutCount = 4;
+
+    /*  simulation steps a second - Step() is called this often, however often frames are drawn  */
+    static inline constexpr int StepRate = 60;
+
+    /*
+        prompt to display before user input, should always be "> "
+        the length is most likely accounted for everywhere (prob no risk of segfault if diff len)
+    */
+    static inline constexpr const char* PlayerPrompt = "> ";
+
+    virtual ~Frontend() = default;
+
+    /*  reads input for one frame (typing, backspace, tab for hints...) and says what happened  */
+    virtual Event Poll() = 0;
+
+    /*  moves anything animated (text scrolling in, the cursor blinking) on by 1 / StepRate seconds  */
+    virtual void Step() {}
+
+    /*  shows one frame  */
+    virtual void Draw() {}
+
+    /*  false when nobody can see frames (the window is hidden), Run() doesn't Draw() then  */
+    virtual bool IsVisible() { return true; }
+
+    /*  called instead of Draw() while it isn't IsVisible(), for whatever a frame has to do besides drawing  */
+    virtual void SkipFrame() {}
+
+    /*  the game's timers, for anything the frontend does on a delay (called once, before Run())  */
+    virtual void SetTimers(Timers *) {}
+
+    /*  the game's profiler, to time drawing with and show when it's on (called once, before Run())  */
+    virtual void SetProfiler(Profiler *) {}
+
+    /*  seconds between frames, 0 if Poll() waits for input by itself (nothing to animate)  */
+    virtual double GetFrameInterval() { return 0; }
+
+    /*  waits (up to) this many seconds, only called if GetFrameInterval() isn't 0  */
+    virtual void Sleep(double) {}
+
+    /*
+        true if someone is there to "press any key" - if not, the pager
+        shows every page straight away instead of waiting
+    */
+    virtual bool WaitsForKeys() = 0;
+
+    /*  what the player has typed  */
+    virtual std::string GetTextIn() = 0;
+
+    /*  is what the player has typed s? (without copying it, unlike GetTextIn)  */
+    virtual bool IsTextIn(std::string const& s) { return GetTextIn() == s; }
+
+    /*  set the player's text to whatever  */
+    virtual void SetTextIn(std::string s) = 0;
+
+    /*  get the current game text on a specific line  */
+    virtual std::string GetTextOut(int line) = 0;
+
+    /*  set the game text on a specific line  */
+    virtual void SetTextOut(std::string s, int line) = 0;
+
+    /*  set the player hint  */
+    virtual void SetHint(std::string) {}
+
+    /*  is all of the game text showing yet (not still scrolling in)?  */
+    virtual bool IsQueueEmpty() { return true; }
+
+    /*  show the rest of the game text on the next frame  */
+    virtual void DumpText() {}
+
+    /*  change the text speed setting  */
+    virtual void ChangeTextSpeed(TextSpeed) {}
+
+    /*  change the cursor style setting  */
+    virtual void ChangeCursorStyle(CursorStyle) {}
+
+    /*  set the current image (a room name)  */
+    virtual void SetBackgroundImage(std::string) {}
+
+};
+
+#endif /* __FRONTEND__ */
@@ -9,26 +9,40 @@
 */
 
 /*
-    Represents a direction the player can move in
+    Represents one of the standard directions the player can move in
+    these are just the exit names every world gets for free - rooms can also be linked
+    with any other exit name (see RoomGraph), like "portal" or "trapdoor"
 */
 enum class Direction {
     North,
     South,
     East,
     West,
+    Up,
+    Down,
+    In,
+    Out,
     Invalid
 };
 
-constexpr inline std::string_view direction_reprs[2][5] = {
-    { "North", "South", "East", "West", "INVALID" },
-    { "north", "south", "east", "west", "invalid" }
+/*  how many standard directions there are (not counting Invalid)  */
+constexpr inline int DirectionCount = static_cast<int>(Direction::Invalid);
+
+constexpr inline std::string_view direction_reprs[2][9] = {
+    /*  indexed by [uppercase][direction]  */
+    { "north", "south", "east", "west", "up", "down", "in", "out", "invalid" },
+    { "North", "South", "East", "West", "Up", "Down", "In", "Out", "INVALID" }
 };
 
-constexpr inline Direction direction_revs[5] = {
+constexpr inline Direction direction_revs[9] = {
     Direction::South,
     Direction::North,
     Direction::West,
     Direction::East,
+    Direction::Down,
+    Direction::Up,
+    Direction::Out,
+    Direction::In,
     Direction::Invalid
 };
 
@@ -37,4 +51,4 @@ std::string DirectionRepr(Direction const &d, bool uppercase);
 /*  the opposite way  */
 Direction DirectionReverse(Direction const &d);
 
-#endif /* __GLOBALS__ */
\ No newline at end of file
+#endif /* __GLOBALS__ */
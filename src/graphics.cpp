@@ -12,7 +12,8 @@ Graphics::Graphics() {
     
     /* only way to exit is by typing exit/q */
     SetExitKey(KEY_NULL);
-    SetTargetFPS(60);
+    /* no frame limit here, TextBasedGame::Run() waits between frames (see GetFrameInterval) */
+    SetTargetFPS(0);
 
     /*
         create all necessary assets
@@ -56,8 +57,16 @@ Graphics::Graphics() {
         std::queue<char>(),
     };
 
+    timers = nullptr;
+    backspaceRepeat = Timers::None;
+    profiler = nullptr;
+    profilerRefreshed = 0;
+    /* longer than any output line (they're wrapped well before this) or anything that fits on the input line */
+    drawText.reserve(256);
+
     /* counts up from 0 */
-    frameCount = 0;
+    stepCount = 0;
+    purgeQueueNextStep = false;
 
     /* default settings */
     textScrollSpeed = TextSpeed::Default;
@@ -111,21 +120,17 @@ void Graphics::NormalizeWindowSize() {
 
 }
 
-void Graphics::Draw() {
-
-    // NormalizeWindowSize();
+void Graphics::Step() {
 
-    bool addCharThisFrame = false;
+    bool addCharThisStep = false;
     
     switch(textScrollSpeed) {
-        case TextSpeed::Slow : addCharThisFrame = (frameCount % 5 == 0); break; 
-        case TextSpeed::Medium : addCharThisFrame = (frameCount % 3 == 0); break; 
-        case TextSpeed::Fast : addCharThisFrame = true; break; 
+        case TextSpeed::Slow : addCharThisStep = (stepCount % 5 == 0); break; 
+        case TextSpeed::Medium : addCharThisStep = (stepCount % 3 == 0); break; 
+        case TextSpeed::Fast : addCharThisStep = true; break; 
     }
 
-    BeginTextureMode(renderTexture);
-    
-    if (purgeQueueNextFrame) {
+    if (purgeQueueNextStep) {
         for (int i = 0; i < Graphics::LineOutCount; i++) {
             while (!textOutScroll.at(i).empty()) {
                 char c = textOutScroll.at(i).front();
@@ -133,8 +138,8 @@ void Graphics::Draw() {
                 textOutScroll.at(i).pop();
             }
         }
-        purgeQueueNextFrame = false;
-    } else if (addCharThisFrame) {
+        purgeQueueNextStep = false;
+    } else if (addCharThisStep) {
         for (int i = 0; i < Graphics::LineOutCount; i++) {
             if (!textOutScroll.at(i).empty()) {
                 char c = textOutScroll.at(i).front();
@@ -145,28 +150,52 @@ void Graphics::Draw() {
         }
     }
 
+    stepCount++;
+}
+
+void Graphics::Draw() {
+
+    // NormalizeWindowSize();
+
+    Profiler *timing = (profiler && profiler->IsOn()) ? profiler : nullptr;
+    /* written over the last report's lines, so once they're long enough refreshing doesn't allocate */
+    if (timing && (profilerLines.empty() || stepCount - profilerRefreshed >= ProfilerRefresh)) {
+        profiler->GetReport(profilerLines);
+        profilerRefreshed = stepCount;
+    }
+    std::optional<Profiler::Scope> scope(std::in_place, timing, Profiler::Phase::Draw);
+    TRACE_SPAN("Graphics::Draw");
+
+    BeginTextureMode(renderTexture);
+
     // bg
     ClearBackground(Color {0x22, 0x22, 0x22, 255});
     // input line bg
     DrawRectangleRec({0, 476, 644, 30}, Color {0x20, 0x20, 0x20, 255});
 
-    // picture
-    DrawTexture(assets.GetTexture(currentImage.c_str()), 2, 24, WHITE);
+    // picture (rooms without one just get the background)
+    if (assets.HasTexture(currentImage.c_str())) {
+        DrawTexture(assets.GetTexture(currentImage.c_str()), 2, 24, WHITE);
+    }
 
     // title - centered
     //DrawTextEx(assets.GetFont("italic"), Graphics::TitleText, {(windowSize.x - MeasureTextEx(assets.GetFont("italic"), Graphics::TitleText, fontSize, fontSpacing).x) / 2, 2}, fontSize, fontSpacing, LIGHTGRAY);
     // title not centered
     DrawTextEx(assets.GetFont("title"), Graphics::TitleText, {4, 2}, Graphics::FontSize, Graphics::FontSpacing, RAYWHITE);
     // output lines
-    DrawTextEx(assets.GetFont("italic"), MakeStr(textOut[0]).c_str(), {6, 388}, Graphics::FontSize, Graphics::FontSpacing, LIGHTGRAY);
-    DrawTextEx(assets.GetFont("italic"), MakeStr(textOut[1]).c_str(), {6, 410}, Graphics::FontSize, Graphics::FontSpacing, LIGHTGRAY);
-    DrawTextEx(assets.GetFont("italic"), MakeStr(textOut[2]).c_str(), {6, 432}, Graphics::FontSize, Graphics::FontSpacing, LIGHTGRAY);
-    DrawTextEx(assets.GetFont("italic"), MakeStr(textOut[3]).c_str(), {6, 454}, Graphics::FontSize, Graphics::FontSpacing, LIGHTGRAY);
+    for (int i = 0; i < Frontend::LineOutCount; i++) {
+        drawText.assign(textOut[i].data(), textOut[i].size());
+        DrawTextEx(assets.GetFont("italic"), drawText.c_str(), {6, 388 + 22.0f * i}, Graphics::FontSize, Graphics::FontSpacing, LIGHTGRAY);
+    }
     // input line
-    DrawTextEx(assets.GetFont("normal"), (Graphics::PlayerPrompt + MakeStr(textIn)).c_str(), Vector2 { 6, 480 }, Graphics::FontSize, Graphics::FontSpacing, RAYWHITE);
+    drawText.assign(Graphics::PlayerPrompt);
+    drawText.append(textIn.begin(), textIn.end());
+    DrawTextEx(assets.GetFont("normal"), drawText.c_str(), Vector2 { 6, 480 }, Graphics::FontSize, Graphics::FontSpacing, RAYWHITE);
 
     // hint
-    DrawTextEx(assets.GetFont("normal"), (std::string(textIn.size() + 2, ' ') + textInHint).c_str(), Vector2 { 6, 480 }, Graphics::FontSize, Graphics::FontSpacing, LIGHTGRAY);
+    drawText.assign(textIn.size() + 2, ' ');
+    drawText.append(textInHint);
+    DrawTextEx(assets.GetFont("normal"), drawText.c_str(), Vector2 { 6, 480 }, Graphics::FontSize, Graphics::FontSpacing, LIGHTGRAY);
 
     // title border
     DrawRectangleLinesEx(Rectangle {0, 0, 644, 24}, Graphics::FrameThick, Graphics::FrameColor);
@@ -178,8 +207,12 @@ void Graphics::Draw() {
     DrawLineEx({0, 480}, {644, 480}, Graphics::FrameThick, Graphics::FrameColor);
     
     DrawCursor();
+    if (timing) {
+        DrawProfiler();
+    }
     EndTextureMode();
-    
+
+    scope.emplace(timing, Profiler::Phase::Blit);
     BeginDrawing();
     
     // negative width to flip it
@@ -196,18 +229,18 @@ void Graphics::Draw() {
         WHITE
     );
     EndDrawing();
-
-    frameCount++;
 }
 
 void Graphics::DrawCursor() {
     
     // cursor blink
-    if (frameCount % 60 > 30) {
+    if (stepCount % 60 > 30) {
         return;
     }
 
-    Vector2 textSize = MeasureTextEx(assets.GetFont("normal"), (Graphics::PlayerPrompt + MakeStr(textIn)).c_str(), Graphics::FontSize, Graphics::FontSpacing);
+    drawText.assign(Graphics::PlayerPrompt);
+    drawText.append(textIn.begin(), textIn.end());
+    Vector2 textSize = MeasureTextEx(assets.GetFont("normal"), drawText.c_str(), Graphics::FontSize, Graphics::FontSpacing);
     Vector2 singleCharSize = MeasureTextEx(assets.GetFont("normal"), " ", Graphics::FontSize, Graphics::FontSpacing);
     
     switch(cursorStyle) {
@@ -219,7 +252,7 @@ void Graphics::DrawCursor() {
         }
         case CursorStyle::Underline: {
             if (textIn.size() == Graphics::LineInLimit) {
-                textSize = MeasureTextEx(assets.GetFont("normal"), (Graphics::PlayerPrompt + MakeStr(textIn)).c_str(), Graphics::FontSize, Graphics::FontSpacing);
+                textSize = MeasureTextEx(assets.GetFont("normal"), drawText.c_str(), Graphics::FontSize, Graphics::FontSpacing);
             }
             float x = textSize.x + 7;
             float y = textSize.y + 480;
@@ -228,7 +261,7 @@ void Graphics::DrawCursor() {
         }
         case CursorStyle::OutlineBox: {
             if (textIn.size() == Graphics::LineInLimit) {
-                textSize = MeasureTextEx(assets.GetFont("normal"), (Graphics::PlayerPrompt + MakeStr(textIn)).c_str(), Graphics::FontSize, Graphics::FontSpacing);
+                textSize = MeasureTextEx(assets.GetFont("normal"), drawText.c_str(), Graphics::FontSize, Graphics::FontSpacing);
             }
             float x = textSize.x + 7;
             float y = textSize.y + 480;
@@ -237,7 +270,7 @@ void Graphics::DrawCursor() {
         }
         case CursorStyle::TransparentBox: {
             if (textIn.size() == Graphics::LineInLimit) {
-                textSize = MeasureTextEx(assets.GetFont("normal"), (Graphics::PlayerPrompt + MakeStr(textIn)).c_str(), Graphics::FontSize, Graphics::FontSpacing);
+                textSize = MeasureTextEx(assets.GetFont("normal"), drawText.c_str(), Graphics::FontSize, Graphics::FontSpacing);
             }
             float x = textSize.x + 7;
             float y = textSize.y + 480;
@@ -263,6 +296,8 @@ void Graphics::SetTextIn(std::string str) {
 void Graphics::SetTextOut(std::string str, int line) {
     textOutScroll.at(line) = std::queue<char>();
     textOut[line].clear();
+    /* room for the whole line now, so it doesn't grow a character at a time while it scrolls in */
+    textOut[line].reserve(str.size());
     //std::string s(str);
     //textOut[line] = std::vector<char>(s.begin(), s.end());
     for (char c : str) {
@@ -274,6 +309,10 @@ void Graphics::SetHint(std::string s) {
     textInHint = s;
 }
 
+bool Graphics::IsTextIn(std::string const& s) {
+    return std::equal(textIn.begin(), textIn.end(), s.begin(), s.end());
+}
+
 void Graphics::AddHintToInput() {
     for (char c : textInHint) {
         textIn.push_back(c);
@@ -311,9 +350,86 @@ bool Graphics::IsQueueEmpty() {
 }
 
 void Graphics::DumpText() {
-    purgeQueueNextFrame = true;
+    purgeQueueNextStep = true;
 }
 
 void Graphics::SetBackgroundImage(std::string newImageName) {
     currentImage = newImageName;
 }
+
+Frontend::Event Graphics::Poll() {
+    if (WindowShouldClose()) {
+        return Event::Close;
+    }
+
+    /*  Get char pressed (unicode character) on the queue  */
+    int key = GetCharPressed();
+
+    /*  Check if more characters have been pressed on the same frame  */
+    while (key > 0) {
+        /*  NOTE: Only allow keys in range [32..125]  */
+        if ((key >= 32) && (key <= 125)) {
+            AddCharIn((char) key);
+        }
+        /*  Check next character in the queue  */
+        key = GetCharPressed();
+    }
+
+    Event event = (GetKeyPressed() != KEY_NULL) ? Event::Key : Event::None;
+
+    if (backspaceRepeat != Timers::None && !IsKeyDown(KEY_BACKSPACE)) {
+        timers->Cancel(backspaceRepeat);
+        backspaceRepeat = Timers::None;
+    }
+
+    if (IsKeyPressed(KEY_BACKSPACE)) {
+        DelCharIn();
+        if (timers && backspaceRepeat == Timers::None) {
+            backspaceRepeat = timers->Every(BackspaceRepeat, [this]{ DelCharIn(); });
+        }
+    } else if (IsKeyPressed(KEY_ENTER)) {
+        event = Event::Enter;
+    } else if (IsKeyPressed(KEY_TAB)) {
+        /*  also clears hint  */
+        AddHintToInput();
+    }
+    return event;
+}
+
+bool Graphics::WaitsForKeys() {
+    return true;
+}
+
+void Graphics::SetTimers(Timers *_timers) {
+    timers = _timers;
+}
+
+void Graphics::SetProfiler(Profiler *_profiler) {
+    profiler = _profiler;
+}
+
+void Graphics::DrawProfiler() {
+    float height = 18.0f * profilerLines.size() + 4;
+    DrawRectangleRec({4, 26, 420, height}, Color {0, 0, 0, 180});
+    for (size_t i = 0; i < profilerLines.size(); i++) {
+        DrawTextEx(assets.GetFont("normal"), profilerLines[i].c_str(), {8, 28 + 18.0f * i}, 16, Graphics::FontSpacing, GREEN);
+    }
+}
+
+double Graphics::GetFrameInterval() {
+    int refreshRate = GetMonitorRefreshRate(GetCurrentMonitor());
+    return 1.0 / ((refreshRate > 0) ? refreshRate : TargetFPS);
+}
+
+bool Graphics::IsVisible() {
+    return !IsWindowHidden() && !IsWindowMinimized();
+}
+
+void Graphics::SkipFrame() {
+    PollInputEvents();
+}
+
+void Graphics::Sleep(double seconds) {
+    /* raylib 4.1 takes milliseconds */
+    WaitTime(static_cast<float>(seconds * 1000));
+}
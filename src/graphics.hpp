@@ -1,7 +1,9 @@
 #ifndef __GRAPHICS__
 #define __GRAPHICS__
 
+#include <algorithm>
 #include <iostream>
+#include <optional>
 #include <queue>
 #include <string>
 #include <vector>
@@ -10,6 +12,10 @@
 #include "fmt/core.h"
 
 #include "assetmanager.hpp"
+#include "frontend.hpp"
+#include "profiler.hpp"
+#include "timer.hpp"
+#include "trace.hpp"
 
 /*
     Handles drawing everything to the screen, events, graphics management, specifically:
@@ -19,37 +25,14 @@
     - Text scrolling (idk what to call it, uses the queue)
     - "Dumping" the rest of the queue onto the screen when the user hits ENTER
     - Displaying hints, and autofilling them if/when user hits TAB
+    - Reading the keyboard (typing, backspace, tab) - see Poll()
 
     - Rescaling window to match resolution (in future)
     Only one of these will be running at a time, so static stuff is ok (static local vars and such)
 */
-class Graphics {
+class Graphics : public Frontend {
     public:
 
-    /*
-        Different text speeds to display textOut at
-        can be set either with s/m/f or 1/2/3
-    */
-    enum class TextSpeed : uint8_t {
-        Slow = 1,
-        Medium = 2,
-        Fast = 3,
-        Default = Medium
-    };
-
-    /*
-        Different cursor styles for the UI
-        names not visible to player, all they get is 1/2/3/4
-        cursor color (or at least color scheme) remains the same
-    */
-    enum class CursorStyle {
-        VerticalBar = 1,
-        Underline = 2,
-        OutlineBox = 3,
-        TransparentBox = 4,
-        Default = VerticalBar
-    };
-
     /*
         Arbitrarily chosen resolution types
     */
@@ -91,16 +74,19 @@ class Graphics {
     /*  manages text scrolling, 4 lines  */
     std::vector<std::queue<char>> textOutScroll;
     
-    /*  used to control scroll speed of text and cursor blink, and anything else later that is done every n frames  */
-    int frameCount;
+    /*
+        how many simulation steps have run (see Step) - controls scroll speed of text and cursor blink,
+        and anything else later that is done every n steps, so they go as fast at any frame rate
+    */
+    int stepCount;
     
-    /*  if true, dump the rest of the queue next frame (happens when user hits ENTER while queue is not empty)  */
-    bool purgeQueueNextFrame;
+    /*  if true, dump the rest of the queue next step (happens when user hits ENTER while queue is not empty)  */
+    bool purgeQueueNextStep;
     
     /*
-        1 -> 1 char every 6 frames (S or slow)
-        2 -> 2 char every 6 frames (M or med)
-        3 -> 3 char every 6 frames (F or fast)
+        1 -> 1 char every 5 steps (S or slow)
+        2 -> 1 char every 3 steps (M or med)
+        3 -> 1 char every step (F or fast)
     */
     TextSpeed textScrollSpeed;
     
@@ -112,6 +98,20 @@ class Graphics {
     */
     CursorStyle cursorStyle;
 
+    /*  the game's timers (see SetTimers)  */
+    Timers *timers;
+
+    /*  repeats backspace while it's held down, Timers::None when it isn't  */
+    Timers::Handle backspaceRepeat;
+
+    /*  the game's profiler (see SetProfiler), and its report as last drawn - refreshed every ProfilerRefresh steps so it's readable  */
+    Profiler *profiler;
+    std::vector<std::string> profilerLines;
+    int profilerRefreshed;
+
+    /*  the line Draw() is drawing, kept between frames so drawing text doesn't allocate  */
+    std::string drawText;
+
     public:
 
     /*
@@ -120,37 +120,23 @@ class Graphics {
     */
     static inline constexpr const char* TitleText = "Textbasedgame";
     
-    /*
-        prompt to display before user input, should always be "> "
-        the length is most likely accounted for everywhere (prob no risk of segfault if diff len)
-    */
-    static inline constexpr const char* PlayerPrompt = "> ";
-
     /*  default and initial window width  */
     static inline constexpr int DefaultWinWidth = 644;
 
     /*  default and initial window height  */
     static inline constexpr int DefaultWinHeight = 506;
 
-    /*
-        how many characters the player can type in their box
-        if len(textIn) = this, then any keyinput besides BACKSPACE will be ignored
-        not including "> " which makes it 65
-    */
-    static inline constexpr int LineInLimit = 63;
+    /*  the color of the frame/border  */
+    static inline constexpr Color FrameColor = Color {0xAA, 0xAA, 0xAA, 255};
 
-    /*
-        how many characters can go on each line of game text
-        not sure about overflow/wrapping (drawing 66 characters)
-        don't try that pls, make sure all messages do not overflow
-    */
-    static inline constexpr int LineOutLimit = 65;
+    /*  frames per second Run() paces the window to if the monitor doesn't say its refresh rate  */
+    static inline constexpr int TargetFPS = 60;
 
-    /*  how many lines of game text there are  */
-    static inline constexpr int LineOutCount = 4;
+    /*  steps between refreshes of the profiler overlay  */
+    static inline constexpr int ProfilerRefresh = 30;
 
-    /*  the color of the frame/border  */
-    static inline constexpr Color FrameColor = Color {0xAA, 0xAA, 0xAA, 255};
+    /*  seconds between backspaces while it's held down  */
+    static inline constexpr double BackspaceRepeat = 0.1;
 
     /*  the line thickness of the frame/border  */
     static inline constexpr int FrameThick = 2;
@@ -189,7 +175,7 @@ class Graphics {
         Everything else is taken care of by assetmanager destructor tbh
 
     */
-    ~Graphics();
+    ~Graphics() override;
 
     /*
         Currently unused (and useless)
@@ -199,9 +185,14 @@ class Graphics {
     void NormalizeWindowSize();
 
     /*
-        draws everything to the screen, and some other stuff, including:
+        one simulation step (Frontend::StepRate a second, however often frames are drawn):
         - text scrolling/purge queue
-        - counts frames (just adds 1 each time to the counter)
+        - counts steps (just adds 1 each time to the counter)
+    */
+    void Step() override;
+
+    /*
+        draws everything to the screen:
         - background
         - current texture
         - all 5 lines of text
@@ -211,11 +202,42 @@ class Graphics {
         future additions:
         - normalize window size + scaling render texture
     */
-    void Draw();
+    void Draw() override;
+
+    /*
+        reads the keyboard for this frame:
+        - chars typed go into textIn, BACKSPACE deletes (repeats on a timer while held), TAB adds the hint
+        - Enter if ENTER was hit, Key for any other key, Close if the window is closing
+    */
+    Event Poll() override;
+
+    /*  always true, there's a player at the keyboard  */
+    bool WaitsForKeys() override;
+
+    /*  keeps the game's timers, for backspace repeating  */
+    void SetTimers(Timers *_timers) override;
+
+    /*  keeps the game's profiler, to time Draw with and draw the overlay while it's on  */
+    void SetProfiler(Profiler *_profiler) override;
+
+    /*  draws the profiler's report over the picture  */
+    void DrawProfiler();
+
+    /*  one frame per refresh of the monitor the window is on (1 / TargetFPS if it doesn't say)  */
+    double GetFrameInterval() override;
+
+    /*  false while the window is hidden or minimized  */
+    bool IsVisible() override;
+
+    /*  reads the keyboard and window events, which EndDrawing() does when a frame is drawn  */
+    void SkipFrame() override;
+
+    /*  raylib's WaitTime - the window doesn't pace itself, Run() does  */
+    void Sleep(double seconds) override;
 
     /*
         draws the cursor
-        blinking is done with frameCount
+        blinking is done with stepCount
         automatically updates based on the current cursor style
     */
     void DrawCursor();
@@ -224,19 +246,21 @@ class Graphics {
         returns what the player has typed
         TBG calls this method when ENTER is pressed
     */
-    std::string GetTextIn();
+    std::string GetTextIn() override;
     
     /*  get the current game text on a specific line  */
-    std::string GetTextOut(int line);
+    std::string GetTextOut(int line) override;
     
     /*  set the player's text to whatever  */
-    void SetTextIn(std::string s);
+    void SetTextIn(std::string s) override;
 
     /*  set the game text on a specific line  */
-    void SetTextOut(std::string s, int line);
+    void SetTextOut(std::string s, int line) override;
 
     /*  set the player hint  */
-    void SetHint(std::string s);
+    void SetHint(std::string s) override;
+
+    bool IsTextIn(std::string const& s) override;
     
     /*
         append the rest of the hint to the player input, and clear the hint
@@ -252,27 +276,27 @@ class Graphics {
     void DelCharIn();
     
     /*  change the text speed setting  */
-    void ChangeTextSpeed(TextSpeed newSpeed);
+    void ChangeTextSpeed(TextSpeed newSpeed) override;
     
     /*  change the cursor style setting  */
-    void ChangeCursorStyle(CursorStyle newStyle);
+    void ChangeCursorStyle(CursorStyle newStyle) override;
 
     /*
         is the text scroll queue empty?
         used to check if queue should be purged when user hits ENTER
     */
-    bool IsQueueEmpty();
+    bool IsQueueEmpty() override;
 
     /*
         on the next frame after this is called, purge the text scroll queue
         - see above
     */
-    void DumpText();
+    void DumpText() override;
 
     /*
         set the current image (parameter is whatever the image name is within assetmanager)
     */
-    void SetBackgroundImage(std::string newImageName);
+    void SetBackgroundImage(std::string newImageName) override;
 
 };
 
@@ -68,7 +68,7 @@ class Item {
     std::unordered_map<Message, std::string> messages;
     /* any special commands passed in, anything besides take and drop */
     std::vector<Command> specialCmds;
-    /* the item attrs - see above */
+    /* the item attrs - see above (what every player starts with, each one's are in TextBasedGame::Session) */
     Item::Attrs itemAttrs;
     /* the item flags - see above */
     Item::Flags itemFlags;
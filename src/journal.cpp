@@ -0,0 +1,279 @@
+#include "journal.hpp"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cerrno>
+
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+#include <vector>
+
+namespace {
+    /*  record kind that ends a command  */
+    constexpr uint8_t CommitKind = 0;
+
+    /*  FNV-1a, what ends every command  */
+    uint32_t Checksum(uint8_t const *data, size_t size) {
+        uint32_t h = 0x811C9DC5u;
+        for (size_t i = 0; i < size; i++) {
+            h = (h ^ data[i]) * 0x01000193u;
+        }
+        return h;
+    }
+
+    /*  writes all of data, going again after short writes and signals, false on any other error  */
+    bool WriteAll(int fd, uint8_t const *data, size_t size) {
+        size_t done = 0;
+        while (done < size) {
+            ssize_t n = ::write(fd, data + done, size - done);
+            if (n < 0 && errno == EINTR) {
+                continue;
+            }
+            if (n <= 0) {
+                return false;
+            }
+            done += n;
+        }
+        return true;
+    }
+
+    /*  fsync, going again after signals  */
+    bool Sync(int fd) {
+        int result;
+        do {
+            result = ::fsync(fd);
+        } while (result < 0 && errno == EINTR);
+        return result == 0;
+    }
+}
+
+Journal::Journal(std::string _path) {
+    path = _path;
+    fd = -1;
+    fileSize = 0;
+    batchCommands = 0;
+    failed = false;
+}
+
+Journal::~Journal() {
+    Flush();
+    if (fd >= 0) {
+        ::close(fd);
+    }
+}
+
+bool Journal::Reset(uint64_t worldFingerprint) {
+    if (fd >= 0) {
+        ::close(fd);
+    }
+    current.Clear();
+    batch.Clear();
+    batchCommands = 0;
+    failed = false;
+
+    fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        return false;
+    }
+
+    ByteWriter header;
+    header.Raw(Magic, sizeof(Magic));
+    header.U16(Version);
+    header.U64(worldFingerprint);
+    auto &bytes = header.GetBytes();
+    fileSize = 0;
+    if (!WriteAll(fd, bytes.data(), bytes.size()) || !Sync(fd)) {
+        ::close(fd);
+        fd = -1;
+        return false;
+    }
+    fileSize = bytes.size();
+    return true;
+}
+
+void Journal::Append(Delta const& delta, std::string_view exitName) {
+    current.U8(static_cast<uint8_t>(delta.kind));
+    switch (delta.kind) {
+        case Delta::Kind::CurrentRoom: {
+            current.Var(delta.after);
+            break;
+        }
+        case Delta::Kind::ItemLocation: {
+            current.Var(delta.subject);
+            current.Var(delta.after);
+            break;
+        }
+        case Delta::Kind::Exit: {
+            current.Var(delta.subject);
+            current.Str(exitName);
+            current.Var(delta.after);
+            break;
+        }
+        case Delta::Kind::ItemFound: {
+            current.Var(delta.subject);
+            current.U8(static_cast<uint8_t>(delta.after));
+            break;
+        }
+        case Delta::Kind::Turn: {
+            current.Var(delta.after);
+            break;
+        }
+    }
+}
+
+bool Journal::Commit() {
+    if (current.GetBytes().empty()) {
+        return true;
+    }
+    uint32_t checksum = Checksum(current.GetBytes().data(), current.GetBytes().size());
+    current.U8(CommitKind);
+    current.U32(checksum);
+    auto &bytes = current.GetBytes();
+    batch.Raw(bytes.data(), bytes.size());
+    current.Clear();
+
+    if (batchCommands++ == 0) {
+        batchStart = std::chrono::steady_clock::now();
+    }
+    /* after a failed write, only Poll() tries again (so not on every command) */
+    if (batchCommands >= BatchSize && !failed) {
+        return Flush();
+    }
+    return true;
+}
+
+bool Journal::Poll() {
+    if (batchCommands > 0 && std::chrono::steady_clock::now() - batchStart >= std::chrono::duration<double>(MaxDelay)) {
+        return Flush();
+    }
+    return true;
+}
+
+double Journal::GetFlushDelay() {
+    if (batchCommands == 0) {
+        return -1;
+    }
+    double waited = std::chrono::duration<double>(std::chrono::steady_clock::now() - batchStart).count();
+    return std::max(MaxDelay - waited, 0.0);
+}
+
+bool Journal::Flush() {
+    auto &bytes = batch.GetBytes();
+    if (bytes.empty()) {
+        return true;
+    }
+    if (fd < 0) {
+        failed = true;
+        batchStart = std::chrono::steady_clock::now();
+        return false;
+    }
+    if (!WriteAll(fd, bytes.data(), bytes.size()) || !Sync(fd)) {
+        /*
+            cut off whatever part of the batch made it, so the next one doesn't land after half a record,
+            and keep the batch to try again once MaxDelay has gone by
+        */
+        if (::ftruncate(fd, static_cast<off_t>(fileSize)) != 0 || ::lseek(fd, static_cast<off_t>(fileSize), SEEK_SET) < 0) {
+            /* can't even put the file back - stop appending to it, the next compaction starts a new one */
+            ::close(fd);
+            fd = -1;
+        }
+        failed = true;
+        batchStart = std::chrono::steady_clock::now();
+        return false;
+    }
+    fileSize += bytes.size();
+    batch.Clear();
+    batchCommands = 0;
+    failed = false;
+    return true;
+}
+
+uint64_t Journal::GetFileSize() {
+    return fileSize;
+}
+
+bool Journal::Replay(std::string const& path, uint64_t worldFingerprint, uint32_t roomCount, uint32_t itemCount, ApplyFn const& apply, bool& complete) {
+    complete = false;
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        return false;
+    }
+    std::vector<uint8_t> bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    ByteReader in(bytes);
+
+    try {
+        char magic[sizeof(Magic)];
+        in.Raw(magic, sizeof(magic));
+        if (!std::equal(std::begin(magic), std::end(magic), std::begin(Magic)) || in.U16() != Version || in.U64() != worldFingerprint) {
+            return false;
+        }
+    } catch (FormatError &e) {
+        return false;
+    }
+
+    /* a room id, or Nowhere (no exit / used up), or Inventory where that's somewhere an item can be */
+    auto place = [&](uint64_t value, bool inventory) {
+        if (value >= roomCount && value != Delta::Nowhere && !(inventory && value == Delta::Inventory)) {
+            throw FormatError("journal names a room that doesn't exist");
+        }
+        return static_cast<uint32_t>(value);
+    };
+
+    /* parse and check a whole command before applying any of it */
+    std::vector<std::pair<Delta, std::string>> command;
+    size_t commandStart = bytes.size() - in.Remaining();
+    try {
+        while (!in.AtEnd()) {
+            uint8_t kind = in.U8();
+            if (kind == CommitKind) {
+                size_t commandEnd = bytes.size() - in.Remaining() - 1;
+                if (in.U32() != Checksum(bytes.data() + commandStart, commandEnd - commandStart)) {
+                    throw FormatError("journal command checksum mismatch");
+                }
+                for (auto& [delta, exitName] : command) {
+                    apply(delta, exitName);
+                }
+                command.clear();
+                commandStart = bytes.size() - in.Remaining();
+                continue;
+            }
+
+            Delta delta { static_cast<Delta::Kind>(kind), 0, 0, Delta::Nowhere, Delta::Nowhere };
+            std::string exitName;
+            switch (delta.kind) {
+                case Delta::Kind::CurrentRoom: {
+                    delta.after = in.Index(roomCount);
+                    break;
+                }
+                case Delta::Kind::ItemLocation: {
+                    delta.subject = in.Index(itemCount);
+                    delta.after = place(in.Var(), true);
+                    break;
+                }
+                case Delta::Kind::Exit: {
+                    delta.subject = in.Index(roomCount);
+                    exitName = in.Str();
+                    delta.after = place(in.Var(), false);
+                    break;
+                }
+                case Delta::Kind::ItemFound: {
+                    delta.subject = in.Index(itemCount);
+                    delta.after = in.U8();
+                    break;
+                }
+                case Delta::Kind::Turn: {
+                    delta.after = static_cast<uint32_t>(in.Var());
+                    break;
+                }
+                default: throw FormatError("unknown journal record");
+            }
+            command.emplace_back(delta, exitName);
+        }
+        complete = command.empty();
+    } catch (FormatError &e) {
+        /* half written or damaged - everything before it has already been applied, none of it or after it is */
+    }
+    return true;
+}
@@ -0,0 +1,126 @@
+#ifndef __JOURNAL__
+#define __JOURNAL__
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+
+#include "delta.hpp"
+#include "serial.hpp"
+
+/*
+    Append-only autosave journal - every Delta made while playing gets written here,
+    so autosaving costs as much as what actually changed instead of a whole snapshot
+
+    Deltas are buffered in memory and grouped per command by Commit(). Groups are written and
+    fsynced in batches (every BatchSize commands, or MaxDelay seconds after the oldest unwritten one),
+    and on destruction. Replay() only applies whole groups, so a crash halfway through writing
+    one just loses that command.
+
+    Every delta is replayed as "set X to after", which makes replaying the same group twice harmless -
+    handy if the game dies between writing a fresh snapshot and truncating the journal.
+
+    Each command ends with a checksum of its records, and Replay() checks every id against the world,
+    so a damaged command stops the replay there instead of being applied.
+
+    Format (version 2), Var = LEB128 number:
+        "TBGJ"  version:U16  worldFingerprint:U64
+        records:  kind:U8 ...
+            CurrentRoom   after:Var
+            ItemLocation  item:Var  after:Var
+            Exit          from:Var  exitName:Str  after:Var
+            ItemFound     item:Var  after:U8
+            Commit        checksum:U32  (end of a command, kind 0, FNV-1a of the command's records)
+*/
+class Journal {
+
+    public:
+
+    /*  what Replay() hands back for every delta, with the exit name for Exit deltas (labels aren't stable across runs)  */
+    using ApplyFn = std::function<void(Delta const&, std::string const&)>;
+
+    /*  first 4 bytes of every journal  */
+    static inline constexpr char Magic[4] = { 'T', 'B', 'G', 'J' };
+
+    /*  bump when the format changes  */
+    static inline constexpr uint16_t Version = 2;
+
+    /*  write + fsync after this many commands  */
+    static inline constexpr int BatchSize = 16;
+
+    /*  ... or once the oldest unwritten command is this old (seconds)  */
+    static inline constexpr double MaxDelay = 2.0;
+
+    private:
+
+    /*  the file being appended to  */
+    std::string path;
+    /*  POSIX file descriptor, -1 if not open  */
+    int fd;
+    /*  bytes written to the file so far, including the header  */
+    uint64_t fileSize;
+
+    /*  deltas of the command currently running  */
+    ByteWriter current;
+    /*  whole commands waiting to be written  */
+    ByteWriter batch;
+    /*  how many commands are in batch  */
+    int batchCommands;
+    /*  when the oldest command in batch was committed (or the last failed Flush)  */
+    std::chrono::steady_clock::time_point batchStart;
+    /*  the last Flush() failed - Commit() leaves trying again to Poll()  */
+    bool failed;
+
+    public:
+
+    /*  Journal constructor - doesn't touch the file until Reset()  */
+    Journal(std::string _path);
+
+    /*  Journal destructor - writes anything still buffered and closes the file  */
+    ~Journal();
+
+    Journal(Journal const&) = delete;
+    Journal& operator=(Journal const&) = delete;
+
+    /*
+        starts the journal over - truncates the file and writes a fresh header
+        returns false if the file can't be opened (autosave then just does nothing)
+    */
+    bool Reset(uint64_t worldFingerprint);
+
+    /*  adds a delta to the current command, exitName is only used for Exit deltas  */
+    void Append(Delta const& delta, std::string_view exitName = {});
+
+    /*  ends the current command - does nothing if it didn't change anything, false if it filled the batch and Flush() failed  */
+    bool Commit();
+
+    /*  writes the batch if it's been waiting longer than MaxDelay, false if Flush() failed  */
+    bool Poll();
+
+    /*  seconds until Poll() would write the batch (0 if it would now), -1 if nothing's waiting  */
+    double GetFlushDelay();
+
+    /*
+        writes and fsyncs everything committed so far (retrying interrupted writes)
+        on an error, truncates the file back to the last complete batch, keeps the batch to try again
+        after MaxDelay, and returns false
+    */
+    bool Flush();
+
+    /*  bytes in the file so far (what compaction looks at)  */
+    uint64_t GetFileSize();
+
+    /*
+        reads the journal at path and calls apply on every delta of every complete command
+        returns false if there's no journal, or it was written for a different world
+
+        stops at the first command that's half written, fails its checksum, or names a room or item
+        outside roomCount/itemCount (Inventory and Nowhere aside) - complete says whether it got to the end
+    */
+    static bool Replay(std::string const& path, uint64_t worldFingerprint, uint32_t roomCount, uint32_t itemCount, ApplyFn const& apply, bool& complete);
+
+};
+
+#endif /* __JOURNAL__ */
@@ -1,5 +1,17 @@
+#include <charconv>
+#include <chrono>
+#include <csignal>
+#include <thread>
+
 #include "raylib/raylib.h"
+#include "bench.hpp"
+#include "graphics.hpp"
+#include "nullfrontend.hpp"
+#include "server.hpp"
+#include "solver.hpp"
+#include "stdiofrontend.hpp"
 #include "textbasedgame.hpp"
+#include "validator.hpp"
 
 /*
     TODO:
@@ -9,7 +21,6 @@
     - make branches for
         - more lines of text
         - graphics scaling
-        - implementing NPCs
     in that order
 
     - other small changes
@@ -19,8 +30,555 @@
     - inv starts empty - keep it that way
 */
 
-int main() {
+/*
+    the whole of val as a number from min to max - anything else (not a number, "-1" for an unsigned one,
+    trailing junk, out of range) throws invalid_argument saying what opt takes
+*/
+template<class T>
+T ParseWorldValue(std::string const& opt, std::string const& val, T min, T max) {
+    T value {};
+    auto [end, error] = std::from_chars(val.data(), val.data() + val.size(), value);
+    /* written so NaN fails too */
+    if (error != std::errc() || end != val.data() + val.size() || !(value >= min && value <= max)) {
+        throw std::invalid_argument(fmt::format("{} takes a number from {} to {}, not \"{}\"", opt, min, max, val));
+    }
+    return value;
+}
+
+/*
+    startup options - any --world-* option swaps the built-in world for a generated one
+    (see WorldGen::Config for what they mean):
+    --world-seed <n>  --world-rooms <n>  --world-items <n>  --world-branching <x>  --world-locked <n>  --world-npcs <n>
+    returns false if there were none, other options are ignored
+    throws invalid_argument for an unknown --world-* option, a missing value or one that's out of range (WorldGen's limits)
+*/
+bool ParseWorldOptions(std::vector<std::string> const& args, WorldGen::Config &config) {
+    bool any = false;
+    for (size_t i = 0; i < args.size(); i++) {
+        std::string const& opt = args[i];
+        if (opt.rfind("--world-", 0) != 0) {
+            continue;
+        }
+        if (i + 1 >= args.size()) {
+            throw std::invalid_argument(fmt::format("{} needs a value", opt));
+        }
+        std::string const& val = args[++i];
+        if (opt == "--world-seed") {
+            config.seed = ParseWorldValue<uint64_t>(opt, val, 0, UINT64_MAX);
+        } else if (opt == "--world-rooms") {
+            config.roomCount = ParseWorldValue<uint32_t>(opt, val, 1, WorldGen::MaxRooms);
+        } else if (opt == "--world-items") {
+            config.itemCount = ParseWorldValue<uint32_t>(opt, val, 0, WorldGen::MaxItems);
+        } else if (opt == "--world-branching") {
+            config.branching = ParseWorldValue<float>(opt, val, 0, WorldGen::MaxBranching);
+        } else if (opt == "--world-locked") {
+            config.lockedDoors = ParseWorldValue<uint32_t>(opt, val, 0, UINT32_MAX);
+        } else if (opt == "--world-npcs") {
+            config.npcCount = ParseWorldValue<uint32_t>(opt, val, 0, WorldGen::MaxNPCs);
+        } else {
+            throw std::invalid_argument(fmt::format("unknown option {}", opt));
+        }
+        any = true;
+    }
+    return any;
+}
+
+/*  the --world-* options that make this world again, for transcripts  */
+std::string WorldOptions(WorldGen::Config const& config) {
+    return fmt::format("--world-seed {} --world-rooms {} --world-items {} --world-branching {} --world-locked {} --world-npcs {}",
+        config.seed, config.roomCount, config.itemCount, config.branching, config.lockedDoors, config.npcCount);
+}
+
+/*  value of a "--name value" option, or "" if it wasn't given  */
+std::string GetOption(std::vector<std::string> const& args, std::string const& name) {
+    for (size_t i = 0; i + 1 < args.size(); i++) {
+        if (args[i] == name) {
+            return args[i + 1];
+        }
+    }
+    return "";
+}
+
+/*
+    --replay <transcript>
+    plays a transcript back with no window, as fast as it goes, then prints how it went
+    returns 0 if everything matched, 1 if not, 2 if the transcript couldn't be read (or its world options are bad, or there's nowhere for its save files)
+*/
+int ReplayTranscript(std::string const& path) {
+    Transcript::Recording recording;
+    try {
+        recording = Transcript::Load(path);
+    } catch (std::runtime_error &e) {
+        std::cerr << e.what() << std::endl;
+        return 2;
+    }
+
+    std::vector<std::string> worldArgs;
+    std::istringstream worldStream(recording.world);
+    for (std::string arg; worldStream >> arg; ) {
+        worldArgs.push_back(arg);
+    }
+
+    TextBasedGame tbg(std::make_unique<NullFrontend>());
+    WorldGen::Config worldConfig;
+    bool generated;
+    try {
+        generated = ParseWorldOptions(worldArgs, worldConfig);
+    } catch (std::invalid_argument &e) {
+        std::cerr << fmt::format("{}: {}", path, e.what()) << std::endl;
+        return 2;
+    }
+    if (generated) {
+        tbg.Init(worldConfig);
+    } else {
+        tbg.Init();
+    }
+
+    Transcript::ReplayResult result;
+    try {
+        result = Transcript::Replay(tbg, recording);
+    } catch (std::runtime_error &e) {
+        std::cerr << e.what() << std::endl;
+        return 2;
+    }
+
+    std::cout << fmt::format("replayed {} commands in {:.3f} ms ({:.0f} commands/sec)",
+        result.commands, result.seconds * 1000, (result.seconds > 0) ? result.commands / result.seconds : 0.0) << std::endl;
+    if (!result.startMatches) {
+        std::cout << "start state: differs (different world or build?)" << std::endl;
+    }
+    if (result.outputMismatches == 0) {
+        std::cout << "output: all matched" << std::endl;
+    } else {
+        std::cout << fmt::format("output: {} mismatched, first at {}", result.outputMismatches, result.firstMismatch) << std::endl;
+    }
+    std::cout << "final state: " << (!recording.hasEnd ? "not recorded" : result.endMatches ? "matched" : "differs") << std::endl;
+
+    return result.Passed() ? 0 : 1;
+}
+
+/*  in a TBG_TRACE build, writes everything that was traced to TextBasedGame::TraceFileName on the way out  */
+void SaveTrace() {
+    if constexpr (Trace::Enabled) {
+        try {
+            size_t saved = Trace::Save(TextBasedGame::TraceFileName);
+            std::cerr << fmt::format("trace: {} spans in {} ({} dropped)", saved, TextBasedGame::TraceFileName, Trace::GetDropped()) << std::endl;
+        } catch (std::runtime_error &e) {
+            std::cerr << e.what() << std::endl;
+        }
+    }
+}
+
+/*  the running --serve server, for the signal handler  */
+Server *server = nullptr;
+
+/*
+    --serve <address> [--threads <n>] [--hibernate <seconds> [--hibernate-store <path>]]
+    runs the world for network players instead of playing it, until ctrl+c (see Server::Listen for addresses)
+    commands run on n threads (default one per core), the --world-* options work the same
+    --hibernate moves sessions idle for that long to a file (default sessions.tbgh) until they type again
+    returns 1 if the server couldn't start
+*/
+int Serve(std::string const& address, std::vector<std::string> const& args) {
+    TextBasedGame tbg(std::make_unique<NullFrontend>());
+    WorldGen::Config worldConfig;
+    if (ParseWorldOptions(args, worldConfig)) {
+        tbg.Init(worldConfig);
+    } else {
+        tbg.Init();
+    }
+
+    size_t threads = 0;
+    try {
+        std::string threadsOption = GetOption(args, "--threads");
+        threads = threadsOption.empty() ? 0 : std::stoul(threadsOption);
+    } catch (std::logic_error &e) {
+        /* not a number, one per core */
+    }
+
+    double hibernate = 0;
+    try {
+        std::string hibernateOption = GetOption(args, "--hibernate");
+        hibernate = hibernateOption.empty() ? 0 : std::stod(hibernateOption);
+    } catch (std::logic_error &e) {
+        /* not a number, don't hibernate */
+    }
+    std::string storePath = GetOption(args, "--hibernate-store");
+    if (storePath.empty()) {
+        storePath = "sessions.tbgh";
+    }
+
+    Server s(tbg, threads);
+    try {
+        if (hibernate > 0) {
+            s.EnableHibernation(hibernate, storePath);
+        }
+        s.Listen(address);
+    } catch (std::runtime_error &e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+
+    server = &s;
+    std::signal(SIGINT, [](int){ server->Stop(); });
+    std::signal(SIGTERM, [](int){ server->Stop(); });
+
+    std::cout << fmt::format("listening on {}", address) << std::endl;
+    s.Run();
+    server = nullptr;
+    SaveTrace();
+    return 0;
+}
+
+/*
+    --solve <room> [--solve-max-states <n>] [--threads <n>] [--solve-first] [--solve-drops] [--solve-all-items]
+    checks whether the world (the --world-* options work the same) can be won by getting to that room,
+    prints the shortest way to do it and the commands that make it impossible (see Solver)
+    returns 0 if it can be won, 1 if not, 2 if there's no such room
+*/
+int SolveWorld(std::string const& goalRoom, std::vector<std::string> const& args) {
+    TextBasedGame tbg(std::make_unique<NullFrontend>());
+    WorldGen::Config worldConfig;
+    if (ParseWorldOptions(args, worldConfig)) {
+        tbg.Init(worldConfig);
+    } else {
+        tbg.Init();
+    }
+
+    Solver::Config config;
+    config.goalRoom = goalRoom;
+    try {
+        std::string maxStates = GetOption(args, "--solve-max-states");
+        if (!maxStates.empty()) {
+            config.maxStates = std::stoull(maxStates);
+        }
+        std::string threads = GetOption(args, "--threads");
+        if (!threads.empty()) {
+            config.threads = std::stoul(threads);
+        }
+    } catch (std::logic_error &e) {
+        /* not a number, keep the default */
+    }
+    config.firstWinOnly = std::find(args.begin(), args.end(), "--solve-first") != args.end();
+    config.drops = std::find(args.begin(), args.end(), "--solve-drops") != args.end();
+    config.allItems = std::find(args.begin(), args.end(), "--solve-all-items") != args.end();
+
+    Solver solver(tbg, config);
+    Solver::Result result;
+    try {
+        result = solver.Solve();
+    } catch (std::out_of_range &e) {
+        std::cerr << e.what() << std::endl;
+        return 2;
+    }
+
+    std::cout << fmt::format("{} states, {} commands deep, in {:.3f} s ({:.0f} states/sec, {} threads)",
+        result.states, result.depth, result.seconds, (result.seconds > 0) ? result.states / result.seconds : 0.0, result.threads) << std::endl;
+    std::cout << fmt::format("{} of {} carriable items matter", result.relevantItems, result.carriableItems) << std::endl;
+    if (!result.complete) {
+        std::cout << (config.firstWinOnly ? "stopped at the first win" : "stopped at --solve-max-states, not everything was explored") << std::endl;
+    }
+
+    if (result.winnable) {
+        std::cout << fmt::format("winnable in {} commands{}:", result.solution.size(), result.verified ? "" : " (but playing them didn't get there!)") << std::endl;
+        for (auto &command : result.solution) {
+            std::cout << "  " << command << std::endl;
+        }
+    } else {
+        std::cout << (result.complete ? "can't be won" : "no way to win found (yet)") << std::endl;
+    }
+
+    if (result.complete) {
+        std::cout << fmt::format("{} dead ends", result.deadEnds) << std::endl;
+        for (auto &point : result.pointsOfNoReturn) {
+            std::cout << fmt::format("  \"{}\" ({} times), first after: {}", point.command, point.count, fmt::join(point.example, ", ")) << std::endl;
+        }
+    }
+    return result.winnable ? 0 : 1;
+}
+
+/*  writes what a Validator found, everything or only the checks that found something  */
+void PrintValidation(Validator::Report const& report, std::ostream &out, bool everything) {
+    if (everything) {
+        out << fmt::format("{} rooms, {} items, {} special commands, checked in {:.3f} s ({} threads)",
+            report.rooms, report.items, report.specialCommands, report.seconds, report.threads) << std::endl;
+        out << fmt::format("{} rooms reachable, {} of them only through exits special commands make",
+            report.reachableRooms, report.roomsBehindSpecials) << std::endl;
+    }
+    for (auto &check : report.checks) {
+        if (check.count == 0 && !everything) {
+            continue;
+        }
+        out << fmt::format("{}: {}", check.name, (check.count == 0) ? "ok" : fmt::format("{} {}", check.count, check.isError ? "errors" : "warnings")) << std::endl;
+        for (auto &example : check.examples) {
+            out << "  " << example << std::endl;
+        }
+        if (check.count > check.examples.size()) {
+            out << fmt::format("  ...and {} more", check.count - check.examples.size()) << std::endl;
+        }
+    }
+    out << fmt::format("{} errors, {} warnings", report.GetErrorCount(), report.GetWarningCount()) << std::endl;
+}
+
+/*
+    --validate [--images <dir>] [--threads <n>]
+    checks the world (the --world-* options work the same) for broken references, rooms that can't be
+    reached, lost items and missing room images, and prints everything it found (see Validator)
+    images are looked for in <dir>, by default assets/images next to the game for the built-in world
+    and nowhere for generated ones
+    returns 0 if there were no errors (warnings are fine), 1 if there were
+*/
+int ValidateWorld(std::vector<std::string> const& args) {
+    TextBasedGame tbg(std::make_unique<NullFrontend>());
+    WorldGen::Config worldConfig;
+    bool generated = ParseWorldOptions(args, worldConfig);
+    if (generated) {
+        tbg.Init(worldConfig);
+    } else {
+        tbg.Init();
+    }
+
+    Validator::Config config;
+    config.imageDirectory = GetOption(args, "--images");
+    if (config.imageDirectory.empty() && !generated) {
+        config.imageDirectory = std::string(GetApplicationDirectory()) + "assets/images";
+    }
+    try {
+        std::string threads = GetOption(args, "--threads");
+        if (!threads.empty()) {
+            config.threads = std::stoul(threads);
+        }
+    } catch (std::logic_error &e) {
+        /* not a number, one per core */
+    }
+
+    Validator validator(tbg, config);
+    auto report = validator.Validate();
+    PrintValidation(report, std::cout, true);
+    return (report.GetErrorCount() == 0) ? 0 : 1;
+}
+
+/*
+    --bench-npcs [--bench-turns <n>]
+    times whole turns of NPC schedules (TextBasedGame::Tick) on generated worlds with 10 to 100k NPCs, the
+    other --world-* options work the same, and prints a line per world: rooms, NPCs, how many NPCs came or
+    went where the player is per turn, time per turn and per NPC that came or went
+    first with --world-rooms rooms, so more NPCs means more of them moving where the player is - per NPC moved
+    should stay the same - then with rooms growing with the NPCs (one per 10), so as many move where the
+    player is whatever the total - per turn should stay the same
+*/
+int BenchNPCs(std::vector<std::string> const& args) {
+    WorldGen::Config worldConfig;
+    ParseWorldOptions(args, worldConfig);
+    uint32_t turns = 10000;
+    try {
+        std::string n = GetOption(args, "--bench-turns");
+        if (!n.empty()) {
+            turns = std::max<uint32_t>(std::stoul(n), 1);
+        }
+    } catch (std::logic_error &e) {
+        /* not a number, keep the default */
+    }
+
+    std::cout << fmt::format("{:>8} {:>8} {:>12} {:>10} {:>10}", "rooms", "npcs", "moved/turn", "ns/turn", "ns/moved") << std::endl;
+    uint32_t rooms = worldConfig.roomCount;
+    for (bool growRooms : { false, true }) {
+        for (uint32_t npcCount : { 10u, 100u, 1000u, 10000u, 100000u }) {
+            worldConfig.npcCount = npcCount;
+            worldConfig.roomCount = growRooms ? std::max(npcCount / 10, 1u) : rooms;
+            TextBasedGame tbg(std::make_unique<NullFrontend>());
+            tbg.Init(worldConfig);
+
+            /* the first few turns size the text */
+            std::string text;
+            for (uint32_t i = 0; i < 4096; i++) {
+                text.clear();
+                tbg.Tick(text);
+            }
+
+            size_t moved = 0;
+            auto start = std::chrono::steady_clock::now();
+            for (uint32_t i = 0; i < turns; i++) {
+                text.clear();
+                moved += tbg.Tick(text);
+            }
+            double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+            std::cout << fmt::format("{:>8} {:>8} {:>12.2f} {:>10.1f} {:>10.1f}",
+                worldConfig.roomCount, npcCount, double(moved) / turns, ns / turns, (moved > 0) ? ns / moved : 0.0) << std::endl;
+        }
+    }
+    return 0;
+}
+
+/*
+    --bench [--bench-sizes <n,n,...>] [--bench-time <seconds>] [--bench-runs <n>]
+    microbenchmarks on generated worlds of each size (rooms, and as many items - default 100,1000,10000),
+    one JSON line per benchmark and size on stdout (see Bench), the other --world-* options work the same
+    --bench-time is how long each timed batch takes (default 0.1), the median of --bench-runs batches counts (default 5)
+    allocations per op are only counted in a TBG_COUNT_ALLOCS build (make bench)
+*/
+int RunBenchmarks(std::vector<std::string> const& args) {
+    Bench::Config config;
+    ParseWorldOptions(args, config.world);
+    try {
+        std::string sizes = GetOption(args, "--bench-sizes");
+        if (!sizes.empty()) {
+            config.sizes.clear();
+            std::stringstream in(sizes);
+            std::string size;
+            while (std::getline(in, size, ',')) {
+                config.sizes.push_back(ParseWorldValue<uint32_t>("--bench-sizes", size, 1, WorldGen::MaxRooms));
+            }
+        }
+        std::string seconds = GetOption(args, "--bench-time");
+        if (!seconds.empty()) {
+            config.seconds = std::stod(seconds);
+        }
+        std::string runs = GetOption(args, "--bench-runs");
+        if (!runs.empty()) {
+            config.runs = std::stoul(runs);
+        }
+    } catch (std::logic_error &e) {
+        std::cerr << fmt::format("--bench-sizes (1 to {} rooms), --bench-time and --bench-runs take numbers", WorldGen::MaxRooms) << std::endl;
+        return 2;
+    }
+
+    Bench(config).Run([](Bench::Result const& result) {
+        std::cout << result.ToJson() << std::endl;
+    });
+    return 0;
+}
+
+/*  nobody typing anything, for --check-allocs - Poll() never closes, unlike NullFrontend  */
+class IdleFrontend : public NullFrontend {
+    public:
+
+    Event Poll() override { return Event::None; }
+};
+
+/*
+    --check-allocs [--no-window] (needs a TBG_COUNT_ALLOCS build, make allocs)
+    runs idle frames with the profiler on and checks not one of the last Window frames (the profiler's,
+    after the rest of Capacity to settle) allocated, printing the profiler's report for each run
+    frames are paced at Frontend::StepRate like a vsynced window, so every frame runs a sim step - a command's
+    output is given just before the checked frames, so it's still scrolling in while they run (and the
+    profiler overlay refreshes in the middle of them)
+    - with no window (IdleFrontend) - nothing typed, then half a command typed while a command's output comes in
+    - in the game's window (Graphics), so Draw and Blit are checked too - the same
+      (--no-window leaves this one out, for machines without a display - Draw/Blit aren't checked then)
+    the --world-* options work the same
+    returns 1 if any frame allocated (or the window didn't draw), 2 if allocations aren't counted in this build
+*/
+int CheckIdleAllocations(std::vector<std::string> const& args) {
+    if constexpr (!Profiler::CountsAllocations) {
+        std::cerr << "allocations aren't counted in this build, see make allocs" << std::endl;
+        return 2;
+    }
+    WorldGen::Config worldConfig;
+    bool generated = ParseWorldOptions(args, worldConfig);
+    bool window = std::find(args.begin(), args.end(), "--no-window") == args.end();
+
+    int result = 0;
+    auto frames = [](TextBasedGame &tbg, size_t count) {
+        auto interval = std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(1.0 / Frontend::StepRate));
+        auto next = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < count; i++) {
+            next += interval;
+            std::this_thread::sleep_until(next);
+            if (!tbg.RunFrame()) {
+                return;
+            }
+        }
+    };
+    /* command is run between settling and the checked frames, "" for none */
+    auto check = [&](TextBasedGame &tbg, std::string const& name, std::string const& command, bool drawn) {
+        frames(tbg, Profiler::Capacity - Profiler::Window);
+        if (!command.empty()) {
+            tbg.Eval(command);
+        }
+        frames(tbg, Profiler::Window);
+        auto &profiler = tbg.GetProfiler();
+        auto stats = profiler.GetStats(Profiler::Phase::Frame);
+        std::cout << name << std::endl;
+        for (auto &line : profiler.GetReport()) {
+            std::cout << "    " << line << std::endl;
+        }
+        /* a window that was hidden (or closed) didn't check anything */
+        if (drawn && profiler.GetStats(Profiler::Phase::Draw).frames < Profiler::Window) {
+            std::cout << "    FAILED (the window didn't draw every frame)" << std::endl;
+            result = 1;
+            return;
+        }
+        std::cout << fmt::format("    {} ({} allocations in the worst frame)", (stats.maxAllocs == 0) ? "ok" : "FAILED", stats.maxAllocs) << std::endl;
+        if (stats.maxAllocs != 0) {
+            result = 1;
+        }
+    };
+    auto init = [&](TextBasedGame &tbg) {
+        if (generated) {
+            tbg.Init(worldConfig);
+        } else {
+            tbg.Init();
+        }
+        tbg.Eval("set profiler on");
+    };
+
+    {
+        auto frontend = std::make_unique<IdleFrontend>();
+        IdleFrontend *idle = frontend.get();
+        TextBasedGame tbg(std::move(frontend));
+        init(tbg);
+        check(tbg, "nothing typed", "", false);
+        idle->SetTextIn("take the red k");
+        check(tbg, "\"take the red k\" typed, \"look around\" coming in", "look around", false);
+    }
+    if (window) {
+        auto frontend = std::make_unique<Graphics>();
+        Graphics *graphics = frontend.get();
+        TextBasedGame tbg(std::move(frontend));
+        init(tbg);
+        graphics->SetTextIn("take the red k");
+        check(tbg, "in the window, \"take the red k\" typed, \"look around\" coming in", "look around", true);
+    }
+    return result;
+}
+
+int main(int argc, char **argv) {
     
+    std::vector<std::string> args(argv + 1, argv + argc);
+
+    /* bad --world-* options stop everything here, whatever the mode (they're all parsed again the same way) */
+    try {
+        WorldGen::Config worldConfig;
+        ParseWorldOptions(args, worldConfig);
+    } catch (std::invalid_argument &e) {
+        std::cerr << e.what() << std::endl;
+        return 2;
+    }
+
+    /* before ChangeDirectory, so the path is relative to wherever this was started from */
+    std::string replayPath = GetOption(args, "--replay");
+    if (!replayPath.empty()) {
+        return ReplayTranscript(replayPath);
+    }
+    std::string serveAddress = GetOption(args, "--serve");
+    if (!serveAddress.empty()) {
+        return Serve(serveAddress, args);
+    }
+    std::string goalRoom = GetOption(args, "--solve");
+    if (!goalRoom.empty()) {
+        return SolveWorld(goalRoom, args);
+    }
+    if (std::find(args.begin(), args.end(), "--validate") != args.end()) {
+        return ValidateWorld(args);
+    }
+    if (std::find(args.begin(), args.end(), "--bench-npcs") != args.end()) {
+        return BenchNPCs(args);
+    }
+    if (std::find(args.begin(), args.end(), "--bench") != args.end()) {
+        return RunBenchmarks(args);
+    }
+
     /*
         for convenience - in the final app, probably want LOG_NONE
         or figure out how to launch without terminal then no problem
@@ -32,15 +590,60 @@ int main() {
         maybe GetAppDir() instead or SearchAndSetResourceDir() - test later
     */
     ChangeDirectory(GetApplicationDirectory());
+
+    /* after ChangeDirectory, the window part needs the assets */
+    if (std::find(args.begin(), args.end(), "--check-allocs") != args.end()) {
+        return CheckIdleAllocations(args);
+    }
     
-    TextBasedGame tbg = TextBasedGame();
-    tbg.Init();
+    /* --stdio plays in the terminal instead of a window */
+    std::unique_ptr<Frontend> frontend;
+    if (std::find(args.begin(), args.end(), "--stdio") != args.end()) {
+        frontend = std::make_unique<StdioFrontend>();
+    } else {
+        frontend = std::make_unique<Graphics>();
+    }
+
+    TextBasedGame tbg(std::move(frontend));
+    WorldGen::Config worldConfig;
+    bool generated = ParseWorldOptions(args, worldConfig);
+    std::string recordPath = GetOption(args, "--record");
+    if (generated) {
+        tbg.Init(worldConfig);
+    } else {
+        tbg.Init();
+        /*
+            generated worlds are throwaway, only the real one picks up where it left off
+            (and not while recording, transcripts always start from a fresh game)
+        */
+        if (recordPath.empty()) {
+            tbg.EnableAutosave();
+        }
+    }
+
+    /* mistakes in the world go to the terminal, the game still starts (--validate shows everything) */
+    Validator::Config validatorConfig;
+    validatorConfig.imageDirectory = generated ? "" : "assets/images";
+    auto report = Validator(tbg, validatorConfig).Validate();
+    if (report.GetErrorCount() + report.GetWarningCount() > 0) {
+        PrintValidation(report, std::cerr, false);
+    }
+
+    /* --record <transcript>, next to the game like save files */
+    if (!recordPath.empty()) {
+        try {
+            tbg.StartRecording(recordPath, generated ? WorldOptions(worldConfig) : "");
+        } catch (std::runtime_error &e) {
+            std::cerr << e.what() << std::endl;
+        }
+    }
 
     try {
         tbg.Run();
     } catch (TextBasedGame::ExitGameException e) {
         // call ~tbg()
     }
+    SaveTrace();
 
     return 0;
-}
\ No newline at end of file
+}
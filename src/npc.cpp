@@ -0,0 +1,27 @@
+#include "npc.hpp"
+
+NPC::NPC(
+    std::string _name,
+    std::string _repr,
+    std::unordered_map<Message, std::string> _messages
+) {
+    name = _name;
+    repr = _repr;
+    messages = _messages;
+}
+
+std::string& NPC::GetName() {
+    return name;
+}
+
+std::string& NPC::GetRepr() {
+    return repr;
+}
+
+std::string& NPC::GetMessage(NPC::Message mtype) {
+    return messages.at(mtype);
+}
+
+bool NPC::HasMessage(NPC::Message mtype) {
+    return messages.contains(mtype);
+}
@@ -0,0 +1,88 @@
+#ifndef __NPC__
+#define __NPC__
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/*
+    A character in a room that the player can:
+    - Inspect
+    - Talk to (see Dialogue)
+    - Give items to, and maybe get something back (see Trade)
+
+    Like items, where an NPC is can be different for every player (see TextBasedGame::Session),
+    and what it says and trades are kept by the game in flat tables (see TextBasedGame::AddNPC)
+*/
+class NPC {
+
+    public:
+
+    /*
+        a type of NPC message, used to pass messages by type
+    */
+    enum Message {
+        /* ex. look at guard -> a bored guard, leaning on his spear. */
+        OnInspect,
+        /* ex. give spoon to guard -> the guard doesn't want that. */
+        OnRefuse,
+    };
+
+    /*
+        something the NPC will take - giving it wants gets the player gives (if it's not "") and the message
+        ex. Trade { "Coin", "Map", "The guard pockets the coin and hands you a map." }
+    */
+    struct Trade {
+        std::string wants;
+        std::string gives;
+        std::string message;
+    };
+
+    /*
+        one stop on an NPC's schedule - it's in room for turns turns, then goes on to the next stop
+        (after the last one it starts over), see TextBasedGame::AddNPCSchedule
+    */
+    struct Stop {
+        std::string room;
+        uint32_t turns;
+    };
+
+    private:
+
+    /* internal name */
+    std::string name;
+    /* in-game string representation */
+    std::string repr;
+    /* contains all messages for this NPC */
+    std::unordered_map<Message, std::string> messages;
+
+    public:
+
+    /*
+        NPC constructor
+        _name: internal name
+        _repr: in-game string representation
+        _messages: all messages for this NPC (see NPC::Message)
+    */
+    NPC(
+        std::string _name,
+        std::string _repr,
+        std::unordered_map<Message, std::string> _messages
+    );
+
+    /*  the internal name of the NPC  */
+    std::string& GetName();
+
+    /*  the in-game string representation of the NPC */
+    std::string& GetRepr();
+
+    /*  return a specific message  */
+    std::string& GetMessage(Message mtype);
+
+    /*  whether it was given a message of that type  */
+    bool HasMessage(Message mtype);
+
+};
+
+#endif /* __NPC__ */
@@ -0,0 +1,25 @@
+#include "nullfrontend.hpp"
+
+Frontend::Event NullFrontend::Poll() {
+    return Event::Close;
+}
+
+bool NullFrontend::WaitsForKeys() {
+    return false;
+}
+
+std::string NullFrontend::GetTextIn() {
+    return textIn;
+}
+
+void NullFrontend::SetTextIn(std::string s) {
+    textIn = s;
+}
+
+std::string NullFrontend::GetTextOut(int line) {
+    return textOut[line];
+}
+
+void NullFrontend::SetTextOut(std::string s, int line) {
+    textOut[line] = s;
+}
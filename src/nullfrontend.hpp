@@ -0,0 +1,29 @@
+#ifndef __NULLFRONTEND__
+#define __NULLFRONTEND__
+
+#include <string>
+
+#include "frontend.hpp"
+
+/*
+    A frontend with nobody on the other side - no window, no input (Poll() always says Close)
+    text still goes in and out, so Eval() can be driven directly, like Transcript::Replay does
+*/
+class NullFrontend : public Frontend {
+    private:
+
+    std::string textIn;
+    std::string textOut[LineOutCount];
+
+    public:
+
+    Event Poll() override;
+    bool WaitsForKeys() override;
+
+    std::string GetTextIn() override;
+    void SetTextIn(std::string s) override;
+    std::string GetTextOut(int line) override;
+    void SetTextOut(std::string s, int line) override;
+};
+
+#endif /* __NULLFRONTEND__ */
@@ -0,0 +1,164 @@
+#include "pathfinder.hpp"
+
+#include <algorithm>
+
+PathFinder::PathFinder() {
+    graph = nullptr;
+    graphVersion = 0;
+    stamp = 0;
+}
+
+void PathFinder::Prepare(RoomGraph& _graph) {
+    if (&_graph == graph && _graph.GetVersion() == graphVersion) {
+        return;
+    }
+    graph = &_graph;
+    graphVersion = _graph.GetVersion();
+
+    /* count every room's incoming exits, then put them in place - next is the write position per room */
+    uint32_t roomCount = _graph.RoomCount();
+    reverseOffsets.assign(roomCount + 1, 0);
+    for (uint32_t room = 0; room < roomCount; room++) {
+        for (auto &exit : _graph.GetExits(room)) {
+            if (exit.target < roomCount) {
+                reverseOffsets[exit.target + 1]++;
+            }
+        }
+    }
+    for (uint32_t room = 0; room < roomCount; room++) {
+        reverseOffsets[room + 1] += reverseOffsets[room];
+    }
+    reverseSources.resize(reverseOffsets[roomCount]);
+    next.assign(reverseOffsets.begin(), reverseOffsets.end() - 1);
+    for (uint32_t room = 0; room < roomCount; room++) {
+        for (auto &exit : _graph.GetExits(room)) {
+            if (exit.target < roomCount) {
+                reverseSources[next[exit.target]++] = room;
+            }
+        }
+    }
+
+    if (visits.size() != roomCount) {
+        visits.assign(roomCount, Visit { 0, 0, 0, 0, 0, 0 });
+        stamp = 0;
+    }
+}
+
+uint32_t PathFinder::Search(RoomGraph& graph, uint32_t from, uint32_t to) {
+    Prepare(graph);
+    if (from == to) {
+        return from;
+    }
+    uint32_t roomCount = static_cast<uint32_t>(visits.size());
+    if (from >= roomCount || to >= roomCount) {
+        return RoomGraph::None;
+    }
+    /* a new search number, clearing the marks only when it wraps around */
+    if (++stamp == 0) {
+        for (auto &visit : visits) {
+            visit.forwardStamp = 0;
+            visit.backwardStamp = 0;
+        }
+        stamp = 1;
+    }
+
+    visits[from].forwardStamp = stamp;
+    visits[from].forwardParent = from;
+    visits[from].forwardDepth = 0;
+    visits[to].backwardStamp = stamp;
+    visits[to].backwardNext = to;
+    visits[to].backwardDepth = 0;
+    forward.assign(1, from);
+    backward.assign(1, to);
+
+    /*
+        a level at a time, from the smaller side - the first level where the sides meet has the
+        shortest route through one of the rooms met on it (not necessarily the first one), so the
+        whole level is finished before picking
+    */
+    while (!forward.empty() && !backward.empty()) {
+        uint32_t meet = RoomGraph::None;
+        uint32_t best = UINT32_MAX;
+        next.clear();
+        if (forward.size() <= backward.size()) {
+            for (uint32_t room : forward) {
+                uint32_t depth = visits[room].forwardDepth + 1;
+                for (auto &exit : graph.GetExits(room)) {
+                    if (exit.target >= roomCount) {
+                        continue;
+                    }
+                    Visit &visit = visits[exit.target];
+                    if (visit.forwardStamp == stamp) {
+                        continue;
+                    }
+                    visit.forwardStamp = stamp;
+                    visit.forwardParent = room;
+                    visit.forwardDepth = depth;
+                    if (visit.backwardStamp == stamp && depth + visit.backwardDepth < best) {
+                        best = depth + visit.backwardDepth;
+                        meet = exit.target;
+                    }
+                    next.push_back(exit.target);
+                }
+            }
+            forward.swap(next);
+        } else {
+            for (uint32_t room : backward) {
+                uint32_t depth = visits[room].backwardDepth + 1;
+                for (uint32_t i = reverseOffsets[room]; i < reverseOffsets[room + 1]; i++) {
+                    uint32_t source = reverseSources[i];
+                    Visit &visit = visits[source];
+                    if (visit.backwardStamp == stamp) {
+                        continue;
+                    }
+                    visit.backwardStamp = stamp;
+                    visit.backwardNext = room;
+                    visit.backwardDepth = depth;
+                    if (visit.forwardStamp == stamp && depth + visit.forwardDepth < best) {
+                        best = depth + visit.forwardDepth;
+                        meet = source;
+                    }
+                    next.push_back(source);
+                }
+            }
+            backward.swap(next);
+        }
+        if (meet != RoomGraph::None) {
+            return meet;
+        }
+    }
+    return RoomGraph::None;
+}
+
+std::vector<uint32_t> PathFinder::FindPath(RoomGraph& graph, uint32_t from, uint32_t to) {
+    if (from == to) {
+        return {};
+    }
+    uint32_t meet = Search(graph, from, to);
+    if (meet == RoomGraph::None) {
+        return {};
+    }
+
+    std::vector<uint32_t> path;
+    for (uint32_t room = meet; room != from; room = visits[room].forwardParent) {
+        path.push_back(room);
+    }
+    std::reverse(path.begin(), path.end());
+    for (uint32_t room = meet; room != to; ) {
+        room = visits[room].backwardNext;
+        path.push_back(room);
+    }
+    return path;
+}
+
+bool PathFinder::IsReachable(RoomGraph& graph, uint32_t from, uint32_t to) {
+    return Search(graph, from, to) != RoomGraph::None;
+}
+
+void PathFinder::Invalidate() {
+    graph = nullptr;
+    std::vector<uint32_t>().swap(reverseOffsets);
+    std::vector<uint32_t>().swap(reverseSources);
+    std::vector<Visit>().swap(visits);
+    stamp = 0;
+}
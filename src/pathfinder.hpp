@@ -0,0 +1,85 @@
+#ifndef __PATHFINDER__
+#define __PATHFINDER__
+
+#include <cstdint>
+#include <vector>
+
+#include "roomgraph.hpp"
+
+/*
+    Finds shortest routes between rooms (fewest exits taken) over a RoomGraph
+
+    Each search is a bidirectional BFS: one side goes out of the source along exits, the other back
+    from the target along exits reversed, a level at a time (whichever side has the smaller frontier),
+    and it stops once the two meet. That only visits the rooms near either end instead of everything
+    closer to the source than the target - on a generated 100k room world a route takes ~40 us
+    (make bench, PathFinder::FindPath), where a whole BFS from the source took ~5.5 ms (and every trip
+    starts somewhere new, so caching whole BFS trees per source hardly ever paid off).
+
+    Exits reversed come from an index of every room's incoming exits, built the first time it's needed
+    and again whenever the graph's version changes (LinkRooms etc) - that's O(exits), once per change,
+    not per search. Per room visited marks are stamped with a search number, so starting a search
+    doesn't clear anything and nothing is allocated once the arrays have grown to the graph.
+
+    Locked doors are just exits that haven't been linked yet, so routes never go through them.
+*/
+class PathFinder {
+
+    private:
+
+    /*  what a search knows about a room, valid only if the stamp is the current search's  */
+    struct Visit {
+        uint32_t forwardStamp;
+        /*  room it was reached from, going out of the source  */
+        uint32_t forwardParent;
+        uint32_t forwardDepth;
+        uint32_t backwardStamp;
+        /*  room it leads to, going towards the target  */
+        uint32_t backwardNext;
+        uint32_t backwardDepth;
+    };
+
+    /*  the graph (and its GetVersion()) the reverse index was built from, nullptr if there isn't one  */
+    RoomGraph *graph;
+    uint64_t graphVersion;
+
+    /*  incoming exits: the rooms with an exit into room r are sources[offsets[r]] .. sources[offsets[r + 1] - 1]  */
+    std::vector<uint32_t> reverseOffsets;
+    std::vector<uint32_t> reverseSources;
+
+    /*  per room, indexed by room id  */
+    std::vector<Visit> visits;
+    uint32_t stamp;
+
+    /*  BFS frontiers, reused so searches don't allocate once warmed up  */
+    std::vector<uint32_t> forward;
+    std::vector<uint32_t> backward;
+    std::vector<uint32_t> next;
+
+    /*  (re)builds the reverse index and sizes visits if graph isn't the one they were made for  */
+    void Prepare(RoomGraph& _graph);
+
+    /*  the room where the shortest route from -> to crosses from the forward side to the backward one, None if there's none  */
+    uint32_t Search(RoomGraph& graph, uint32_t from, uint32_t to);
+
+    public:
+
+    /*  PathFinder constructor - nothing is built until the first search  */
+    PathFinder();
+
+    /*
+        shortest route from -> to, as the list of rooms entered along the way
+        (so it doesn't include "from", and ends with "to")
+        empty if there's no way there, or from == to
+    */
+    std::vector<uint32_t> FindPath(RoomGraph& graph, uint32_t from, uint32_t to);
+
+    /*  can "to" be reached from "from" at all?  */
+    bool IsReachable(RoomGraph& graph, uint32_t from, uint32_t to);
+
+    /*  throws away the reverse index and the search arrays (their memory too)  */
+    void Invalidate();
+
+};
+
+#endif /* __PATHFINDER__ */
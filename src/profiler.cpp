@@ -0,0 +1,175 @@
+#include "profiler.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <iterator>
+#include <new>
+
+#define FMT_HEADER_ONLY
+#include "fmt/core.h"
+
+namespace {
+    /*  plain data, so it's there before anything can call operator new on the thread  */
+    thread_local Profiler::Allocations threadAllocations { 0, 0 };
+}
+
+#ifdef TBG_COUNT_ALLOCS
+/*
+    the replaceable global allocation functions - the rest (new[], nothrow) call these,
+    aligned new isn't counted (nothing here over-aligns)
+*/
+void *operator new(size_t size) {
+    threadAllocations.count++;
+    threadAllocations.bytes += size;
+    if (size == 0) {
+        size = 1;
+    }
+    while (true) {
+        if (void *p = std::malloc(size)) {
+            return p;
+        }
+        std::new_handler handler = std::get_new_handler();
+        if (!handler) {
+            throw std::bad_alloc();
+        }
+        handler();
+    }
+}
+
+void operator delete(void *p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void *p, size_t) noexcept {
+    std::free(p);
+}
+#endif
+
+Profiler::Scope::Scope(Profiler *_profiler, Phase _phase) : profiler(_profiler), phase(_phase) {
+    if (profiler) {
+        allocStart = ThreadAllocations();
+        start = Clock::now();
+    }
+}
+
+Profiler::Scope::~Scope() {
+    if (profiler) {
+        auto time = Clock::now() - start;
+        Allocations allocs = ThreadAllocations();
+        profiler->Add(phase, time, { allocs.count - allocStart.count, allocs.bytes - allocStart.bytes });
+    }
+}
+
+Profiler::Profiler() : on(false), written(0) {
+    current.fill(0);
+    ran.fill(false);
+    currentAllocs.fill({ 0, 0 });
+}
+
+void Profiler::SetOn(bool _on) {
+    /* a frame that was half timed when it was turned off doesn't count */
+    current.fill(0);
+    ran.fill(false);
+    currentAllocs.fill({ 0, 0 });
+    on.store(_on, std::memory_order_relaxed);
+}
+
+bool Profiler::IsOn() const {
+    return on.load(std::memory_order_relaxed);
+}
+
+void Profiler::Add(Phase phase, Clock::duration time, Allocations allocs) {
+    size_t p = static_cast<size_t>(phase);
+    current[p] += std::chrono::duration_cast<std::chrono::nanoseconds>(time).count();
+    ran[p] = true;
+    currentAllocs[p].count += allocs.count;
+    currentAllocs[p].bytes += allocs.bytes;
+}
+
+void Profiler::EndFrame() {
+    uint64_t n = written.load(std::memory_order_relaxed);
+    auto &frame = frames[n % Capacity];
+    for (size_t p = 0; p < PhaseCount; p++) {
+        uint32_t ns = ran[p] ? static_cast<uint32_t>(std::min<uint64_t>(current[p], NotRun - 1)) : NotRun;
+        frame.ns[p].store(ns, std::memory_order_relaxed);
+        frame.allocs[p].store(static_cast<uint32_t>(std::min<uint64_t>(currentAllocs[p].count, UINT32_MAX)), std::memory_order_relaxed);
+        frame.allocBytes[p].store(static_cast<uint32_t>(std::min<uint64_t>(currentAllocs[p].bytes, UINT32_MAX)), std::memory_order_relaxed);
+    }
+    written.store(n + 1, std::memory_order_release);
+    current.fill(0);
+    ran.fill(false);
+    currentAllocs.fill({ 0, 0 });
+}
+
+Profiler::Stats Profiler::GetStats(Phase phase) const {
+    size_t p = static_cast<size_t>(phase);
+    uint64_t n = written.load(std::memory_order_acquire);
+    uint64_t first = (n > Window) ? n - Window : 0;
+
+    std::array<uint32_t, Window> times;
+    size_t count = 0;
+    uint64_t allocs = 0, allocBytes = 0;
+    uint32_t maxAllocs = 0;
+    for (uint64_t i = first; i < n; i++) {
+        auto &frame = frames[i % Capacity];
+        uint32_t ns = frame.ns[p].load(std::memory_order_relaxed);
+        if (ns != NotRun) {
+            times[count++] = ns;
+            uint32_t frameAllocs = frame.allocs[p].load(std::memory_order_relaxed);
+            allocs += frameAllocs;
+            allocBytes += frame.allocBytes[p].load(std::memory_order_relaxed);
+            maxAllocs = std::max(maxAllocs, frameAllocs);
+        }
+    }
+    if (count == 0) {
+        return Stats { 0, 0, 0, 0, 0, 0, 0 };
+    }
+
+    uint64_t total = 0;
+    for (size_t i = 0; i < count; i++) {
+        total += times[i];
+    }
+    /* the smallest time that 99% of frames are under */
+    size_t p99 = std::min(count - 1, (count * 99 + 99) / 100 - 1);
+    std::nth_element(times.begin(), times.begin() + p99, times.begin() + count);
+    uint32_t p99Time = times[p99];
+    uint32_t minTime = *std::min_element(times.begin(), times.begin() + count);
+    return Stats {
+        static_cast<uint32_t>(count), minTime / 1000.0, total / 1000.0 / count, p99Time / 1000.0,
+        static_cast<double>(allocs) / count, static_cast<double>(allocBytes) / count, maxAllocs
+    };
+}
+
+std::vector<std::string> Profiler::GetReport() const {
+    std::vector<std::string> lines;
+    GetReport(lines);
+    return lines;
+}
+
+void Profiler::GetReport(std::vector<std::string> &lines) const {
+    lines.resize(1 + PhaseCount);
+    for (auto &line : lines) {
+        line.clear();
+    }
+    uint64_t frameCount = std::min<uint64_t>(written.load(std::memory_order_acquire), Window);
+    if constexpr (CountsAllocations) {
+        fmt::format_to(std::back_inserter(lines[0]), "{:<9}{:>8}{:>8}{:>8}{:>8}{:>9}  us, per frame, {} frames", "", "min", "avg", "p99", "allocs", "bytes", frameCount);
+    } else {
+        fmt::format_to(std::back_inserter(lines[0]), "{:<9}{:>8}{:>8}{:>8}  us, {} frames", "", "min", "avg", "p99", frameCount);
+    }
+    for (size_t p = 0; p < PhaseCount; p++) {
+        auto stats = GetStats(static_cast<Phase>(p));
+        auto out = std::back_inserter(lines[1 + p]);
+        if (stats.frames == 0) {
+            fmt::format_to(out, "{:<9}{:>8}{:>8}{:>8}", PhaseNames[p], "-", "-", "-");
+        } else if constexpr (CountsAllocations) {
+            fmt::format_to(out, "{:<9}{:>8.1f}{:>8.1f}{:>8.1f}{:>8.1f}{:>9.0f}  x{}", PhaseNames[p], stats.min, stats.avg, stats.p99, stats.allocs, stats.allocBytes, stats.frames);
+        } else {
+            fmt::format_to(out, "{:<9}{:>8.1f}{:>8.1f}{:>8.1f}  x{}", PhaseNames[p], stats.min, stats.avg, stats.p99, stats.frames);
+        }
+    }
+}
+
+Profiler::Allocations Profiler::ThreadAllocations() {
+    return threadAllocations;
+}
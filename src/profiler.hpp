@@ -0,0 +1,142 @@
+#ifndef __PROFILER__
+#define __PROFILER__
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/*
+    Where a frame's time goes, for "set profiler on" - Graphics draws GetReport() over the picture
+
+    Code being timed opens a Scope for its phase. Times are added up per phase for the frame (a phase that
+    runs twice counts twice, and phases inside others are counted in both - GetCommands is part of Eval
+    and UpdateHint), and EndFrame() puts the frame in a ring buffer of the last Capacity frames.
+    GetStats() works out min/avg/p99 over the last Window of them.
+
+    The ring buffer is lock-free: EndFrame() writes a slot then publishes it with one atomic store, so
+    GetStats() can run on another thread - it's Capacity - Window frames ahead of the writer. Only one
+    thread should time things (TextBasedGame only profiles the game's own session, not network players).
+
+    Built with TBG_COUNT_ALLOCS (make allocs), the global operator new counts every allocation made on
+    each thread, and a Scope also adds up the allocations made while it was open - that's how many a
+    phase does per frame (--check-allocs holds idle frames to none). Without it the counts are all zero.
+*/
+class Profiler {
+
+    public:
+
+    enum class Phase : uint8_t {
+        /*  everything Run() does in a frame, except waiting for the next one  */
+        Frame,
+        /*  Frontend::Poll  */
+        Poll,
+        UpdateHint,
+        GetCommands,
+        Eval,
+        /*  the fixed steps (TextBasedGame::Simulate), text scrolling in  */
+        TextReveal,
+        /*  drawing to the render texture  */
+        Draw,
+        /*  drawing the render texture to the window, and EndDrawing  */
+        Blit
+    };
+    static inline constexpr size_t PhaseCount = 8;
+    static inline constexpr const char* PhaseNames[PhaseCount] = { "frame", "poll", "hint", "commands", "eval", "text", "draw", "blit" };
+
+    /*  frames kept, and how many of the newest ones GetStats() looks at  */
+    static inline constexpr size_t Capacity = 256;
+    static inline constexpr size_t Window = 120;
+
+    using Clock = std::chrono::steady_clock;
+
+    /*  true if this build counts heap allocations  */
+#ifdef TBG_COUNT_ALLOCS
+    static inline constexpr bool CountsAllocations = true;
+#else
+    static inline constexpr bool CountsAllocations = false;
+#endif
+
+    /*  calls to operator new, and the bytes they asked for  */
+    struct Allocations {
+        uint64_t count;
+        uint64_t bytes;
+    };
+
+    /*  a phase over the last Window frames, in microseconds, only counting frames it ran in  */
+    struct Stats {
+        uint32_t frames;
+        double min;
+        double avg;
+        double p99;
+        /*  allocations per frame, on average and in the worst frame  */
+        double allocs;
+        double allocBytes;
+        uint32_t maxAllocs;
+    };
+
+    /*  times its phase from construction to destruction, does nothing if profiler is nullptr  */
+    class Scope {
+        public:
+
+        Scope(Profiler *_profiler, Phase _phase);
+        ~Scope();
+        Scope(Scope const&) = delete;
+        Scope& operator=(Scope const&) = delete;
+
+        private:
+
+        Profiler *profiler;
+        Phase phase;
+        Clock::time_point start;
+        Allocations allocStart;
+    };
+
+    Profiler();
+
+    void SetOn(bool on);
+    bool IsOn() const;
+
+    /*  adds time (and allocations) to a phase of the current frame  */
+    void Add(Phase phase, Clock::duration time, Allocations allocs = { 0, 0 });
+
+    /*  the current frame's done - it goes in the ring buffer and a new one starts  */
+    void EndFrame();
+
+    Stats GetStats(Phase phase) const;
+
+    /*  a header line and a line per phase, "phase  min  avg  p99" in microseconds (+ "allocs  bytes" per frame if they're counted)  */
+    std::vector<std::string> GetReport() const;
+
+    /*  the same, written over lines - it keeps each line's capacity, so a refresh doesn't allocate once they've grown  */
+    void GetReport(std::vector<std::string> &lines) const;
+
+    /*  every allocation made on the calling thread so far, zero if they aren't counted  */
+    static Allocations ThreadAllocations();
+
+    private:
+
+    /*  per phase, nanoseconds - NotRun if the phase didn't run that frame - and its allocations  */
+    static inline constexpr uint32_t NotRun = UINT32_MAX;
+    struct Frame {
+        std::array<std::atomic<uint32_t>, PhaseCount> ns;
+        std::array<std::atomic<uint32_t>, PhaseCount> allocs;
+        std::array<std::atomic<uint32_t>, PhaseCount> allocBytes;
+    };
+
+    std::atomic<bool> on;
+
+    /*  the frame being timed, nanoseconds  */
+    std::array<uint64_t, PhaseCount> current;
+    std::array<bool, PhaseCount> ran;
+    std::array<Allocations, PhaseCount> currentAllocs;
+
+    std::array<Frame, Capacity> frames;
+    /*  how many frames have been written, the newest is frames[(written - 1) % Capacity]  */
+    std::atomic<uint64_t> written;
+};
+
+#endif /* __PROFILER__ */
@@ -0,0 +1,191 @@
+#include "roomgraph.hpp"
+
+#include <algorithm>
+
+RoomGraph::RoomGraph() {
+    offsets = std::vector<uint32_t>{ 0 };
+    version = 0;
+    labelOffset = 0;
+    for (int d = 0; d < DirectionCount; d++) {
+        Intern(DirectionRepr(static_cast<Direction>(d), false));
+    }
+}
+
+RoomGraph::RoomGraph(std::shared_ptr<RoomGraph> _base) {
+    if (_base->base) {
+        *this = *_base;
+        return;
+    }
+    offsets = std::vector<uint32_t>{ 0 };
+    version = _base->version;
+    base = std::move(_base);
+    labelOffset = static_cast<uint32_t>(base->labels.size());
+}
+
+uint32_t RoomGraph::Intern(std::string_view exitName) {
+    uint32_t label = FindLabel(exitName);
+    if (label != None) {
+        return label;
+    }
+    label = labelOffset + static_cast<uint32_t>(labels.size());
+    labels.emplace_back(exitName);
+    labelIds.emplace(labels.back(), label);
+    return label;
+}
+
+uint32_t RoomGraph::FindLabel(std::string_view exitName) {
+    if (base) {
+        uint32_t label = base->FindLabel(exitName);
+        if (label != None) {
+            return label;
+        }
+    }
+    auto it = labelIds.find(std::string(exitName));
+    return (it == labelIds.end()) ? None : it->second;
+}
+
+std::string& RoomGraph::GetLabelName(uint32_t label) {
+    if (label < labelOffset) {
+        return base->GetLabelName(label);
+    }
+    return labels.at(label - labelOffset);
+}
+
+uint32_t RoomGraph::GetLabelCount() {
+    return labelOffset + static_cast<uint32_t>(labels.size());
+}
+
+void RoomGraph::SetExit(uint32_t from, uint32_t label, uint32_t target) {
+    if (base) {
+        SetOverlayExit(from, label, target);
+    } else {
+        pending.push_back(Edit { from, label, target });
+    }
+    version++;
+}
+
+void RoomGraph::RemoveExit(uint32_t from, uint32_t label) {
+    SetExit(from, label, None);
+}
+
+void RoomGraph::SetOverlayExit(uint32_t from, uint32_t label, uint32_t target) {
+    auto baseExits = base->GetExits(from);
+    auto it = changedRooms.find(from);
+    if (it == changedRooms.end()) {
+        it = changedRooms.emplace(from, std::vector<Exit>(baseExits.begin(), baseExits.end())).first;
+    }
+
+    auto &room = it->second;
+    auto exit = std::find_if(room.begin(), room.end(), [label](Exit const &x) { return x.label == label; });
+    if (target == None) {
+        if (exit != room.end()) {
+            room.erase(exit);
+        }
+    } else if (exit != room.end()) {
+        exit->target = target;
+    } else {
+        room.push_back(Exit { label, target });
+    }
+
+    bool same = std::equal(room.begin(), room.end(), baseExits.begin(), baseExits.end(), [](Exit const &a, Exit const &b) {
+        return a.label == b.label && a.target == b.target;
+    });
+    if (same) {
+        changedRooms.erase(it);
+    }
+}
+
+uint32_t RoomGraph::GetExit(uint32_t from, uint32_t label) {
+    for (auto &exit : GetExits(from)) {
+        if (exit.label == label) {
+            return exit.target;
+        }
+    }
+    return None;
+}
+
+std::span<RoomGraph::Exit> RoomGraph::GetExits(uint32_t from) {
+    if (base) {
+        auto it = changedRooms.find(from);
+        return (it == changedRooms.end()) ? base->GetExits(from) : std::span<Exit>(it->second);
+    }
+    Compact();
+    if (from + 1 >= offsets.size()) {
+        return {};
+    }
+    return std::span<Exit>(exits.data() + offsets[from], exits.data() + offsets[from + 1]);
+}
+
+uint32_t RoomGraph::RoomCount() {
+    if (base) {
+        return base->RoomCount();
+    }
+    Compact();
+    return static_cast<uint32_t>(offsets.size() - 1);
+}
+
+uint64_t RoomGraph::GetVersion() {
+    return version;
+}
+
+size_t RoomGraph::GetChangedRoomCount() {
+    return changedRooms.size();
+}
+
+void RoomGraph::Compact() {
+    if (pending.empty()) {
+        return;
+    }
+
+    /* grow to fit every room mentioned, then group edits by room (keeping their order) */
+    uint32_t roomCount = static_cast<uint32_t>(offsets.size() - 1);
+    for (auto &e : pending) {
+        roomCount = std::max({ roomCount, e.from + 1, (e.target == None) ? 0 : e.target + 1 });
+    }
+    std::stable_sort(pending.begin(), pending.end(), [](Edit const &a, Edit const &b) {
+        return a.from < b.from;
+    });
+
+    std::vector<uint32_t> newOffsets(roomCount + 1, 0);
+    std::vector<Exit> newExits;
+    newExits.reserve(exits.size() + pending.size());
+
+    auto edit = pending.begin();
+    std::vector<Exit> scratch;
+    for (uint32_t r = 0; r < roomCount; r++) {
+        newOffsets[r] = static_cast<uint32_t>(newExits.size());
+
+        /* untouched rooms get copied straight over */
+        bool hasOld = r + 1 < offsets.size();
+        if (edit == pending.end() || edit->from != r) {
+            if (hasOld) {
+                newExits.insert(newExits.end(), exits.begin() + offsets[r], exits.begin() + offsets[r + 1]);
+            }
+            continue;
+        }
+
+        scratch.clear();
+        if (hasOld) {
+            scratch.assign(exits.begin() + offsets[r], exits.begin() + offsets[r + 1]);
+        }
+        for (; edit != pending.end() && edit->from == r; edit++) {
+            auto label = edit->label;
+            auto it = std::find_if(scratch.begin(), scratch.end(), [label](Exit const &x) { return x.label == label; });
+            if (edit->target == None) {
+                if (it != scratch.end()) {
+                    scratch.erase(it);
+                }
+            } else if (it != scratch.end()) {
+                it->target = edit->target;
+            } else {
+                scratch.push_back(Exit { label, edit->target });
+            }
+        }
+        newExits.insert(newExits.end(), scratch.begin(), scratch.end());
+    }
+    newOffsets[roomCount] = static_cast<uint32_t>(newExits.size());
+
+    offsets = std::move(newOffsets);
+    exits = std::move(newExits);
+    pending.clear();
+}
@@ -0,0 +1,139 @@
+#ifndef __ROOMGRAPH__
+#define __ROOMGRAPH__
+
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "globals.hpp"
+
+/*
+    Every exit between every room, in one compressed (CSR) adjacency array
+    - rooms are referred to by their id (see Collection::GetId)
+    - the exits out of room r are exits[offsets[r] .. offsets[r + 1])
+    - each exit is just (label, target), where label is an interned exit name
+
+    Exit names are interned into labels so an exit is 8 bytes no matter what it's called.
+    The standard directions (see globals.hpp) always get labels 0-7, in enum order,
+    so static_cast<uint32_t>(Direction::Up) is the label for "up".
+    Anything else ("portal", "trapdoor", ...) gets the next free label the first time it's used.
+
+    Changes (SetExit/RemoveExit) are buffered and merged into the arrays the next time
+    anything is read, so linking a whole world at load time is O(rooms + exits) total
+    instead of shifting the arrays on every call.
+
+    A graph can also be an overlay of another one (see the constructor taking a base), which is how
+    every session changes exits without copying the world's: the overlay only stores the rooms whose
+    exits it changed and the labels it added, everything else is read straight from the base.
+*/
+class RoomGraph {
+
+    public:
+
+    /*  one way out of a room  */
+    struct Exit {
+        /*  interned exit name  */
+        uint32_t label;
+        /*  room id on the other side  */
+        uint32_t target;
+    };
+
+    /*  "no room"/"no label" - returned when there's no exit that way or the name is unknown  */
+    static inline constexpr uint32_t None = UINT32_MAX;
+
+    private:
+
+    /*  a change that hasn't been merged into the arrays yet (target = None removes the exit)  */
+    struct Edit {
+        uint32_t from;
+        uint32_t label;
+        uint32_t target;
+    };
+
+    /*  size = number of rooms + 1, exits of room r start at offsets[r]  */
+    std::vector<uint32_t> offsets;
+    /*  every exit, grouped by the room they leave from  */
+    std::vector<Exit> exits;
+    /*  buffered changes, applied in order by Compact()  */
+    std::vector<Edit> pending;
+
+    /*  label -> exit name  */
+    std::vector<std::string> labels;
+    /*  exit name -> label  */
+    std::unordered_map<std::string, uint32_t> labelIds;
+
+    /*  bumped on every change, lets other systems know cached paths are stale  */
+    uint64_t version;
+
+    /*
+        the graph this is an overlay of, nullptr if it's a whole graph of its own
+        in an overlay offsets/exits/pending stay empty, and labels only has the ones
+        this overlay added - their label is labelOffset + index
+    */
+    std::shared_ptr<RoomGraph> base;
+    /*  room id -> every exit out of it, for every room an overlay changed  */
+    std::unordered_map<uint32_t, std::vector<Exit>> changedRooms;
+    /*  number of labels in base, 0 for a whole graph  */
+    uint32_t labelOffset;
+
+    /*  an overlay's SetExit/RemoveExit - copies the room out of base, changes it, drops it again if it's back to base  */
+    void SetOverlayExit(uint32_t from, uint32_t label, uint32_t target);
+
+    public:
+
+    /*  RoomGraph constructor - no rooms, no exits, just the standard labels  */
+    RoomGraph();
+
+    /*
+        an overlay of _base: reads the same as _base until something changes, then stores only the
+        rooms that changed. _base has to be compacted and never change again (it gets read from
+        any number of overlays, on any number of threads). An overlay of an overlay is just a copy of it.
+    */
+    RoomGraph(std::shared_ptr<RoomGraph> _base);
+
+    /*  gets the label for an exit name, adding it if it's new  */
+    uint32_t Intern(std::string_view exitName);
+
+    /*  gets the label for an exit name, or None if nothing has ever used it  */
+    uint32_t FindLabel(std::string_view exitName);
+
+    /*  gets the exit name behind a label  */
+    std::string& GetLabelName(uint32_t label);
+
+    /*  how many labels there are (they go from 0 to GetLabelCount() - 1), counting an overlay's base  */
+    uint32_t GetLabelCount();
+
+    /*  adds (or redirects) the exit with this label out of room "from"  */
+    void SetExit(uint32_t from, uint32_t label, uint32_t target);
+
+    /*  removes the exit with this label out of room "from", if there is one  */
+    void RemoveExit(uint32_t from, uint32_t label);
+
+    /*  the room on the other side of the exit with this label, or None  */
+    uint32_t GetExit(uint32_t from, uint32_t label);
+
+    /*  all exits out of a room  */
+    std::span<Exit> GetExits(uint32_t from);
+
+    /*  how many room ids the graph currently has offsets for  */
+    uint32_t RoomCount();
+
+    /*
+        merges pending changes into offsets/exits - happens by itself the next time anything is read,
+        call it before sharing the graph (reads of a compacted graph don't change anything)
+    */
+    void Compact();
+
+    /*  changes every time an exit is set or removed  */
+    uint64_t GetVersion();
+
+    /*  how many rooms an overlay stores exits for (0 for a whole graph), to see what a session costs  */
+    size_t GetChangedRoomCount();
+
+};
+
+#endif /* __ROOMGRAPH__ */
@@ -0,0 +1,321 @@
+#include "script.hpp"
+
+#include <stdexcept>
+
+#define FMT_HEADER_ONLY
+#include "fmt/core.h"
+
+#include "delta.hpp"
+
+namespace {
+    /*  a word, or a "quoted string" with its escapes already undone  */
+    struct Token {
+        std::string text;
+        bool quoted;
+    };
+
+    struct Line {
+        size_t number;
+        std::vector<Token> tokens;
+    };
+
+    /*  registers the compiler uses - two is all a test needs  */
+    constexpr uint8_t R0 = 0, R1 = 1;
+
+    /*  splits source into lines of tokens, dropping comments and empty lines  */
+    std::vector<Line> Tokenize(std::string_view source) {
+        std::vector<Line> lines;
+        size_t number = 1;
+        Line line { number, {} };
+        for (size_t i = 0; i <= source.size(); ) {
+            char c = (i < source.size()) ? source[i] : '\n';
+            if (c == '#') {
+                /* up to the end of the line, which is handled as usual */
+                while (i < source.size() && source[i] != '\n') {
+                    i++;
+                }
+            } else if (c == '\n') {
+                if (!line.tokens.empty()) {
+                    lines.push_back(std::move(line));
+                }
+                line = Line { ++number, {} };
+                i++;
+            } else if (c == ' ' || c == '\t' || c == '\r') {
+                i++;
+            } else if (c == '"') {
+                Token token { "", true };
+                for (i++; ; i++) {
+                    if (i >= source.size() || source[i] == '\n') {
+                        throw std::invalid_argument(fmt::format("line {}: text without a closing \"", line.number));
+                    }
+                    if (source[i] == '"') {
+                        i++;
+                        break;
+                    }
+                    if (source[i] == '\\' && i + 1 < source.size()) {
+                        i++;
+                        token.text += (source[i] == 'n') ? '\n' : source[i];
+                    } else {
+                        token.text += source[i];
+                    }
+                }
+                line.tokens.push_back(std::move(token));
+            } else {
+                size_t start = i;
+                while (i < source.size() && source[i] != ' ' && source[i] != '\t' && source[i] != '\r' && source[i] != '\n' && source[i] != '#' && source[i] != '"') {
+                    i++;
+                }
+                line.tokens.push_back(Token { std::string(source.substr(start, i - start)), false });
+            }
+        }
+        return lines;
+    }
+
+    class Compiler {
+        public:
+
+        Compiler(std::vector<Line> _lines, Script::Names const& _names, std::vector<Script::Instruction> &_code, std::vector<std::string> &_text)
+            : lines(std::move(_lines)), names(_names), code(_code), text(_text) { }
+
+        void Run() {
+            if (Block() != "") {
+                Fail(lines[next - 1], fmt::format("\"{}\" without an if", lines[next - 1].tokens[0].text));
+            }
+            Emit(Script::Op::End);
+        }
+
+        private:
+
+        std::vector<Line> lines;
+        Script::Names const& names;
+        std::vector<Script::Instruction> &code;
+        std::vector<std::string> &text;
+        /*  next line to compile  */
+        size_t next = 0;
+
+        [[noreturn]] void Fail(Line const& line, std::string const& message) {
+            throw std::invalid_argument(fmt::format("line {}: {}", line.number, message));
+        }
+
+        uint32_t Emit(Script::Op op, uint8_t a = 0, uint8_t b = 0, uint32_t x = 0, uint32_t y = 0) {
+            code.push_back(Script::Instruction { op, a, b, x, y });
+            return static_cast<uint32_t>(code.size() - 1);
+        }
+
+        /*  the token at i, which has to be there  */
+        Token const& At(Line const& line, size_t i, char const *what) {
+            if (i >= line.tokens.size()) {
+                Fail(line, fmt::format("\"{}\" needs {}", line.tokens[0].text, what));
+            }
+            return line.tokens[i];
+        }
+
+        uint32_t Room(Line const& line, size_t i) {
+            auto &token = At(line, i, "a room");
+            uint32_t id = token.quoted ? names.room(token.text) : Delta::Nowhere;
+            if (id == Delta::Nowhere) {
+                Fail(line, fmt::format("there's no room called \"{}\"", token.text));
+            }
+            return id;
+        }
+
+        uint32_t Item(Line const& line, size_t i) {
+            auto &token = At(line, i, "an item");
+            uint32_t id = token.quoted ? names.item(token.text) : Delta::Nowhere;
+            if (id == Delta::Nowhere) {
+                Fail(line, fmt::format("there's no item called \"{}\"", token.text));
+            }
+            return id;
+        }
+
+        uint32_t Label(Line const& line, size_t i) {
+            return names.label(At(line, i, "an exit").text);
+        }
+
+        void Done(Line const& line, size_t count) {
+            if (line.tokens.size() > count) {
+                Fail(line, fmt::format("didn't expect \"{}\"", line.tokens[count].text));
+            }
+        }
+
+        /*  compiles lines until else/end/the end of the script, returns which one it stopped at ("" for the end)  */
+        std::string Block() {
+            while (next < lines.size()) {
+                Line const &line = lines[next++];
+                auto &word = line.tokens[0].text;
+                if (line.tokens[0].quoted) {
+                    Fail(line, "a line has to start with what to do");
+                }
+                if (word == "else" || word == "end") {
+                    Done(line, 1);
+                    return word;
+                }
+                if (word == "if") {
+                    If(line);
+                } else {
+                    Statement(line);
+                }
+            }
+            return "";
+        }
+
+        void If(Line const& line) {
+            /* every test jumps to the else part when it fails */
+            std::vector<uint32_t> toElse;
+            size_t i = 1;
+            while (true) {
+                toElse.push_back(Test(line, i));
+                if (i == line.tokens.size()) {
+                    break;
+                }
+                if (line.tokens[i].quoted || line.tokens[i].text != "and") {
+                    Fail(line, fmt::format("didn't expect \"{}\"", line.tokens[i].text));
+                }
+                i++;
+            }
+
+            std::string stop = Block();
+            if (stop == "") {
+                Fail(line, "if without an end");
+            }
+            uint32_t toEnd = UINT32_MAX;
+            if (stop == "else") {
+                toEnd = Emit(Script::Op::Jump);
+            }
+            for (auto jump : toElse) {
+                code[jump].x = static_cast<uint32_t>(code.size());
+            }
+            if (stop == "else") {
+                if (Block() != "end") {
+                    Fail(line, "if without an end");
+                }
+                code[toEnd].x = static_cast<uint32_t>(code.size());
+            }
+        }
+
+        /*  compiles the test at line.tokens[i], moving i past it, returns the jump to fill in with where to go if it fails  */
+        uint32_t Test(Line const& line, size_t &i) {
+            bool negated = false;
+            if (i < line.tokens.size() && !line.tokens[i].quoted && line.tokens[i].text == "not") {
+                negated = true;
+                i++;
+            }
+            auto &word = At(line, i, "a test").text;
+            /* tests load two registers that are equal when it passes - open is the other way round */
+            bool equalPasses = true;
+            if (word == "holding") {
+                Emit(Script::Op::LoadItem, R0, 0, Item(line, i + 1));
+                Emit(Script::Op::Load, R1, 0, Delta::Inventory);
+                i += 2;
+            } else if (word == "here") {
+                Emit(Script::Op::LoadItem, R0, 0, Item(line, i + 1));
+                Emit(Script::Op::LoadRoom, R1);
+                i += 2;
+            } else if (word == "found") {
+                Emit(Script::Op::LoadFound, R0, 0, Item(line, i + 1));
+                Emit(Script::Op::Load, R1, 0, 1);
+                i += 2;
+            } else if (word == "at") {
+                Emit(Script::Op::LoadItem, R0, 0, Item(line, i + 1));
+                Emit(Script::Op::Load, R1, 0, Room(line, i + 2));
+                i += 3;
+            } else if (word == "in") {
+                Emit(Script::Op::LoadRoom, R0);
+                Emit(Script::Op::Load, R1, 0, Room(line, i + 1));
+                i += 2;
+            } else if (word == "open") {
+                Emit(Script::Op::LoadExit, R0, 0, Room(line, i + 1), Label(line, i + 2));
+                Emit(Script::Op::Load, R1, 0, Delta::Nowhere);
+                equalPasses = false;
+                i += 3;
+            } else {
+                Fail(line, fmt::format("there's no test called \"{}\"", word));
+            }
+            bool jumpIfEqual = (equalPasses == negated);
+            return Emit(jumpIfEqual ? Script::Op::JumpIfEqual : Script::Op::JumpIfNotEqual, R0, R1);
+        }
+
+        void Statement(Line const& line) {
+            auto &word = line.tokens[0].text;
+            if (word == "say") {
+                auto &token = At(line, 1, "some text");
+                Done(line, 2);
+                text.push_back(token.text);
+                Emit(Script::Op::Say, 0, 0, static_cast<uint32_t>(text.size() - 1));
+            } else if (word == "move") {
+                uint32_t item = Item(line, 1);
+                if (At(line, 2, "\"to\"").quoted || line.tokens[2].text != "to") {
+                    Fail(line, "\"move\" needs \"to\" after the item");
+                }
+                auto &where = At(line, 3, "somewhere to move to");
+                if (where.quoted) {
+                    Emit(Script::Op::Load, R0, 0, Room(line, 3));
+                } else if (where.text == "here") {
+                    Emit(Script::Op::LoadRoom, R0);
+                } else if (where.text == "inventory") {
+                    Emit(Script::Op::Load, R0, 0, Delta::Inventory);
+                } else if (where.text == "nowhere") {
+                    Emit(Script::Op::Load, R0, 0, Delta::Nowhere);
+                } else {
+                    Fail(line, fmt::format("can't move things to \"{}\"", where.text));
+                }
+                Done(line, 4);
+                Emit(Script::Op::MoveItem, R0, 0, item);
+            } else if (word == "link") {
+                uint32_t from = Room(line, 1), label = Label(line, 2), to = Room(line, 3);
+                Emit(Script::Op::Load, R0, 0, to);
+                Emit(Script::Op::SetExit, R0, 0, from, label);
+                if (line.tokens.size() > 4) {
+                    Done(line, 5);
+                    Emit(Script::Op::Load, R0, 0, from);
+                    Emit(Script::Op::SetExit, R0, 0, to, Label(line, 4));
+                }
+            } else if (word == "unlink") {
+                uint32_t from = Room(line, 1), label = Label(line, 2);
+                Done(line, 3);
+                Emit(Script::Op::Load, R0, 0, Delta::Nowhere);
+                Emit(Script::Op::SetExit, R0, 0, from, label);
+            } else if (word == "goto") {
+                Emit(Script::Op::Load, R0, 0, Room(line, 1));
+                Done(line, 2);
+                Emit(Script::Op::MoveTo, R0);
+            } else if (word == "reveal" || word == "conceal") {
+                uint32_t item = Item(line, 1);
+                Done(line, 2);
+                Emit(Script::Op::Load, R0, 0, (word == "reveal") ? 1 : 0);
+                Emit(Script::Op::SetFound, R0, 0, item);
+            } else {
+                Fail(line, fmt::format("don't know how to \"{}\"", word));
+            }
+        }
+    };
+}
+
+Script Script::Compile(std::string_view source, Names const& names) {
+    Script script;
+    Compiler(Tokenize(source), names, script.code, script.text).Run();
+    return script;
+}
+
+std::string Script::Quote(std::string_view s) {
+    std::string quoted = "\"";
+    for (char c : s) {
+        if (c == '\n') {
+            quoted += "\\n";
+            continue;
+        }
+        if (c == '"' || c == '\\') {
+            quoted += '\\';
+        }
+        quoted += c;
+    }
+    return quoted + "\"";
+}
+
+std::vector<Script::Instruction> const& Script::GetCode() const {
+    return code;
+}
+
+std::string const& Script::GetText(uint32_t page) const {
+    return text[page];
+}
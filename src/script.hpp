@@ -0,0 +1,112 @@
+#ifndef __SCRIPT__
+#define __SCRIPT__
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/*
+    A compiled special command - what an item does, written as text instead of a C++ lambda:
+
+        if holding "Red Key"
+            move "Red Key" to nowhere
+            link "Bedroom" north "Garden" south
+            say "You unlocked the red door.\n..."
+            say "You can now go north.\n..."
+        else
+            say "You don't have a key!"
+        end
+
+    Statements:
+        say "<text>"                    a page of text (several says show as pages, like Write(vector))
+        move "<item>" to "<room>"       also: to here, to inventory, to nowhere
+        link "<room>" <exit> "<room>" [<exit back>]
+        unlink "<room>" <exit>
+        goto "<room>"                   moves the player
+        reveal "<item>" / conceal "<item>"      sets Item::Attrs::isFound
+        if <test> [and <test>...] ... [else ...] end
+    Tests (each can have "not" in front):
+        holding "<item>"   here "<item>"   found "<item>"   at "<item>" "<room>"
+        in "<room>"        open "<room>" <exit>
+    Names are quoted, exits are words or quoted, # starts a comment.
+
+    Compile() turns that into bytecode for a small register machine once, at load time - every name
+    is looked up then and becomes an id, so running it (TextBasedGame::RunScript) is a loop over a
+    flat array with a handful of registers, with no lookups and nothing allocated by the machine itself.
+    Jumps only ever go forwards, so every script ends.
+*/
+class Script {
+
+    public:
+
+    enum class Op : uint8_t {
+        /*  r[a] = x  */
+        Load,
+        /*  r[a] = the room the player is in  */
+        LoadRoom,
+        /*  r[a] = where item x is (room id, Delta::Inventory or Delta::Nowhere)  */
+        LoadItem,
+        /*  r[a] = item x's isFound, 0/1  */
+        LoadFound,
+        /*  r[a] = where room x's exit labelled y leads (RoomGraph::None if nowhere)  */
+        LoadExit,
+        /*  jump to x if r[a] == r[b] / r[a] != r[b]  */
+        JumpIfEqual,
+        JumpIfNotEqual,
+        /*  jump to x  */
+        Jump,
+        /*  item x goes to location r[a]  */
+        MoveItem,
+        /*  room x's exit labelled y leads to r[a] (RoomGraph::None removes it)  */
+        SetExit,
+        /*  the player goes to room r[a]  */
+        MoveTo,
+        /*  item x's isFound = r[a]  */
+        SetFound,
+        /*  page x of the text is shown  */
+        Say,
+        End
+    };
+
+    /*  one instruction, 12 bytes - which fields mean what depends on op  */
+    struct Instruction {
+        Op op;
+        uint8_t a;
+        uint8_t b;
+        uint32_t x;
+        uint32_t y;
+    };
+
+    static inline constexpr size_t RegisterCount = 8;
+    /*  says after this many pages in one run are dropped  */
+    static inline constexpr size_t MaxPages = 16;
+
+    /*
+        how names turn into ids while compiling - room and item return Delta::Nowhere if there's
+        no such thing, label gets the id of an exit name (adding it if it's new)
+    */
+    struct Names {
+        std::function<uint32_t(std::string const&)> room;
+        std::function<uint32_t(std::string const&)> item;
+        std::function<uint32_t(std::string const&)> label;
+    };
+
+    /*  compiles source, throws std::invalid_argument ("line 3: there's no item called ...") if it's wrong  */
+    static Script Compile(std::string_view source, Names const& names);
+
+    /*  s in quotes, escaped so Compile reads it back as s - for making scripts with fmt::format  */
+    static std::string Quote(std::string_view s);
+
+    std::vector<Instruction> const& GetCode() const;
+    std::string const& GetText(uint32_t page) const;
+
+    private:
+
+    std::vector<Instruction> code;
+    /*  every say's text, Say's x indexes this  */
+    std::vector<std::string> text;
+};
+
+#endif /* __SCRIPT__ */
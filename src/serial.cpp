@@ -0,0 +1,144 @@
+#include "serial.hpp"
+
+#include <cstring>
+
+/* ------- BYTEWRITER ------- */
+
+ByteWriter::ByteWriter() { }
+
+void ByteWriter::U8(uint8_t v) {
+    bytes.push_back(v);
+}
+
+void ByteWriter::U16(uint16_t v) {
+    for (int i = 0; i < 2; i++) {
+        bytes.push_back(static_cast<uint8_t>(v >> (8 * i)));
+    }
+}
+
+void ByteWriter::U32(uint32_t v) {
+    for (int i = 0; i < 4; i++) {
+        bytes.push_back(static_cast<uint8_t>(v >> (8 * i)));
+    }
+}
+
+void ByteWriter::U64(uint64_t v) {
+    for (int i = 0; i < 8; i++) {
+        bytes.push_back(static_cast<uint8_t>(v >> (8 * i)));
+    }
+}
+
+void ByteWriter::Var(uint64_t v) {
+    while (v >= 0x80) {
+        bytes.push_back(static_cast<uint8_t>(v | 0x80));
+        v >>= 7;
+    }
+    bytes.push_back(static_cast<uint8_t>(v));
+}
+
+void ByteWriter::Str(std::string_view s) {
+    Var(s.size());
+    Raw(s.data(), s.size());
+}
+
+void ByteWriter::Raw(const void *data, size_t size) {
+    auto p = static_cast<const uint8_t*>(data);
+    bytes.insert(bytes.end(), p, p + size);
+}
+
+std::vector<uint8_t>& ByteWriter::GetBytes() {
+    return bytes;
+}
+
+void ByteWriter::Clear() {
+    bytes.clear();
+}
+
+/* ------- BYTEREADER ------- */
+
+ByteReader::ByteReader(const uint8_t *_data, size_t _size) {
+    pos = _data;
+    end = _data + _size;
+}
+
+ByteReader::ByteReader(std::vector<uint8_t> const& _bytes) : ByteReader(_bytes.data(), _bytes.size()) { }
+
+void ByteReader::Need(size_t n) {
+    if (static_cast<size_t>(end - pos) < n) {
+        throw FormatError("unexpected end of data");
+    }
+}
+
+uint8_t ByteReader::U8() {
+    Need(1);
+    return *pos++;
+}
+
+uint16_t ByteReader::U16() {
+    Need(2);
+    uint16_t v = static_cast<uint16_t>(pos[0] | (pos[1] << 8));
+    pos += 2;
+    return v;
+}
+
+uint32_t ByteReader::U32() {
+    Need(4);
+    uint32_t v = 0;
+    for (int i = 0; i < 4; i++) {
+        v |= static_cast<uint32_t>(pos[i]) << (8 * i);
+    }
+    pos += 4;
+    return v;
+}
+
+uint64_t ByteReader::U64() {
+    Need(8);
+    uint64_t v = 0;
+    for (int i = 0; i < 8; i++) {
+        v |= static_cast<uint64_t>(pos[i]) << (8 * i);
+    }
+    pos += 8;
+    return v;
+}
+
+uint64_t ByteReader::Var() {
+    uint64_t v = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        uint8_t b = U8();
+        v |= static_cast<uint64_t>(b & 0x7F) << shift;
+        if (!(b & 0x80)) {
+            return v;
+        }
+    }
+    throw FormatError("number too long");
+}
+
+uint32_t ByteReader::Index(uint32_t limit) {
+    uint64_t v = Var();
+    if (v >= limit) {
+        throw FormatError("index out of range");
+    }
+    return static_cast<uint32_t>(v);
+}
+
+std::string ByteReader::Str() {
+    uint64_t len = Var();
+    Need(len);
+    std::string s(reinterpret_cast<const char*>(pos), len);
+    pos += len;
+    return s;
+}
+
+void ByteReader::Raw(void *data, size_t size) {
+    Need(size);
+    std::memcpy(data, pos, size);
+    pos += size;
+}
+
+size_t ByteReader::Remaining() {
+    return static_cast<size_t>(end - pos);
+}
+
+bool ByteReader::AtEnd() {
+    return pos == end;
+}
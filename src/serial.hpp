@@ -0,0 +1,84 @@
+#ifndef __SERIAL__
+#define __SERIAL__
+
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/*
+    Little helpers for compact binary formats (snapshots, journals, ...)
+    Fixed-width numbers are always little-endian no matter the platform,
+    Var() numbers are LEB128 (7 bits per byte) so small ids take 1-3 bytes.
+*/
+
+/*  thrown by ByteReader (and anything parsing with it) when the data doesn't make sense  */
+class FormatError : public std::runtime_error {
+    public:
+    using std::runtime_error::runtime_error;
+};
+
+/*  appends values to a growing byte buffer  */
+class ByteWriter {
+
+    private:
+
+    std::vector<uint8_t> bytes;
+
+    public:
+
+    ByteWriter();
+
+    void U8(uint8_t v);
+    void U16(uint16_t v);
+    void U32(uint32_t v);
+    void U64(uint64_t v);
+    /*  variable length unsigned number, 1 byte for < 128  */
+    void Var(uint64_t v);
+    /*  length (Var) followed by the raw characters  */
+    void Str(std::string_view s);
+    /*  raw bytes, no length  */
+    void Raw(const void *data, size_t size);
+
+    /*  everything written so far  */
+    std::vector<uint8_t>& GetBytes();
+    /*  drops everything written so far, keeps the memory  */
+    void Clear();
+
+};
+
+/*  reads values back out of a byte buffer, throws FormatError if it runs out  */
+class ByteReader {
+
+    private:
+
+    const uint8_t *pos;
+    const uint8_t *end;
+
+    /*  makes sure there are n more bytes  */
+    void Need(size_t n);
+
+    public:
+
+    ByteReader(const uint8_t *_data, size_t _size);
+    ByteReader(std::vector<uint8_t> const& _bytes);
+
+    uint8_t U8();
+    uint16_t U16();
+    uint32_t U32();
+    uint64_t U64();
+    uint64_t Var();
+    /*  Var() that must fit in 32 bits and be below limit  */
+    uint32_t Index(uint32_t limit);
+    std::string Str();
+    void Raw(void *data, size_t size);
+
+    /*  bytes left  */
+    size_t Remaining();
+    /*  no bytes left?  */
+    bool AtEnd();
+
+};
+
+#endif /* __SERIAL__ */
@@ -0,0 +1,599 @@
+#include "server.hpp"
+
+#include <chrono>
+#include <iostream>
+#include <stdexcept>
+
+#include "fmt/format.h"
+
+#if defined(__linux__)
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <cstring>
+#include <fstream>
+
+#if defined(__GLIBC__)
+#include <malloc.h>
+#endif
+
+namespace {
+    /*  how many events one epoll_wait hands back at most  */
+    constexpr int MaxEvents = 256;
+
+    /*  how long epoll_wait sleeps without anything happening, so Stop() gets noticed  */
+    constexpr int WaitMs = 500;
+
+    /*  how often PrintStats runs (if the player count changed)  */
+    constexpr double StatsInterval = 10.0;
+
+    /*  how often Sweep looks for idle sessions  */
+    constexpr double SweepInterval = 1.0;
+
+    std::runtime_error SystemError(std::string const& what) {
+        return std::runtime_error(fmt::format("{}: {}", what, std::strerror(errno)));
+    }
+
+    /*  every player is a file descriptor, the default limit (1024 usually) is way too low  */
+    void RaiseFileLimit() {
+        rlimit limit;
+        if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur < limit.rlim_max) {
+            limit.rlim_cur = limit.rlim_max;
+            setrlimit(RLIMIT_NOFILE, &limit);
+        }
+    }
+
+    /*  resident memory of this process in KB, 0 if unknown  */
+    size_t ResidentKB() {
+        std::ifstream statm("/proc/self/statm");
+        size_t total = 0, resident = 0;
+        if (!(statm >> total >> resident)) {
+            return 0;
+        }
+        return resident * (sysconf(_SC_PAGESIZE) / 1024);
+    }
+}
+
+Server::Server(TextBasedGame &_game, size_t threads) : game(_game), pool(threads) {
+    listenFd = -1;
+    epollFd = -1;
+    wakeFd = -1;
+    connectionCount = 0;
+    busyCount = 0;
+    running = false;
+    idleTimeout = Clock::duration::zero();
+    hibernatedCount = 0;
+    resumeCount = 0;
+    resumeNanoseconds = 0;
+    resumeMaxNanoseconds = 0;
+}
+
+Server::~Server() {
+    for (auto &c : connections) {
+        if (c) {
+            ::close(c->fd);
+        }
+    }
+    if (listenFd >= 0) {
+        ::close(listenFd);
+    }
+    if (epollFd >= 0) {
+        ::close(epollFd);
+    }
+    if (wakeFd >= 0) {
+        ::close(wakeFd);
+    }
+    if (!unixPath.empty()) {
+        ::unlink(unixPath.c_str());
+    }
+}
+
+void Server::Listen(std::string const& address) {
+    RaiseFileLimit();
+
+    if (address.starts_with("unix:")) {
+        unixPath = address.substr(5);
+        sockaddr_un addr = {};
+        addr.sun_family = AF_UNIX;
+        if (unixPath.empty() || unixPath.size() >= sizeof(addr.sun_path)) {
+            throw std::runtime_error(fmt::format("bad socket path '{}'", unixPath));
+        }
+        std::strcpy(addr.sun_path, unixPath.c_str());
+        ::unlink(unixPath.c_str());
+
+        listenFd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (listenFd < 0 || ::bind(listenFd, (sockaddr*)&addr, sizeof(addr)) < 0) {
+            throw SystemError(fmt::format("can't listen on {}", address));
+        }
+    } else {
+        std::string host = "127.0.0.1", port = address;
+        size_t colon = address.rfind(':');
+        if (colon != std::string::npos) {
+            host = address.substr(0, colon);
+            port = address.substr(colon + 1);
+        }
+        sockaddr_in addr = {};
+        addr.sin_family = AF_INET;
+        try {
+            int p = std::stoi(port);
+            if (p < 0 || p > 65535) {
+                throw std::out_of_range(port);
+            }
+            addr.sin_port = htons(p);
+        } catch (std::logic_error &e) {
+            throw std::runtime_error(fmt::format("bad port '{}'", port));
+        }
+        if (::inet_pton(AF_INET, host.c_str(), &addr.sin_addr) != 1) {
+            throw std::runtime_error(fmt::format("bad address '{}'", host));
+        }
+
+        listenFd = ::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        int on = 1;
+        if (listenFd < 0
+            || ::setsockopt(listenFd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on)) < 0
+            || ::bind(listenFd, (sockaddr*)&addr, sizeof(addr)) < 0) {
+            throw SystemError(fmt::format("can't listen on {}", address));
+        }
+    }
+
+    if (::listen(listenFd, SOMAXCONN) < 0) {
+        throw SystemError(fmt::format("can't listen on {}", address));
+    }
+
+    epollFd = ::epoll_create1(EPOLL_CLOEXEC);
+    wakeFd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    epoll_event ev = {};
+    ev.events = EPOLLIN;
+    ev.data.fd = listenFd;
+    epoll_event wakeEv = {};
+    wakeEv.events = EPOLLIN;
+    wakeEv.data.fd = wakeFd;
+    if (epollFd < 0 || wakeFd < 0
+        || ::epoll_ctl(epollFd, EPOLL_CTL_ADD, listenFd, &ev) < 0
+        || ::epoll_ctl(epollFd, EPOLL_CTL_ADD, wakeFd, &wakeEv) < 0) {
+        throw SystemError("epoll");
+    }
+}
+
+void Server::Run() {
+    if (listenFd < 0) {
+        throw std::runtime_error("Run() before Listen()");
+    }
+
+    running = true;
+    epoll_event events[MaxEvents];
+    auto lastStats = Clock::now();
+    lastSweep = lastStats;
+    size_t lastCount = 0, lastHibernated = 0;
+
+    while (running) {
+        int n = ::epoll_wait(epollFd, events, MaxEvents, WaitMs);
+        if (n < 0 && errno != EINTR) {
+            throw SystemError("epoll_wait");
+        }
+
+        for (int i = 0; i < n; i++) {
+            int fd = events[i].data.fd;
+            if (fd == listenFd) {
+                Accept();
+                continue;
+            }
+            if (fd == wakeFd) {
+                Complete();
+                continue;
+            }
+            if (fd >= (int)connections.size() || !connections[fd]) {
+                continue;
+            }
+            Connection &c = *connections[fd];
+            if (events[i].events & (EPOLLERR | EPOLLHUP)) {
+                Close(c);
+                continue;
+            }
+            if (events[i].events & EPOLLOUT) {
+                Send(c);
+            }
+            /* Send() can close it */
+            if ((events[i].events & EPOLLIN) && connections[fd] && !c.dropped) {
+                Receive(c);
+            }
+        }
+
+        auto now = Clock::now();
+        if (store && std::chrono::duration<double>(now - lastSweep).count() >= SweepInterval) {
+            lastSweep = now;
+            Sweep();
+        }
+        if (std::chrono::duration<double>(now - lastStats).count() >= StatsInterval) {
+            lastStats = now;
+            if (connectionCount != lastCount || hibernatedCount != lastHibernated) {
+                lastCount = connectionCount;
+                lastHibernated = hibernatedCount;
+                PrintStats();
+            }
+        }
+    }
+
+    for (auto &c : connections) {
+        if (c) {
+            Close(*c);
+        }
+    }
+    /* the ones still running commands close when they're done */
+    while (busyCount > 0) {
+        ::epoll_wait(epollFd, events, MaxEvents, WaitMs);
+        Complete();
+    }
+}
+
+void Server::Stop() {
+    running = false;
+}
+
+void Server::EnableHibernation(double idleSeconds, std::string const& storePath) {
+    store = std::make_unique<SessionStore>(storePath);
+    idleTimeout = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(idleSeconds));
+}
+
+size_t Server::GetSessionCount() {
+    return connectionCount;
+}
+
+size_t Server::GetHibernatedCount() {
+    return hibernatedCount;
+}
+
+void Server::Accept() {
+    while (true) {
+        int fd = ::accept4(listenFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+                /* out of fds most likely, try again on the next wakeup */
+                std::cerr << fmt::format("accept: {}", std::strerror(errno)) << std::endl;
+            }
+            return;
+        }
+
+        /* a reply is a single write, don't hold it back */
+        int on = 1;
+        ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+
+        epoll_event ev = {};
+        ev.events = EPOLLIN;
+        ev.data.fd = fd;
+        if (::epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &ev) < 0) {
+            ::close(fd);
+            continue;
+        }
+
+        if (fd >= (int)connections.size()) {
+            connections.resize(fd + 1);
+        }
+        connections[fd] = std::make_unique<Connection>();
+        Connection &c = *connections[fd];
+        c.fd = fd;
+        c.session = game.CreateSession();
+        c.lastActive = Clock::now();
+        c.busy = c.exited = c.closing = c.dropped = false;
+        connectionCount++;
+
+        /* same greeting as Init() gives the game's own player */
+        c.pending.push_back("where am i");
+        Schedule(c);
+    }
+}
+
+void Server::Receive(Connection &c) {
+    char buffer[4096];
+    while (true) {
+        ssize_t n = ::recv(c.fd, buffer, sizeof(buffer), 0);
+        if (n == 0) {
+            Close(c);
+            return;
+        }
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                Close(c);
+                return;
+            }
+            break;
+        }
+        c.in.append(buffer, n);
+        if ((size_t)n < sizeof(buffer)) {
+            break;
+        }
+    }
+
+    size_t start = 0, end;
+    while ((end = c.in.find('\n', start)) != std::string::npos) {
+        size_t lineEnd = (end > start && c.in[end - 1] == '\r') ? end - 1 : end;
+        c.pending.push_back(c.in.substr(start, lineEnd - start));
+        start = end + 1;
+    }
+    c.in.erase(0, start);
+    if (start > 0) {
+        c.lastActive = Clock::now();
+    }
+
+    if (c.in.size() > MaxLineLength) {
+        Close(c);
+        return;
+    }
+    /* idle players shouldn't hold on to buffers */
+    if (c.in.empty()) {
+        std::string().swap(c.in);
+    }
+    Schedule(c);
+    UpdateEvents(c);
+}
+
+void Server::Schedule(Connection &c) {
+    if (c.busy || c.closing || c.pending.empty()) {
+        return;
+    }
+    c.busy = true;
+    busyCount++;
+    std::swap(c.batch, c.pending);
+    pool.Submit([this, &c]{ Execute(c); });
+}
+
+void Server::Execute(Connection &c) {
+    if (!c.session) {
+        Resume(c);
+    }
+    for (auto &line : c.batch) {
+        try {
+            game.Eval(*c.session, line);
+        } catch (TextBasedGame::ExitGameException &e) {
+            c.exited = true;
+        }
+        for (auto &l : c.session->output) {
+            c.reply += l;
+            c.reply += '\n';
+        }
+        if (c.exited) {
+            break;
+        }
+        c.reply += Prompt;
+    }
+    std::vector<std::string>().swap(c.batch);
+    std::vector<std::string>().swap(c.session->output);
+
+    {
+        std::lock_guard<std::mutex> lock(doneMutex);
+        done.push_back(&c);
+    }
+    uint64_t one = 1;
+    [[maybe_unused]] auto written = ::write(wakeFd, &one, sizeof(one));
+}
+
+void Server::Complete() {
+    uint64_t count;
+    [[maybe_unused]] auto read = ::read(wakeFd, &count, sizeof(count));
+
+    std::vector<Connection*> finished;
+    {
+        std::lock_guard<std::mutex> lock(doneMutex);
+        std::swap(finished, done);
+    }
+
+    for (auto *c : finished) {
+        c->busy = false;
+        busyCount--;
+        if (c->dropped) {
+            Close(*c);
+            continue;
+        }
+        c->out += c->reply;
+        std::string().swap(c->reply);
+        if (c->exited) {
+            c->closing = true;
+            std::vector<std::string>().swap(c->pending);
+        }
+
+        int fd = c->fd;
+        Send(*c);
+        /* Send() can close it */
+        if (connections[fd]) {
+            Schedule(*c);
+            UpdateEvents(*c);
+        }
+    }
+}
+
+void Server::Send(Connection &c) {
+    size_t sent = 0;
+    while (sent < c.out.size()) {
+        ssize_t n = ::send(c.fd, c.out.data() + sent, c.out.size() - sent, MSG_NOSIGNAL);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                Close(c);
+                return;
+            }
+            break;
+        }
+        sent += n;
+    }
+    c.out.erase(0, sent);
+
+    if (c.out.empty()) {
+        if (c.closing) {
+            Close(c);
+            return;
+        }
+        std::string().swap(c.out);
+    }
+    UpdateEvents(c);
+}
+
+void Server::UpdateEvents(Connection &c) {
+    epoll_event ev = {};
+    ev.data.fd = c.fd;
+    if (!c.out.empty()) {
+        /* stop reading until the player takes their output */
+        ev.events = EPOLLOUT;
+    } else if (!c.closing && c.pending.size() < MaxPendingLines) {
+        ev.events = EPOLLIN;
+    }
+    ::epoll_ctl(epollFd, EPOLL_CTL_MOD, c.fd, &ev);
+}
+
+void Server::Close(Connection &c) {
+    int fd = c.fd;
+    ::epoll_ctl(epollFd, EPOLL_CTL_DEL, fd, nullptr);
+    /* a worker still has it, keep the fd (and the slot) until it's done */
+    if (c.busy) {
+        c.dropped = true;
+        return;
+    }
+    if (!c.session) {
+        store->Drop(c.storeKey);
+        hibernatedCount--;
+    }
+    ::close(fd);
+    connections[fd].reset();
+    connectionCount--;
+}
+
+void Server::Sweep() {
+    auto now = Clock::now();
+    size_t hibernated = 0;
+    ByteWriter out;
+    for (auto &c : connections) {
+        if (!c || !c->session || c->busy || c->closing || !c->pending.empty() || now - c->lastActive < idleTimeout) {
+            continue;
+        }
+        /* flows (the exit menu, talking to someone) can't be saved - they stay in memory until they're done */
+        if (c->session->flow.IsWaiting()) {
+            continue;
+        }
+        out.Clear();
+        game.Hibernate(*c->session, out);
+        try {
+            c->storeKey = store->Put(out.GetBytes());
+        } catch (std::runtime_error &e) {
+            /* disk full or so, just keep it in memory */
+            std::cerr << e.what() << std::endl;
+            return;
+        }
+        c->session.reset();
+        /* and whatever the buffers grew to while they were playing */
+        std::vector<std::string>().swap(c->pending);
+        std::vector<std::string>().swap(c->batch);
+        std::string().swap(c->reply);
+        if (c->out.empty()) {
+            std::string().swap(c->out);
+        }
+        hibernatedCount++;
+        hibernated++;
+    }
+#if defined(__GLIBC__)
+    /* lots of small frees don't give memory back by themselves */
+    if (hibernated > 0) {
+        malloc_trim(0);
+    }
+#endif
+}
+
+void Server::Resume(Connection &c) {
+    auto start = Clock::now();
+    try {
+        auto bytes = store->Take(c.storeKey);
+        ByteReader in(bytes);
+        c.session = game.Rehydrate(in);
+    } catch (std::exception &e) {
+        /* FormatError, the store's runtime_error or out_of_range - shouldn't happen, but don't take the server down */
+        std::cerr << fmt::format("couldn't resume a session: {}", e.what()) << std::endl;
+        c.session = game.CreateSession();
+        c.reply += "Your game couldn't be restored, starting over.\n";
+    }
+    hibernatedCount--;
+
+    uint64_t ns = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+    resumeCount++;
+    resumeNanoseconds += ns;
+    uint64_t max = resumeMaxNanoseconds;
+    while (ns > max && !resumeMaxNanoseconds.compare_exchange_weak(max, ns)) { }
+}
+
+void Server::PrintStats() {
+    std::string line = fmt::format("{} players, {} KB resident", connectionCount, ResidentKB());
+    if (store) {
+        line += fmt::format(", {} hibernated ({} KB on disk)", hibernatedCount.load(), store->GetFileSize() / 1024);
+        if (resumeCount > 0) {
+            line += fmt::format(", resume avg {:.0f} us max {:.0f} us",
+                resumeNanoseconds / 1000.0 / resumeCount, resumeMaxNanoseconds / 1000.0);
+        }
+    }
+    std::cout << line << std::endl;
+}
+
+#else
+
+Server::Server(TextBasedGame &_game, size_t threads) : game(_game), pool(threads) {
+    listenFd = -1;
+    epollFd = -1;
+    wakeFd = -1;
+    connectionCount = 0;
+    busyCount = 0;
+    running = false;
+    idleTimeout = Clock::duration::zero();
+    hibernatedCount = 0;
+    resumeCount = 0;
+    resumeNanoseconds = 0;
+    resumeMaxNanoseconds = 0;
+}
+
+Server::~Server() {}
+
+void Server::Listen(std::string const& address) {
+    throw std::runtime_error(fmt::format("can't listen on {}: the server needs linux (epoll)", address));
+}
+
+void Server::Run() {
+    throw std::runtime_error("Run() before Listen()");
+}
+
+void Server::Stop() {
+    running = false;
+}
+
+void Server::EnableHibernation(double, std::string const&) {}
+
+size_t Server::GetSessionCount() {
+    return 0;
+}
+
+size_t Server::GetHibernatedCount() {
+    return 0;
+}
+
+void Server::Accept() {}
+void Server::Receive(Connection&) {}
+void Server::Schedule(Connection&) {}
+void Server::Execute(Connection&) {}
+void Server::Complete() {}
+void Server::Send(Connection&) {}
+void Server::UpdateEvents(Connection&) {}
+void Server::Close(Connection&) {}
+void Server::Sweep() {}
+void Server::Resume(Connection&) {}
+void Server::PrintStats() {}
+
+#endif
@@ -0,0 +1,201 @@
+#ifndef __SERVER__
+#define __SERVER__
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "sessionstore.hpp"
+#include "textbasedgame.hpp"
+#include "threadpool.hpp"
+
+/*
+    Lets lots of people play the same world at once, over TCP or a unix socket
+
+    Every connection gets its own TextBasedGame::Session, the world (rooms, items, commands,
+    the starting exits) is shared by all of them, so an idle player costs a couple of KB
+
+    The protocol is plain lines of text, so telnet/nc work as clients:
+        server: "You are in the kitchen.\n> "
+        client: "go north\n"
+        server: "You went north...\n> "
+    One command at a time per connection, the output of a command always comes back in one piece
+    followed by the "> " prompt
+
+    One thread does all the socket work (one epoll loop, linux only - Listen() throws anywhere else),
+    commands run on a ThreadPool. A session only ever has one task in the pool, which runs every
+    line that came in for it so far, in order - anything arriving meanwhile waits for the next one -
+    so no session is on two threads at once and replies come back in the order they were typed
+
+    With EnableHibernation(), sessions nobody has typed into for a while are written to a
+    SessionStore and dropped from memory, and read back in by the next command they get -
+    so memory follows the players who are actually playing, not everyone who's connected
+*/
+class Server {
+
+    public:
+
+    /*  what's sent after every response, and on connecting  */
+    static inline std::string Prompt = "> ";
+
+    /*  a connection that sends a line longer than this gets dropped  */
+    static constexpr size_t MaxLineLength = 4096;
+
+    /*  stop reading from a connection with this many commands waiting to run  */
+    static constexpr size_t MaxPendingLines = 64;
+
+    /*
+        the game has to be Init()-ed already, and outlive the server
+        threads: how many threads run commands, 0 = one per core
+    */
+    Server(TextBasedGame &game, size_t threads = 0);
+    ~Server();
+
+    /*
+        starts listening, address is one of:
+            "4000"                 - TCP on localhost
+            "0.0.0.0:4000"         - TCP on any IPv4 address
+            "unix:/tmp/tbg.sock"   - unix socket (an old socket file there gets removed)
+        throws std::runtime_error if that doesn't work
+    */
+    void Listen(std::string const& address);
+
+    /*  serves everyone until Stop(), then closes every connection  */
+    void Run();
+
+    /*  makes Run() return - safe to call from a signal handler  */
+    void Stop();
+
+    /*
+        puts sessions that haven't had a command for idleSeconds into a store at storePath
+        (call before Run()), throws std::runtime_error if the store can't be created
+    */
+    void EnableHibernation(double idleSeconds, std::string const& storePath);
+
+    /*  how many players are connected right now  */
+    size_t GetSessionCount();
+
+    /*  how many of them are hibernated  */
+    size_t GetHibernatedCount();
+
+    private:
+
+    using Clock = std::chrono::steady_clock;
+
+    /*
+        everything but session/storeKey/batch/reply/exited belongs to the socket thread,
+        those belong to whoever runs the session's task while busy is set
+    */
+    struct Connection {
+        int fd;
+
+        /*  this player's game, nullptr while hibernated  */
+        std::unique_ptr<TextBasedGame::Session> session;
+
+        /*  where the session is in the store while hibernated  */
+        uint64_t storeKey;
+
+        /*  when the last command came in  */
+        Clock::time_point lastActive;
+
+        /*  what's been read but isn't a whole line yet  */
+        std::string in;
+
+        /*  whole lines waiting for the next task  */
+        std::vector<std::string> pending;
+
+        /*  the lines the current task runs, and what they printed  */
+        std::vector<std::string> batch;
+        std::string reply;
+
+        /*  what's waiting to be sent  */
+        std::string out;
+
+        /*  the session has a task in the pool  */
+        bool busy;
+
+        /*  said "quit" (set by the task, picked up as closing)  */
+        bool exited;
+
+        /*  said "quit" - close once out is sent  */
+        bool closing;
+
+        /*  went away while busy - closed once the task is done  */
+        bool dropped;
+    };
+
+    TextBasedGame &game;
+
+    /*  -1 if not listening  */
+    int listenFd;
+    int epollFd;
+
+    /*  removed when the server stops, "" for TCP  */
+    std::string unixPath;
+
+    /*  indexed by fd, fds are small and reused so this stays dense  */
+    std::vector<std::unique_ptr<Connection>> connections;
+    size_t connectionCount;
+
+    std::atomic<bool> running;
+
+    /*  finished tasks, handed back to the socket thread through wakeFd (an eventfd)  */
+    std::mutex doneMutex;
+    std::vector<Connection*> done;
+    int wakeFd;
+
+    /*  connections with a task in the pool  */
+    size_t busyCount;
+
+    /*  hibernated sessions, nullptr if hibernation is off  */
+    std::unique_ptr<SessionStore> store;
+    Clock::duration idleTimeout;
+    Clock::time_point lastSweep;
+    std::atomic<size_t> hibernatedCount;
+
+    /*  time taken to bring sessions back, for PrintStats  */
+    std::atomic<uint64_t> resumeCount;
+    std::atomic<uint64_t> resumeNanoseconds;
+    std::atomic<uint64_t> resumeMaxNanoseconds;
+
+    /*  after connections, so it's destroyed (and its tasks finished) before them  */
+    ThreadPool pool;
+
+    /*  accepts every connection that's waiting  */
+    void Accept();
+
+    /*  reads what's there, queues every whole line  */
+    void Receive(Connection &c);
+
+    /*  hands the pending lines to the pool, unless the session's already in there  */
+    void Schedule(Connection &c);
+
+    /*  the task - runs the batch on some worker, output + prompt for every line ends up in reply  */
+    void Execute(Connection &c);
+
+    /*  takes back every finished task, sends what they printed  */
+    void Complete();
+
+    /*  sends as much of c.out as the socket takes  */
+    void Send(Connection &c);
+
+    /*  what epoll should wait for on c: output to go out, or room for more commands  */
+    void UpdateEvents(Connection &c);
+
+    /*  hibernates every session that's been idle long enough, except ones a flow is waiting in (snapshots don't keep flows)  */
+    void Sweep();
+
+    /*  brings c's session back from the store, on whichever thread runs its task  */
+    void Resume(Connection &c);
+
+    void Close(Connection &c);
+
+    /*  prints how many players there are and what they cost, every so often  */
+    void PrintStats();
+};
+
+#endif
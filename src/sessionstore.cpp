@@ -0,0 +1,157 @@
+#include "sessionstore.hpp"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cstring>
+#include <stdexcept>
+
+namespace {
+    /*  don't bother compacting files smaller than this  */
+    constexpr uint64_t MinCompactSize = 1 << 20;
+
+    /*  pwrite/pread until everything's done, false on errors  */
+    bool WriteAll(int fd, const uint8_t *data, size_t size, uint64_t offset) {
+        while (size > 0) {
+            ssize_t n = ::pwrite(fd, data, size, offset);
+            if (n < 0 && errno == EINTR) {
+                continue;
+            }
+            if (n <= 0) {
+                return false;
+            }
+            data += n;
+            size -= n;
+            offset += n;
+        }
+        return true;
+    }
+
+    bool ReadAll(int fd, uint8_t *data, size_t size, uint64_t offset) {
+        while (size > 0) {
+            ssize_t n = ::pread(fd, data, size, offset);
+            if (n < 0 && errno == EINTR) {
+                continue;
+            }
+            if (n <= 0) {
+                return false;
+            }
+            data += n;
+            size -= n;
+            offset += n;
+        }
+        return true;
+    }
+}
+
+SessionStore::SessionStore(std::string _path) {
+    path = _path;
+    fileSize = 0;
+    holes = 0;
+    nextKey = 0;
+    fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+    if (fd < 0) {
+        throw std::runtime_error("can't create " + path + ": " + std::strerror(errno));
+    }
+}
+
+SessionStore::~SessionStore() {
+    ::close(fd);
+    ::unlink(path.c_str());
+}
+
+uint64_t SessionStore::Put(std::vector<uint8_t> const& bytes) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!WriteAll(fd, bytes.data(), bytes.size(), fileSize)) {
+        throw std::runtime_error("can't write " + path + ": " + std::strerror(errno));
+    }
+    uint64_t key = nextKey++;
+    entries.emplace(key, Entry { fileSize, static_cast<uint32_t>(bytes.size()) });
+    fileSize += bytes.size();
+    return key;
+}
+
+std::vector<uint8_t> SessionStore::Take(uint64_t key) {
+    std::lock_guard<std::mutex> lock(mutex);
+    Entry entry = entries.at(key);
+    entries.erase(key);
+
+    std::vector<uint8_t> bytes(entry.size);
+    bool ok = ReadAll(fd, bytes.data(), bytes.size(), entry.offset);
+    Forget(entry);
+
+    if (!ok) {
+        throw std::runtime_error("can't read " + path);
+    }
+    return bytes;
+}
+
+void SessionStore::Drop(uint64_t key) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = entries.find(key);
+    if (it == entries.end()) {
+        return;
+    }
+    Entry entry = it->second;
+    entries.erase(it);
+    Forget(entry);
+}
+
+void SessionStore::Forget(Entry entry) {
+    holes += entry.size;
+    if (entries.empty()) {
+        /* nothing left, start over at the beginning */
+        if (::ftruncate(fd, 0) == 0) {
+            fileSize = 0;
+            holes = 0;
+        }
+    } else if (fileSize > MinCompactSize && holes > fileSize / 2) {
+        Compact();
+    }
+}
+
+size_t SessionStore::GetCount() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return entries.size();
+}
+
+uint64_t SessionStore::GetFileSize() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return fileSize;
+}
+
+void SessionStore::Compact() {
+    std::string tmpPath = path + ".tmp";
+    int tmp = ::open(tmpPath.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+    if (tmp < 0) {
+        return;
+    }
+
+    std::vector<uint8_t> buffer;
+    uint64_t offset = 0;
+    std::unordered_map<uint64_t, Entry> moved;
+    moved.reserve(entries.size());
+    for (auto &[key, entry] : entries) {
+        buffer.resize(entry.size);
+        if (!ReadAll(fd, buffer.data(), buffer.size(), entry.offset) || !WriteAll(tmp, buffer.data(), buffer.size(), offset)) {
+            /* keep the old file, try again later */
+            ::close(tmp);
+            ::unlink(tmpPath.c_str());
+            return;
+        }
+        moved.emplace(key, Entry { offset, entry.size });
+        offset += entry.size;
+    }
+
+    if (::rename(tmpPath.c_str(), path.c_str()) != 0) {
+        ::close(tmp);
+        ::unlink(tmpPath.c_str());
+        return;
+    }
+    ::close(fd);
+    fd = tmp;
+    entries = std::move(moved);
+    fileSize = offset;
+    holes = 0;
+}
@@ -0,0 +1,78 @@
+#ifndef __SESSIONSTORE__
+#define __SESSIONSTORE__
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/*
+    Where the server puts hibernated sessions (see Server, TextBasedGame::Hibernate) -
+    blobs are appended to one file and found again through an index in memory,
+    so a hibernated player costs ~40 bytes of memory plus whatever their blob takes on disk
+
+    Taken blobs leave holes, the file gets rewritten without them once more than half of it is holes.
+    Nothing here survives a restart (the players' connections don't either), so there's no fsync
+    and the file is removed when the store goes away.
+
+    Put/Take can be called from any thread.
+*/
+class SessionStore {
+
+    public:
+
+    /*  creates (or empties) the file, throws std::runtime_error if it can't  */
+    SessionStore(std::string _path);
+    ~SessionStore();
+
+    SessionStore(SessionStore const&) = delete;
+    SessionStore& operator=(SessionStore const&) = delete;
+
+    /*  stores a blob, returns the key to Take() it back with, throws std::runtime_error if the write fails  */
+    uint64_t Put(std::vector<uint8_t> const& bytes);
+
+    /*
+        reads a blob back and forgets it
+        throws std::out_of_range for a key that isn't in the store, std::runtime_error if the read fails
+    */
+    std::vector<uint8_t> Take(uint64_t key);
+
+    /*  forgets a blob without reading it, unknown keys are ignored  */
+    void Drop(uint64_t key);
+
+    /*  how many blobs are stored  */
+    size_t GetCount();
+
+    /*  bytes in the file, holes included  */
+    uint64_t GetFileSize();
+
+    private:
+
+    struct Entry {
+        uint64_t offset;
+        uint32_t size;
+    };
+
+    std::string path;
+    int fd;
+
+    /*  end of the file, where the next blob goes  */
+    uint64_t fileSize;
+    /*  bytes of the file that belong to taken blobs  */
+    uint64_t holes;
+
+    uint64_t nextKey;
+    std::unordered_map<uint64_t, Entry> entries;
+
+    /*  guards everything above, file access included (Compact swaps the file)  */
+    std::mutex mutex;
+
+    /*  marks a forgotten blob's bytes as a hole, compacting if there are enough, call with mutex held  */
+    void Forget(Entry entry);
+
+    /*  rewrites the file with just the stored blobs, call with mutex held  */
+    void Compact();
+};
+
+#endif
@@ -0,0 +1,337 @@
+#include "snapshot.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+
+#include "textbasedgame.hpp"
+
+namespace {
+    constexpr uint8_t ItemFoundBit = 1 << 0;
+    constexpr uint8_t ItemCarryBit = 1 << 1;
+
+    /*  FNV-1a  */
+    void HashBytes(uint64_t &h, std::string_view s) {
+        for (unsigned char c : s) {
+            h = (h ^ c) * 0x100000001B3ull;
+        }
+        h = (h ^ 0xFF) * 0x100000001B3ull;
+    }
+}
+
+uint64_t Snapshot::Fingerprint(TextBasedGame& game) {
+    if (game.worldFingerprint != 0) {
+        return game.worldFingerprint;
+    }
+    uint64_t h = 0xCBF29CE484222325ull;
+    for (auto& [name, _] : game.rooms) {
+        HashBytes(h, name);
+    }
+    for (auto& [name, _] : game.items) {
+        HashBytes(h, name);
+    }
+    /* 0 means "not worked out yet" */
+    game.worldFingerprint = (h == 0) ? 1 : h;
+    return game.worldFingerprint;
+}
+
+void Snapshot::Write(TextBasedGame& game, ByteWriter& out) {
+    /* roughly 1-3 bytes per room and item */
+    out.GetBytes().reserve(out.GetBytes().size() + 2 * game.rooms.Size() + 3 * game.items.Size() + 64);
+    out.Raw(Magic, sizeof(Magic));
+    out.U16(Version);
+    out.U64(Fingerprint(game));
+
+    out.Var(game.rooms.Size());
+    out.Var(game.items.Size());
+    auto &session = *game.Current();
+    out.Var(session.currentRoom);
+
+    auto &inv = session.player.GetInventory();
+    out.Var(inv.size());
+    for (auto itemId : inv) {
+        out.Var(itemId);
+    }
+
+    for (uint32_t r = 0; r < session.roomItems.Size(); r++) {
+        auto &roomItems = session.roomItems.Get(r);
+        out.Var(roomItems.size());
+        for (auto itemId : roomItems) {
+            out.Var(itemId);
+        }
+    }
+
+    uint32_t itemId = 0;
+    for (auto& [_, item] : game.items) {
+        out.U8((session.itemFound.Get(itemId++) ? ItemFoundBit : 0) | (item.GetFlags().canCarry ? ItemCarryBit : 0));
+    }
+
+    out.Var(session.dynamicLinks.size());
+    for (auto &link : session.dynamicLinks) {
+        out.Var(link.from);
+        out.Str(session.roomGraph->GetLabelName(link.label));
+        /* +1 so a removed exit (None) is 0 */
+        out.Var(static_cast<uint32_t>(link.target + 1));
+    }
+
+    out.Var(session.turn);
+}
+
+void Snapshot::Read(TextBasedGame& game, ByteReader& in) {
+    char magic[sizeof(Magic)];
+    in.Raw(magic, sizeof(magic));
+    if (!std::equal(std::begin(magic), std::end(magic), std::begin(Magic))) {
+        throw FormatError("not a snapshot");
+    }
+    uint16_t version = in.U16();
+    if (version != Version && version != 2) {
+        throw FormatError("unsupported snapshot version");
+    }
+    if (in.U64() != Fingerprint(game) || in.Var() != game.rooms.Size() || in.Var() != game.items.Size()) {
+        throw FormatError("snapshot is from a different world");
+    }
+
+    /* parse everything first, so a damaged snapshot can't leave the game half loaded */
+
+    uint32_t roomCount = game.rooms.Size(), itemCount = game.items.Size();
+    uint32_t currentRoom = in.Index(roomCount);
+
+    std::vector<uint32_t> inventory(in.Index(itemCount + 1));
+    for (auto &id : inventory) {
+        id = in.Index(itemCount);
+    }
+
+    /* room items, flattened: items of room r are roomItems[roomOffsets[r] .. roomOffsets[r + 1]) */
+    std::vector<uint32_t> roomOffsets(roomCount + 1, 0), roomItems;
+    for (uint32_t r = 0; r < roomCount; r++) {
+        uint32_t count = in.Index(itemCount + 1);
+        for (uint32_t i = 0; i < count; i++) {
+            roomItems.push_back(in.Index(itemCount));
+        }
+        roomOffsets[r + 1] = static_cast<uint32_t>(roomItems.size());
+    }
+
+    std::vector<uint8_t> itemBits(itemCount);
+    in.Raw(itemBits.data(), itemBits.size());
+
+    struct Link {
+        uint32_t from;
+        std::string exitName;
+        uint32_t to;
+    };
+    /* every link takes at least 3 bytes, don't trust a count bigger than what's left */
+    std::vector<Link> links(in.Index(static_cast<uint32_t>(std::min<size_t>(in.Remaining(), UINT32_MAX - 1)) + 1));
+    for (auto &link : links) {
+        link.from = in.Index(roomCount);
+        link.exitName = in.Str();
+        uint32_t to = in.Index(roomCount + 1);
+        link.to = (to == 0) ? RoomGraph::None : to - 1;
+    }
+
+    uint32_t turn = (version >= 3) ? in.Index(UINT32_MAX) : 0;
+
+    if (!in.AtEnd()) {
+        throw FormatError("trailing data after snapshot");
+    }
+
+    /* apply */
+
+    auto &session = *game.Current();
+    session.currentRoom = currentRoom;
+
+    session.player.GetInventory() = std::move(inventory);
+
+    for (uint32_t r = 0; r < roomCount; r++) {
+        session.roomItems.Set(r, std::vector<uint32_t>(roomItems.begin() + roomOffsets[r], roomItems.begin() + roomOffsets[r + 1]));
+    }
+
+    /* canCarry is part of the world, the same for every player - it's only saved to keep the format */
+    for (uint32_t i = 0; i < itemCount; i++) {
+        session.itemFound.Set(i, (itemBits[i] & ItemFoundBit) ? 1 : 0);
+    }
+
+    game.RebuildItemLocations();
+
+    /* the links are what the save had, not new changes - they go straight into the graph (no undo, no Record) */
+    game.RevertDynamicLinks();
+    if (!links.empty()) {
+        auto &graph = game.MutableRoomGraph();
+        for (auto &link : links) {
+            uint32_t label = graph.Intern(link.exitName);
+            game.RememberLink(link.from, label, link.to);
+            if (link.to == RoomGraph::None) {
+                graph.RemoveExit(link.from, label);
+            } else {
+                graph.SetExit(link.from, label, link.to);
+            }
+        }
+    }
+
+    game.SetTurn(turn);
+}
+
+void Snapshot::WriteSession(TextBasedGame& game, ByteWriter& out) {
+    auto &session = *game.Current();
+    out.Raw(SessionMagic, sizeof(SessionMagic));
+    out.U16(SessionVersion);
+    out.U64(Fingerprint(game));
+
+    /* flows (the exit menu, conversations) aren't saved, the session comes back playing */
+    out.U8(static_cast<uint8_t>(session.state));
+    out.Var(session.currentRoom);
+    out.Var(session.turn);
+
+    auto &inv = session.player.GetInventory();
+    out.Var(inv.size());
+    for (auto itemId : inv) {
+        out.Var(itemId);
+    }
+
+    out.Var(session.roomItems.GetChangeCount());
+    for (auto &[roomId, roomItems] : session.roomItems.GetChanges()) {
+        out.Var(roomId);
+        out.Var(roomItems.size());
+        for (auto itemId : roomItems) {
+            out.Var(itemId);
+        }
+    }
+
+    out.Var(session.itemFound.GetChangeCount());
+    for (auto &[itemId, found] : session.itemFound.GetChanges()) {
+        out.Var(itemId);
+        out.U8(found);
+    }
+
+    out.Var(session.itemLocations.GetChangeCount());
+    for (auto &[itemId, location] : session.itemLocations.GetChanges()) {
+        out.Var(itemId);
+        out.Var(static_cast<uint32_t>(location + 2));
+    }
+
+    uint32_t baseLabels = game.worldTemplate.roomGraph->GetLabelCount(), labels = session.roomGraph->GetLabelCount();
+    out.Var(labels - baseLabels);
+    for (uint32_t label = baseLabels; label < labels; label++) {
+        out.Str(session.roomGraph->GetLabelName(label));
+    }
+
+    out.Var(session.dynamicLinks.size());
+    for (auto &link : session.dynamicLinks) {
+        out.Var(link.from);
+        out.Var(link.label);
+        out.Var(static_cast<uint32_t>(link.target + 1));
+        out.Var(static_cast<uint32_t>(link.previous + 1));
+    }
+
+    session.undoLog.Write(out);
+}
+
+void Snapshot::ReadSession(TextBasedGame& game, ByteReader& in) {
+    char magic[sizeof(SessionMagic)];
+    in.Raw(magic, sizeof(magic));
+    if (!std::equal(std::begin(magic), std::end(magic), std::begin(SessionMagic))) {
+        throw FormatError("not a session");
+    }
+    if (in.U16() != SessionVersion) {
+        throw FormatError("unsupported session version");
+    }
+    if (in.U64() != Fingerprint(game)) {
+        throw FormatError("session is from a different world");
+    }
+
+    auto &session = *game.Current();
+    uint32_t roomCount = game.rooms.Size(), itemCount = game.items.Size();
+    /* every entry takes at least a byte, don't trust a count bigger than what's left */
+    auto count = [&in]{ return in.Index(static_cast<uint32_t>(std::min<size_t>(in.Remaining(), UINT32_MAX - 1)) + 1); };
+
+    /* 2 was the exit menu, which is a flow now and isn't saved - back to playing */
+    uint8_t state = in.U8();
+    if (state > 2) {
+        throw FormatError("bad game state");
+    }
+    session.state = (state == TextBasedGame::GameState::Loading) ? TextBasedGame::GameState::Loading : TextBasedGame::GameState::Playing;
+    session.currentRoom = in.Index(roomCount);
+    uint32_t turn = in.Index(UINT32_MAX);
+
+    auto &inv = session.player.GetInventory();
+    inv.resize(count());
+    for (auto &id : inv) {
+        id = in.Index(itemCount);
+    }
+
+    for (uint32_t n = count(); n > 0; n--) {
+        uint32_t roomId = in.Index(roomCount);
+        std::vector<uint32_t> roomItems(count());
+        for (auto &id : roomItems) {
+            id = in.Index(itemCount);
+        }
+        session.roomItems.Set(roomId, std::move(roomItems));
+    }
+
+    for (uint32_t n = count(); n > 0; n--) {
+        uint32_t itemId = in.Index(itemCount);
+        session.itemFound.Set(itemId, in.U8() ? 1 : 0);
+    }
+
+    for (uint32_t n = count(); n > 0; n--) {
+        uint32_t itemId = in.Index(itemCount);
+        session.itemLocations.Set(itemId, in.Index(roomCount + 2) - 2);
+    }
+
+    /* added labels and links go straight into the graph, they're not new changes (no undo, no Record) */
+    std::vector<std::string> labelNames(count());
+    for (auto &name : labelNames) {
+        name = in.Str();
+    }
+    std::vector<TextBasedGame::DynamicLink> links(count());
+    for (auto &link : links) {
+        link.from = in.Index(roomCount);
+        link.label = in.Index(UINT32_MAX);
+        link.target = in.Index(roomCount + 1) - 1;
+        link.previous = in.Index(roomCount + 1) - 1;
+    }
+    if (!labelNames.empty() || !links.empty()) {
+        auto &graph = game.MutableRoomGraph();
+        for (auto &name : labelNames) {
+            graph.Intern(name);
+        }
+        for (auto &link : links) {
+            if (link.label >= graph.GetLabelCount()) {
+                throw FormatError("bad exit label");
+            }
+            if (link.target == RoomGraph::None) {
+                graph.RemoveExit(link.from, link.label);
+            } else {
+                graph.SetExit(link.from, link.label, link.target);
+            }
+        }
+        session.dynamicLinks = std::move(links);
+    }
+
+    session.undoLog.Read(in);
+
+    if (!in.AtEnd()) {
+        throw FormatError("trailing data after session");
+    }
+    game.SetTurn(turn);
+}
+
+bool Snapshot::SaveFile(TextBasedGame& game, std::string const& path) {
+    ByteWriter out;
+    Write(game, out);
+    auto &bytes = out.GetBytes();
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file.write(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+    return file.good();
+}
+
+bool Snapshot::LoadFile(TextBasedGame& game, std::string const& path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        return false;
+    }
+    std::vector<uint8_t> bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    ByteReader in(bytes);
+    Read(game, in);
+    return true;
+}
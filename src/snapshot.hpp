@@ -0,0 +1,92 @@
+#ifndef __SNAPSHOT__
+#define __SNAPSHOT__
+
+#include <cstdint>
+#include <string>
+
+#include "serial.hpp"
+
+class TextBasedGame;
+
+/*
+    Saves and loads everything about a game that can change while playing (its current session),
+    as one compact binary blob. The world itself (room/item definitions, messages, commands)
+    is not saved, it gets rebuilt by Init() - a snapshot only fits the world it was made from,
+    which is checked with a fingerprint of every room and item name.
+
+    Format (version 3), Var = LEB128 number, ids are Collection ids:
+        "TBGS"  version:U16  fingerprint:U64
+        roomCount:Var  itemCount:Var
+        currentRoom:Var
+        inventory:    count:Var  itemId:Var...
+        room items:   for every room in id order: count:Var  itemId:Var...
+        item state:   for every item in id order: U8 (bit 0 = Attrs::isFound, bit 1 = Flags::canCarry)
+        links:        count:Var  (from:Var  exitName:Str  to+1:Var)...   - links made while playing (red door etc), 0 = removed
+        turn:Var      - NPCs with schedules are wherever this puts them, so they're not saved
+    version 2 snapshots (no turn) still load, at turn 0
+*/
+class Snapshot {
+
+    public:
+
+    /*  first 4 bytes of every snapshot  */
+    static inline constexpr char Magic[4] = { 'T', 'B', 'G', 'S' };
+
+    /*  bump when the format changes  */
+    static inline constexpr uint16_t Version = 3;
+
+    /*
+        hash of every room and item name in id order, so snapshots can't be loaded into the wrong world
+        worked out once per world and cached in the game
+    */
+    static uint64_t Fingerprint(TextBasedGame& game);
+
+    /*  appends a snapshot of the game to out  */
+    static void Write(TextBasedGame& game, ByteWriter& out);
+
+    /*
+        replaces the game's state with the snapshot in "in"
+        throws FormatError if it's damaged or from a different world, in which case the game is left untouched
+    */
+    static void Read(TextBasedGame& game, ByteReader& in);
+
+    /*  Write() to a file, returns false if the file couldn't be written  */
+    static bool SaveFile(TextBasedGame& game, std::string const& path);
+
+    /*
+        Read() from a file, returns false if there's no such file
+        throws FormatError like Read()
+    */
+    static bool LoadFile(TextBasedGame& game, std::string const& path);
+
+    /*
+        Just the current session, as a difference from the world template - for hibernating
+        idle server sessions (see Server). Only what the player changed is written, plus their
+        undo history, so it's as small as what they did no matter how big the world is.
+
+        Format (version 2), locations are +2 so Inventory is 0 and Nowhere is 1:
+            "TBGH"  version:U16  fingerprint:U64
+            state:U8  currentRoom:Var  turn:Var
+            inventory:       count:Var  itemId:Var...
+            changed rooms:   count:Var  (roomId:Var  count:Var  itemId:Var...)...
+            found items:     count:Var  (itemId:Var  found:U8)...
+            item locations:  count:Var  (itemId:Var  location+2:Var)...
+            labels:          count:Var  exitName:Str...   - exit names the session added, in label order
+            links:           count:Var  (from:Var  label:Var  target+1:Var  previous+1:Var)...
+            undo history     (see UndoLog::Write)
+    */
+    static inline constexpr char SessionMagic[4] = { 'T', 'B', 'G', 'H' };
+    static inline constexpr uint16_t SessionVersion = 2;
+
+    /*  appends the current session's difference from the world template to out  */
+    static void WriteSession(TextBasedGame& game, ByteWriter& out);
+
+    /*
+        puts what WriteSession() wrote into the current session, which has to be fresh from CreateSession()
+        throws FormatError if it's damaged or from a different world (the session is half done then, throw it away)
+    */
+    static void ReadSession(TextBasedGame& game, ByteReader& in);
+
+};
+
+#endif /* __SNAPSHOT__ */
@@ -0,0 +1,784 @@
+#include "solver.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <latch>
+#include <map>
+
+namespace {
+    /*  values of the 30 bits an action has besides its kind  */
+    constexpr uint32_t ActionValueMask = (1u << 30) - 1;
+
+    /*  actions tried per state can't go past this (ranks keep the action's index in the low bits)  */
+    constexpr uint32_t RankActionBits = 20;
+
+    /*  slots a shard starts with  */
+    constexpr size_t InitialSlots = 1024;
+
+    std::string Lowercase(std::string s) {
+        std::transform(s.begin(), s.end(), s.begin(), [](unsigned char c) { return std::tolower(c); });
+        return s;
+    }
+}
+
+Solver::Solver(TextBasedGame& _game, Config _config) : game(_game), config(std::move(_config)) {
+    goal = RoomGraph::None;
+    worldLabelCount = 0;
+    stateShards = std::make_unique<StateShard[]>(ShardCount);
+    layoutShards = std::make_unique<LayoutShard[]>(ShardCount);
+    stateCount = 0;
+    layoutCount = 0;
+    truncated = false;
+}
+
+Solver::~Solver() { }
+
+uint32_t Solver::MakeAction(ActionKind kind, uint32_t value) {
+    return (static_cast<uint32_t>(kind) << 30) | (value & ActionValueMask);
+}
+
+Solver::Result Solver::Solve() {
+    auto startTime = std::chrono::steady_clock::now();
+    Result result;
+
+    /* the goal, by name or by what it's called in game */
+    if (game.rooms.Contains(config.goalRoom)) {
+        goal = game.rooms.GetId(config.goalRoom);
+    } else {
+        auto it = game.roomIdsByRepr.find(Lowercase(config.goalRoom));
+        if (it == game.roomIdsByRepr.end()) {
+            throw std::out_of_range("there's no room called " + config.goalRoom);
+        }
+        goal = it->second;
+    }
+
+    auto &world = game.worldTemplate;
+    uint32_t itemCount = game.items.Size();
+    baseLocations.resize(itemCount);
+    for (uint32_t i = 0; i < itemCount; i++) {
+        baseLocations[i] = world.itemLocations.Get(i);
+    }
+    baseInventory = world.player.GetInventory();
+    worldLabelCount = world.roomGraph->GetLabelCount();
+
+    specialsOf.assign(itemCount, { 0, 0 });
+    for (uint32_t i = 0; i < itemCount; i++) {
+        auto &commands = game.items.Get(i).GetSpecialCommands();
+        specialsOf[i].first = static_cast<uint32_t>(specials.size());
+        for (uint32_t k = 0; k < commands.size(); k++) {
+            if (!commands[k].GetHints().empty()) {
+                specials.push_back(SpecialCommand { i, k, commands[k].GetHints().front() });
+            }
+        }
+        specialsOf[i].second = static_cast<uint32_t>(specials.size()) - specialsOf[i].first;
+    }
+
+    ThreadPool pool(config.threads);
+    result.threads = pool.GetThreadCount();
+    for (size_t t = 0; t < result.threads; t++) {
+        auto w = std::make_unique<Worker>();
+        w->base = std::make_unique<TextBasedGame::Session>();
+        w->scratch = std::make_unique<TextBasedGame::Session>();
+        for (auto &special : specials) {
+            w->commands.push_back(game.items.Get(special.item).GetSpecialCommands()[special.index]);
+        }
+        workers.push_back(std::move(w));
+    }
+
+    FindRelevantItems(pool);
+    for (uint32_t i = 0; i < itemCount; i++) {
+        if (game.items.Get(i).GetFlags().canCarry) {
+            result.carriableItems++;
+            result.relevantItems += relevant[i];
+        }
+    }
+
+    /* the start - nothing differs from the world yet */
+    State start;
+    start.room = world.currentRoom;
+    std::vector<uint32_t> packed;
+    PackLayout(start, packed);
+    uint32_t startId = Insert(start.room, InternLayout(packed), NoState, NoAction, 0, 0).first;
+
+    std::vector<uint32_t> frontier, wins;
+    if (start.room == goal) {
+        result.winnable = true;
+    } else {
+        frontier.push_back(startId);
+    }
+
+    uint32_t depth = 0;
+    while (!frontier.empty()) {
+        std::atomic<size_t> cursor = 0;
+        std::latch done(static_cast<ptrdiff_t>(workers.size()));
+        for (auto &w : workers) {
+            w->found.clear();
+            w->wins.clear();
+            pool.Submit([this, &cursor, &done, &frontier, worker = w.get()]{
+                for (size_t i; !truncated && (i = cursor.fetch_add(1)) < frontier.size(); ) {
+                    Expand(*worker, frontier[i], i);
+                }
+                done.count_down();
+            });
+        }
+        done.wait();
+
+        frontier.clear();
+        wins.clear();
+        for (auto &w : workers) {
+            frontier.insert(frontier.end(), w->found.begin(), w->found.end());
+            wins.insert(wins.end(), w->wins.begin(), w->wins.end());
+        }
+        if (frontier.empty() && wins.empty()) {
+            break;
+        }
+        depth++;
+
+        /* back in the order they were first reached (see Node::rank), however the threads went */
+        auto byRank = [this](uint32_t a, uint32_t b) { return GetNode(a).rank < GetNode(b).rank; };
+        std::sort(frontier.begin(), frontier.end(), byRank);
+
+        if (!wins.empty() && !result.winnable) {
+            result.winnable = true;
+            result.solution = PathTo(*std::min_element(wins.begin(), wins.end(), byRank));
+            if (config.firstWinOnly) {
+                break;
+            }
+        }
+        if (truncated) {
+            break;
+        }
+    }
+
+    result.states = stateCount;
+    result.depth = depth;
+    result.complete = frontier.empty() && !truncated;
+    if (result.winnable) {
+        result.verified = Verify(result.solution);
+    }
+    if (result.complete) {
+        FindDeadEnds(result);
+    }
+
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+    return result;
+}
+
+void Solver::FindRelevantItems(ThreadPool &pool) {
+    uint32_t itemCount = game.items.Size();
+    relevant.assign(itemCount, 0);
+
+    std::vector<uint32_t> carriable;
+    for (uint32_t i = 0; i < itemCount; i++) {
+        if (game.items.Get(i).GetFlags().canCarry) {
+            carriable.push_back(i);
+            /* carrying an item around matters if it brings its own commands along */
+            if (config.allItems || specialsOf[i].second > 0) {
+                relevant[i] = 1;
+            }
+        }
+    }
+    if (config.allItems || specials.empty()) {
+        return;
+    }
+
+    /* every worker takes every n-th carriable item, so each only writes its own bytes of relevant */
+    std::latch done(static_cast<ptrdiff_t>(workers.size()));
+    for (size_t t = 0; t < workers.size(); t++) {
+        pool.Submit([this, t, &carriable, &done]{
+            Worker &w = *workers[t];
+            std::vector<std::string> held, notHeld;
+            for (uint32_t j = 0; j < specials.size(); j++) {
+                /* with nothing else held, and with everything else held */
+                for (bool allHeld : { false, true }) {
+                    auto &base = *w.base;
+                    base.CopyStateFrom(game.worldTemplate);
+                    {
+                        TextBasedGame::SessionScope scope(&game, base);
+                        base.state = TextBasedGame::GameState::Loading;
+                        if (allHeld) {
+                            for (auto item : carriable) {
+                                game.MoveItem(item, Delta::Inventory);
+                            }
+                        }
+                        /* where the command's item is, so it's run the way a player would */
+                        uint32_t owner = baseLocations[specials[j].item];
+                        if (owner < Delta::Inventory) {
+                            base.currentRoom = owner;
+                        }
+                        base.state = TextBasedGame::GameState::Playing;
+                    }
+                    for (size_t c = t; c < carriable.size(); c += workers.size()) {
+                        uint32_t item = carriable[c];
+                        if (relevant[item]) {
+                            continue;
+                        }
+                        Probe(w, j, item, true, held);
+                        Probe(w, j, item, false, notHeld);
+                        if (held != notHeld) {
+                            relevant[item] = 1;
+                        }
+                    }
+                }
+            }
+            done.count_down();
+        });
+    }
+    done.wait();
+}
+
+void Solver::Probe(Worker &w, uint32_t special, uint32_t item, bool held, std::vector<std::string> &outcome) {
+    auto &c = *w.scratch;
+    c.CopyStateFrom(*w.base);
+    c.undoLog.Clear();
+    c.output.clear();
+    outcome.clear();
+
+    TextBasedGame::SessionScope scope(&game, c);
+    c.state = TextBasedGame::GameState::Loading;
+    uint32_t location = held ? Delta::Inventory : (baseLocations[item] == Delta::Inventory ? Delta::Nowhere : baseLocations[item]);
+    game.MoveItem(item, location);
+    c.state = TextBasedGame::GameState::Playing;
+
+    std::string input = specials[special].hint;
+    try {
+        w.commands[special].TryEval(input);
+    } catch (...) {
+        outcome.push_back("(threw)");
+    }
+
+    /* what it printed and what it changed - not what things were before, that's what differs on purpose */
+    outcome.insert(outcome.end(), c.output.begin(), c.output.end());
+    c.undoLog.Commit();
+    if (c.undoLog.CanUndo()) {
+        for (auto &delta : c.undoLog.Undo()) {
+            outcome.push_back(fmt::format("{} {} {} {}", static_cast<int>(delta.kind), delta.subject, delta.label, delta.after));
+        }
+    }
+}
+
+/* states */
+
+void Solver::PackLayout(State const& s, std::vector<uint32_t> &out) {
+    out.clear();
+    out.push_back(static_cast<uint32_t>(s.items.size()));
+    for (auto &[item, location] : s.items) {
+        out.push_back(item);
+        out.push_back(location);
+    }
+    out.push_back(static_cast<uint32_t>(s.exits.size()));
+    for (auto &e : s.exits) {
+        out.push_back(e.from);
+        out.push_back(e.label);
+        out.push_back(e.target);
+    }
+}
+
+void Solver::UnpackLayout(uint32_t const *words, State &s) {
+    size_t i = 0;
+    s.items.resize(words[i++]);
+    for (auto &[item, location] : s.items) {
+        item = words[i++];
+        location = words[i++];
+    }
+    s.exits.resize(words[i++]);
+    for (auto &e : s.exits) {
+        e.from = words[i++];
+        e.label = words[i++];
+        e.target = words[i++];
+    }
+}
+
+uint32_t Solver::LayoutSize(uint32_t const *words) {
+    uint32_t items = words[0];
+    uint32_t exits = words[1 + 2 * items];
+    return 2 + 2 * items + 3 * exits;
+}
+
+uint64_t Solver::Hash(uint32_t const *words, size_t count) {
+    uint64_t h = 0x9E3779B97F4A7C15ull ^ count;
+    for (size_t i = 0; i < count; i++) {
+        h = (h ^ words[i]) * 0xBF58476D1CE4E5B9ull;
+        h ^= h >> 29;
+    }
+    /* splitmix64's finish, the shard comes from the low bits */
+    h ^= h >> 30;
+    h *= 0xBF58476D1CE4E5B9ull;
+    h ^= h >> 27;
+    h *= 0x94D049BB133111EBull;
+    return h ^ (h >> 31);
+}
+
+uint32_t Solver::InternLayout(std::vector<uint32_t> const& packed) {
+    uint64_t h = Hash(packed.data(), packed.size());
+    uint32_t shardIndex = static_cast<uint32_t>(h & (ShardCount - 1));
+    LayoutShard &shard = layoutShards[shardIndex];
+
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    if (shard.slots.empty()) {
+        shard.slots.assign(InitialSlots, 0);
+    }
+    size_t mask = shard.slots.size() - 1;
+    for (size_t i = (h >> ShardBits) & mask; ; i = (i + 1) & mask) {
+        uint32_t slot = shard.slots[i];
+        if (slot == 0) {
+            uint32_t local = static_cast<uint32_t>(shard.offsets.size());
+            shard.offsets.push_back(static_cast<uint32_t>(shard.words.size()));
+            shard.words.insert(shard.words.end(), packed.begin(), packed.end());
+            shard.slots[i] = local + 1;
+            if (shard.offsets.size() * 2 > shard.slots.size()) {
+                Grow(shard);
+            }
+            layoutCount++;
+            return (local << ShardBits) | shardIndex;
+        }
+        uint32_t const *stored = shard.words.data() + shard.offsets[slot - 1];
+        if (LayoutSize(stored) == packed.size() && std::equal(packed.begin(), packed.end(), stored)) {
+            return ((slot - 1) << ShardBits) | shardIndex;
+        }
+    }
+}
+
+std::pair<uint32_t, bool> Solver::Insert(uint32_t room, uint32_t layout, uint32_t parent, uint32_t action, uint32_t depth, uint64_t rank) {
+    uint32_t key[2] = { room, layout };
+    uint64_t h = Hash(key, 2);
+    uint32_t shardIndex = static_cast<uint32_t>(h & (ShardCount - 1));
+    StateShard &shard = stateShards[shardIndex];
+
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    if (shard.slots.empty()) {
+        shard.slots.assign(InitialSlots, 0);
+    }
+    size_t mask = shard.slots.size() - 1;
+    for (size_t i = (h >> ShardBits) & mask; ; i = (i + 1) & mask) {
+        uint32_t slot = shard.slots[i];
+        if (slot == 0) {
+            uint32_t local = static_cast<uint32_t>(shard.nodes.size());
+            shard.nodes.push_back(Node { room, layout, parent, action, depth, rank });
+            shard.slots[i] = local + 1;
+            if (shard.nodes.size() * 2 > shard.slots.size()) {
+                Grow(shard);
+            }
+            if (++stateCount >= config.maxStates) {
+                truncated = true;
+            }
+            return { (local << ShardBits) | shardIndex, true };
+        }
+
+        Node &node = shard.nodes[slot - 1];
+        if (node.room == room && node.layout == layout) {
+            /* found again on the same level from further up the order, that's the way to remember */
+            if (node.depth == depth && rank < node.rank) {
+                node.parent = parent;
+                node.action = action;
+                node.rank = rank;
+            }
+            return { ((slot - 1) << ShardBits) | shardIndex, false };
+        }
+    }
+}
+
+void Solver::Grow(StateShard &shard) {
+    std::vector<uint32_t> slots(shard.slots.size() * 2, 0);
+    size_t mask = slots.size() - 1;
+    for (uint32_t local = 0; local < shard.nodes.size(); local++) {
+        uint32_t key[2] = { shard.nodes[local].room, shard.nodes[local].layout };
+        size_t i = (Hash(key, 2) >> ShardBits) & mask;
+        while (slots[i] != 0) {
+            i = (i + 1) & mask;
+        }
+        slots[i] = local + 1;
+    }
+    shard.slots = std::move(slots);
+}
+
+void Solver::Grow(LayoutShard &shard) {
+    std::vector<uint32_t> slots(shard.slots.size() * 2, 0);
+    size_t mask = slots.size() - 1;
+    for (uint32_t local = 0; local < shard.offsets.size(); local++) {
+        uint32_t const *stored = shard.words.data() + shard.offsets[local];
+        size_t i = (Hash(stored, LayoutSize(stored)) >> ShardBits) & mask;
+        while (slots[i] != 0) {
+            i = (i + 1) & mask;
+        }
+        slots[i] = local + 1;
+    }
+    shard.slots = std::move(slots);
+}
+
+uint32_t Solver::Load(uint32_t id, State &s, uint32_t &layout) {
+    uint32_t depth;
+    {
+        StateShard &shard = stateShards[id & (ShardCount - 1)];
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        Node &node = shard.nodes[id >> ShardBits];
+        s.room = node.room;
+        layout = node.layout;
+        depth = node.depth;
+    }
+    LayoutShard &shard = layoutShards[layout & (ShardCount - 1)];
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    UnpackLayout(shard.words.data() + shard.offsets[layout >> ShardBits], s);
+    return depth;
+}
+
+Solver::Node& Solver::GetNode(uint32_t id) {
+    return stateShards[id & (ShardCount - 1)].nodes[id >> ShardBits];
+}
+
+uint32_t Solver::LocationOf(State const& s, uint32_t item) {
+    auto it = std::lower_bound(s.items.begin(), s.items.end(), std::make_pair(item, 0u));
+    return (it != s.items.end() && it->first == item) ? it->second : baseLocations[item];
+}
+
+void Solver::SetLocation(State &s, uint32_t item, uint32_t location) {
+    auto it = std::lower_bound(s.items.begin(), s.items.end(), std::make_pair(item, 0u));
+    bool listed = it != s.items.end() && it->first == item;
+    if (location == baseLocations[item]) {
+        if (listed) {
+            s.items.erase(it);
+        }
+    } else if (listed) {
+        it->second = location;
+    } else {
+        s.items.insert(it, { item, location });
+    }
+}
+
+/* labels */
+
+uint32_t Solver::GlobalLabel(TextBasedGame::Session &session, uint32_t label) {
+    if (label < worldLabelCount) {
+        return label;
+    }
+    std::string const &name = session.roomGraph->GetLabelName(label);
+    std::lock_guard<std::mutex> lock(extraLabelMutex);
+    auto [it, added] = extraLabelIds.try_emplace(name, worldLabelCount + static_cast<uint32_t>(extraLabels.size()));
+    if (added) {
+        extraLabels.push_back(name);
+    }
+    return it->second;
+}
+
+uint32_t Solver::SessionLabel(uint32_t label) {
+    if (label < worldLabelCount) {
+        return label;
+    }
+    return game.MutableRoomGraph().Intern(LabelName(label));
+}
+
+std::string Solver::LabelName(uint32_t label) {
+    if (label < worldLabelCount) {
+        return game.worldTemplate.roomGraph->GetLabelName(label);
+    }
+    std::lock_guard<std::mutex> lock(extraLabelMutex);
+    return extraLabels.at(label - worldLabelCount);
+}
+
+/* searching */
+
+void Solver::Restore(Worker &w, State const& s) {
+    auto &base = *w.base;
+    base.CopyStateFrom(game.worldTemplate);
+    TextBasedGame::SessionScope scope(&game, base);
+    /* nothing recorded, and no dynamic links - RunSpecial only wants to see what the command adds */
+    base.state = TextBasedGame::GameState::Loading;
+    for (auto &[item, location] : s.items) {
+        game.MoveItem(item, location);
+    }
+    for (auto &e : s.exits) {
+        game.SetExit(e.from, SessionLabel(e.label), e.target);
+    }
+    base.currentRoom = s.room;
+    base.state = TextBasedGame::GameState::Playing;
+}
+
+bool Solver::RunSpecial(Worker &w, uint32_t special, State const& from) {
+    auto &c = *w.scratch;
+    c.CopyStateFrom(*w.base);
+    c.undoLog.Clear();
+    c.output.clear();
+    {
+        TextBasedGame::SessionScope scope(&game, c);
+        std::string input = specials[special].hint;
+        try {
+            if (!w.commands[special].TryEval(input)) {
+                return false;
+            }
+        } catch (...) {
+            /* ExitGameException or worse, not a way forward either way */
+            return false;
+        }
+    }
+
+    auto &child = w.child;
+    child.room = c.currentRoom;
+    auto &changes = c.itemLocations.GetChanges();
+    child.items.assign(changes.begin(), changes.end());
+    std::sort(child.items.begin(), child.items.end());
+
+    child.exits = from.exits;
+    for (auto &link : c.dynamicLinks) {
+        uint32_t label = GlobalLabel(c, link.label);
+        auto it = std::find_if(child.exits.begin(), child.exits.end(), [&](ExitChange const &e) { return e.from == link.from && e.label == label; });
+        if (it != child.exits.end()) {
+            it->target = link.target;
+        } else {
+            child.exits.push_back(ExitChange { link.from, label, link.target });
+        }
+    }
+    auto &world = *game.worldTemplate.roomGraph;
+    std::erase_if(child.exits, [&](ExitChange const &e) {
+        return world.GetExit(e.from, e.label) == e.target;
+    });
+    std::sort(child.exits.begin(), child.exits.end(), [](ExitChange const &a, ExitChange const &b) {
+        return (a.from != b.from) ? a.from < b.from : a.label < b.label;
+    });
+    return true;
+}
+
+void Solver::Expand(Worker &w, uint32_t id, uint64_t position) {
+    uint32_t depth = Load(id, w.state, w.layout) + 1;
+    State const &s = w.state;
+    uint32_t index = 0;
+    auto rank = [&]{ return (position << RankActionBits) | index++; };
+
+    if (!config.firstWinOnly) {
+        w.edgeStart = w.edges.size();
+        w.edges.push_back(id);
+        w.edges.push_back(0);
+    }
+
+    /* exits - the world's, with this state's changes on top, in label order */
+    auto &world = game.worldTemplate;
+    std::vector<RoomGraph::Exit> &exits = w.exits;
+    auto worldExits = world.roomGraph->GetExits(s.room);
+    exits.assign(worldExits.begin(), worldExits.end());
+    for (auto &e : s.exits) {
+        if (e.from != s.room) {
+            continue;
+        }
+        auto it = std::find_if(exits.begin(), exits.end(), [&](RoomGraph::Exit const &x) { return x.label == e.label; });
+        if (it != exits.end()) {
+            it->target = e.target;
+        } else {
+            exits.push_back(RoomGraph::Exit { e.label, e.target });
+        }
+    }
+    std::sort(exits.begin(), exits.end(), [](RoomGraph::Exit const &a, RoomGraph::Exit const &b) { return a.label < b.label; });
+    for (auto &exit : exits) {
+        if (exit.target == RoomGraph::None) {
+            continue;
+        }
+        /* same layout, somewhere else */
+        Reach(w, id, exit.target, w.layout, MakeAction(Move, exit.label), depth, rank());
+    }
+
+    /* items here or carried, that can be taken/dropped or have commands */
+    w.nearby.clear();
+    auto interesting = [&](uint32_t item) { return relevant[item] || specialsOf[item].second > 0; };
+    for (auto item : world.roomItems.Get(s.room)) {
+        if (interesting(item) && LocationOf(s, item) == s.room) {
+            w.nearby.push_back(item);
+        }
+    }
+    for (auto item : baseInventory) {
+        if (interesting(item) && LocationOf(s, item) == Delta::Inventory) {
+            w.nearby.push_back(item);
+        }
+    }
+    for (auto &[item, location] : s.items) {
+        if (interesting(item) && location != baseLocations[item] && (location == s.room || location == Delta::Inventory)) {
+            w.nearby.push_back(item);
+        }
+    }
+    std::sort(w.nearby.begin(), w.nearby.end());
+
+    bool restored = false;
+    for (auto item : w.nearby) {
+        uint32_t location = LocationOf(s, item);
+        if (relevant[item] && location == s.room) {
+            w.child = s;
+            SetLocation(w.child, item, Delta::Inventory);
+            Reach(w, id, MakeAction(Take, item), depth, rank());
+        }
+        if (relevant[item] && location == Delta::Inventory && config.drops) {
+            w.child = s;
+            SetLocation(w.child, item, s.room);
+            Reach(w, id, MakeAction(Drop, item), depth, rank());
+        }
+
+        auto [first, count] = specialsOf[item];
+        for (uint32_t special = first; special < first + count; special++) {
+            if (!restored) {
+                Restore(w, s);
+                restored = true;
+            }
+            uint64_t r = rank();
+            if (RunSpecial(w, special, s)) {
+                Reach(w, id, MakeAction(Special, special), depth, r);
+            }
+        }
+    }
+}
+
+void Solver::Reach(Worker &w, uint32_t id, uint32_t action, uint32_t depth, uint64_t rank) {
+    PackLayout(w.child, w.packed);
+    Reach(w, id, w.child.room, InternLayout(w.packed), action, depth, rank);
+}
+
+void Solver::Reach(Worker &w, uint32_t id, uint32_t room, uint32_t layout, uint32_t action, uint32_t depth, uint64_t rank) {
+    auto [child, isNew] = Insert(room, layout, id, action, depth, rank);
+
+    if (!config.firstWinOnly) {
+        w.edges.push_back(child);
+        w.edges.push_back(action);
+        w.edges[w.edgeStart + 1]++;
+    }
+    if (!isNew) {
+        return;
+    }
+    /* the game's won there, nothing to look for past it */
+    if (room == goal) {
+        w.wins.push_back(child);
+    } else {
+        w.found.push_back(child);
+    }
+}
+
+/* results */
+
+std::string Solver::CommandText(uint32_t action) {
+    uint32_t value = action & ActionValueMask;
+    switch (static_cast<ActionKind>(action >> 30)) {
+        case Move: return "go " + LabelName(value);
+        /* the take/drop commands match the item's name, not its repr */
+        case Take: return "take " + Lowercase(game.items.GetName(value));
+        case Drop: return "drop " + Lowercase(game.items.GetName(value));
+        case Special: return specials[value].hint;
+    }
+    return "";
+}
+
+std::vector<std::string> Solver::PathTo(uint32_t id) {
+    std::vector<std::string> path;
+    while (GetNode(id).parent != NoState) {
+        path.push_back(CommandText(GetNode(id).action));
+        id = GetNode(id).parent;
+    }
+    std::reverse(path.begin(), path.end());
+    return path;
+}
+
+bool Solver::Verify(std::vector<std::string> const& commands) {
+    auto session = game.CreateSession();
+    for (auto &command : commands) {
+        try {
+            game.Eval(*session, command);
+        } catch (...) {
+            return false;
+        }
+    }
+    return session->currentRoom == goal;
+}
+
+void Solver::FindDeadEnds(Result &result) {
+    /* state ids -> 0..n-1, shard after shard */
+    std::vector<uint32_t> shardStart(ShardCount + 1, 0);
+    for (uint32_t i = 0; i < ShardCount; i++) {
+        shardStart[i + 1] = shardStart[i] + static_cast<uint32_t>(stateShards[i].nodes.size());
+    }
+    uint32_t n = shardStart[ShardCount];
+    auto dense = [&](uint32_t id) { return shardStart[id & (ShardCount - 1)] + (id >> ShardBits); };
+
+    /* who leads to whom, backwards */
+    std::vector<uint32_t> offsets(n + 1, 0), from;
+    for (auto &w : workers) {
+        for (size_t i = 0; i < w->edges.size(); ) {
+            uint32_t count = w->edges[i + 1];
+            for (uint32_t k = 0; k < count; k++) {
+                offsets[dense(w->edges[i + 2 + 2 * k]) + 1]++;
+            }
+            i += 2 + 2 * count;
+        }
+    }
+    for (uint32_t i = 0; i < n; i++) {
+        offsets[i + 1] += offsets[i];
+    }
+    from.resize(offsets[n]);
+    std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+    for (auto &w : workers) {
+        for (size_t i = 0; i < w->edges.size(); ) {
+            uint32_t parent = dense(w->edges[i]), count = w->edges[i + 1];
+            for (uint32_t k = 0; k < count; k++) {
+                from[fill[dense(w->edges[i + 2 + 2 * k])]++] = parent;
+            }
+            i += 2 + 2 * count;
+        }
+    }
+
+    /* everything that can get to a winning state */
+    std::vector<uint8_t> canWin(n, 0);
+    std::vector<uint32_t> queue;
+    for (uint32_t s = 0; s < ShardCount; s++) {
+        auto &shard = stateShards[s];
+        for (uint32_t local = 0; local < shard.nodes.size(); local++) {
+            if (shard.nodes[local].room == goal) {
+                canWin[shardStart[s] + local] = 1;
+                queue.push_back(shardStart[s] + local);
+            }
+        }
+    }
+    for (size_t head = 0; head < queue.size(); head++) {
+        uint32_t to = queue[head];
+        for (uint32_t i = offsets[to]; i < offsets[to + 1]; i++) {
+            if (!canWin[from[i]]) {
+                canWin[from[i]] = 1;
+                queue.push_back(from[i]);
+            }
+        }
+    }
+    result.deadEnds = n - queue.size();
+
+    /* commands from a winnable state into a dead end, with the first place each happens (by level, then order) */
+    struct Crossing {
+        size_t count = 0;
+        uint32_t parent = NoState;
+        uint32_t depth = 0;
+        uint64_t rank = 0;
+    };
+    std::map<uint32_t, Crossing> crossings;
+    for (auto &w : workers) {
+        for (size_t i = 0; i < w->edges.size(); ) {
+            uint32_t parent = w->edges[i], count = w->edges[i + 1];
+            if (canWin[dense(parent)]) {
+                for (uint32_t k = 0; k < count; k++) {
+                    uint32_t child = w->edges[i + 2 + 2 * k], action = w->edges[i + 3 + 2 * k];
+                    if (canWin[dense(child)]) {
+                        continue;
+                    }
+                    auto &crossing = crossings[action];
+                    crossing.count++;
+                    Node &node = GetNode(parent);
+                    if (crossing.parent == NoState || node.depth < crossing.depth || (node.depth == crossing.depth && node.rank < crossing.rank)) {
+                        crossing.parent = parent;
+                        crossing.depth = node.depth;
+                        crossing.rank = node.rank;
+                    }
+                }
+            }
+            i += 2 + 2 * count;
+        }
+    }
+
+    std::vector<std::pair<uint32_t, Crossing>> sorted(crossings.begin(), crossings.end());
+    std::stable_sort(sorted.begin(), sorted.end(), [](auto const &a, auto const &b) { return a.second.count > b.second.count; });
+    for (auto &[action, crossing] : sorted) {
+        if (result.pointsOfNoReturn.size() == MaxPointsOfNoReturn) {
+            break;
+        }
+        auto example = PathTo(crossing.parent);
+        example.push_back(CommandText(action));
+        result.pointsOfNoReturn.push_back(PointOfNoReturn { CommandText(action), crossing.count, std::move(example) });
+    }
+}
@@ -0,0 +1,315 @@
+#ifndef __SOLVER__
+#define __SOLVER__
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "textbasedgame.hpp"
+#include "threadpool.hpp"
+
+/*
+    Winnability checker - finds out whether a world can still be won (standing in a goal room),
+    by trying every command in every state the world can get into, breadth first
+
+    A state is where the player is, where every item is and which exits changed (unlocked doors).
+    Everything but the room - the layout - is boiled down to a canonical list of numbers (only what
+    differs from the world right after Init(), sorted) and hash-consed, so a state is just
+    (room, layout id): thousands of states share one layout, and walking around never makes a new one.
+    States and layouts are each stored exactly once, in one of a fixed number of shards, each a
+    flat array plus an open addressing table over it with its own lock - so lots of threads can
+    look states up and add them at once
+
+    The search goes one level (number of commands) at a time, spread over a ThreadPool.
+    Levels are ordered by how each state was first reached, so results don't depend on thread timing:
+    the same world always gives the same shortest solution and examples.
+
+    Commands tried in each state:
+    - going through every exit of the current room
+    - taking items that matter, and dropping them if Config::drops (see below)
+    - every special command of every item in the room or the inventory, run on a real session
+      with its first hint - so whatever a door or lever does, the solver does too
+    Moving, taking and dropping are worked out straight from the state (they're most of the
+    work, and they can't do anything else - except through EventBus rules, which the solver
+    doesn't run, so OnEnter/OnTake/OnDrop/OnTick rules that change things aren't seen, and
+    neither is "use"). Commands without hints can't be typed by the solver and are never tried.
+
+    Most items are scenery as far as winning goes, and taking each of them would double the
+    number of states. Before searching, every special command is run with each carriable item
+    held and not held (with everything else held, and with nothing held) - items that never
+    make a difference are left where they are (Config::allItems turns this off).
+
+    With the whole state space explored, every state that can't reach the goal any more is a
+    dead end; the commands that lead from a winnable state into one are reported, with the
+    shortest way to get there.
+*/
+class Solver {
+
+    public:
+
+    /*  what to look for, and how hard  */
+    struct Config {
+        /*  the room that counts as winning, its name or what it's called in game ("Garden", "garden")  */
+        std::string goalRoom;
+        /*  give up after finding this many states (the result says so)  */
+        size_t maxStates = 5000000;
+        /*  threads searching, 0 = one per core  */
+        size_t threads = 0;
+        /*  stop at the first level that wins, instead of exploring everything (no dead ends then)  */
+        bool firstWinOnly = false;
+        /*  also try dropping items - only matters for puzzles that look at what's lying where, and multiplies the states  */
+        bool drops = false;
+        /*  take every carriable item, not only the ones some special command cares about  */
+        bool allItems = false;
+    };
+
+    /*  a command that makes the game unwinnable  */
+    struct PointOfNoReturn {
+        std::string command;
+        /*  how many winnable states it does that from  */
+        size_t count;
+        /*  the shortest way into the dead end, ending with command  */
+        std::vector<std::string> example;
+    };
+
+    struct Result {
+        /*  a state in the goal room was found  */
+        bool winnable = false;
+        /*  the shortest list of commands that wins, from the start  */
+        std::vector<std::string> solution;
+        /*  solution was played through Eval on a new session and really ended up in the goal room  */
+        bool verified = false;
+
+        /*  distinct states found, and how many commands deep the search went  */
+        size_t states = 0;
+        uint32_t depth = 0;
+        /*  every reachable state was explored (not cut short by maxStates or firstWinOnly)  */
+        bool complete = false;
+
+        /*  states that can't win any more, and how they happen (most common first) - only if complete  */
+        size_t deadEnds = 0;
+        std::vector<PointOfNoReturn> pointsOfNoReturn;
+
+        /*  carriable items, and how many of them the search takes/drops  */
+        size_t carriableItems = 0;
+        size_t relevantItems = 0;
+
+        double seconds = 0;
+        size_t threads = 0;
+    };
+
+    /*  how many points of no return Result lists at most  */
+    static inline constexpr size_t MaxPointsOfNoReturn = 5;
+
+    /*  game must be Init()ed, and isn't played while solving (sessions of it are)  */
+    Solver(TextBasedGame& _game, Config _config);
+
+    ~Solver();
+
+    Solver(Solver const&) = delete;
+    Solver& operator=(Solver const&) = delete;
+
+    /*  runs the search, throws std::out_of_range if there's no room called Config::goalRoom  */
+    Result Solve();
+
+    private:
+
+    /*
+        What a command did, 32 bits: top two bits are the kind,
+        the rest a label (Move), an item id (Take, Drop) or an index into specials (Special)
+    */
+    enum ActionKind : uint32_t { Move = 0, Take = 1, Drop = 2, Special = 3 };
+    static inline constexpr uint32_t NoAction = UINT32_MAX;
+    static uint32_t MakeAction(ActionKind kind, uint32_t value);
+
+    /*  a special command the search can run - item's GetSpecialCommands()[index], typed as hint  */
+    struct SpecialCommand {
+        uint32_t item;
+        uint32_t index;
+        std::string hint;
+    };
+
+    /*  an exit that isn't what the world has - label is a world label, or past them an extraLabels one  */
+    struct ExitChange {
+        uint32_t from;
+        uint32_t label;
+        uint32_t target;
+    };
+
+    /*
+        a state, unpacked - the room, and the layout: items and exits, only what differs from the world, sorted
+        a layout packs into [item count, (item, location)..., exit count, (from, label, target)...]
+    */
+    struct State {
+        uint32_t room;
+        std::vector<std::pair<uint32_t, uint32_t>> items;
+        std::vector<ExitChange> exits;
+    };
+
+    /*  one stored state  */
+    struct Node {
+        uint32_t room;
+        uint32_t layout;
+        /*  state id this one was first reached from (NoState for the start), and with what  */
+        uint32_t parent;
+        uint32_t action;
+        /*  number of commands from the start  */
+        uint32_t depth;
+        /*  position among the states of its level - parent's position, then the action's (smaller wins)  */
+        uint64_t rank;
+    };
+
+    /*
+        the slices of the hash-consed states and layouts - each has the ones whose hash ends in its number,
+        ids are (index << ShardBits) | shard
+        slots are open addressing over them, index + 1 (0 = empty), always a power of two and at most half full
+    */
+    struct StateShard {
+        std::mutex mutex;
+        std::vector<Node> nodes;
+        std::vector<uint32_t> slots;
+    };
+    struct LayoutShard {
+        std::mutex mutex;
+        /*  packed layouts, one after another, and where each one starts  */
+        std::vector<uint32_t> words;
+        std::vector<uint32_t> offsets;
+        std::vector<uint32_t> slots;
+    };
+
+    static inline constexpr uint32_t ShardBits = 6;
+    static inline constexpr uint32_t ShardCount = 1 << ShardBits;
+    static inline constexpr uint32_t NoState = UINT32_MAX;
+
+    /*  everything one search thread needs for itself  */
+    struct Worker {
+        /*  sessions for running special commands - the state being expanded, and a copy to run each command on  */
+        std::unique_ptr<TextBasedGame::Session> base;
+        std::unique_ptr<TextBasedGame::Session> scratch;
+        /*  this thread's copies of the special commands (regexes aren't shared between threads)  */
+        std::vector<Command> commands;
+
+        State state, child;
+        /*  layout id of state  */
+        uint32_t layout = 0;
+        std::vector<uint32_t> packed;
+        std::vector<uint32_t> nearby;
+        std::vector<RoomGraph::Exit> exits;
+
+        /*  states first found this level, and the winning ones among them  */
+        std::vector<uint32_t> found;
+        std::vector<uint32_t> wins;
+        /*  every command tried: [from, count, (to, action)...] per state, for finding dead ends  */
+        std::vector<uint32_t> edges;
+        /*  where the state being expanded starts in edges  */
+        size_t edgeStart = 0;
+    };
+
+    TextBasedGame &game;
+    Config config;
+    uint32_t goal;
+
+    /*  where every item is in the world, and which ones start in the inventory  */
+    std::vector<uint32_t> baseLocations;
+    std::vector<uint32_t> baseInventory;
+
+    /*  per item: the search takes/drops it (relevant), and its specials (start index, count)  */
+    std::vector<uint8_t> relevant;
+    std::vector<std::pair<uint32_t, uint32_t>> specialsOf;
+    std::vector<SpecialCommand> specials;
+
+    /*  exit names special commands made up while solving, numbered after the world's own labels  */
+    uint32_t worldLabelCount;
+    std::vector<std::string> extraLabels;
+    std::unordered_map<std::string, uint32_t> extraLabelIds;
+    std::mutex extraLabelMutex;
+
+    std::unique_ptr<StateShard[]> stateShards;
+    std::unique_ptr<LayoutShard[]> layoutShards;
+    std::atomic<size_t> stateCount;
+    std::atomic<size_t> layoutCount;
+    /*  maxStates was hit  */
+    std::atomic<bool> truncated;
+
+    std::vector<std::unique_ptr<Worker>> workers;
+
+    /*  finds the items worth taking (see class doc)  */
+    void FindRelevantItems(ThreadPool &pool);
+
+    /*
+        runs a special command on a copy of w.base with item held or not,
+        outcome = what it printed and changed
+    */
+    void Probe(Worker &w, uint32_t special, uint32_t item, bool held, std::vector<std::string> &outcome);
+
+    /*  packs/unpacks a state's layout (see State)  */
+    static void PackLayout(State const& s, std::vector<uint32_t> &out);
+    static void UnpackLayout(uint32_t const *words, State &s);
+    /*  how many words the packed layout at words[0] takes  */
+    static uint32_t LayoutSize(uint32_t const *words);
+    static uint64_t Hash(uint32_t const *words, size_t count);
+
+    /*  id of a packed layout, adding it if it's new  */
+    uint32_t InternLayout(std::vector<uint32_t> const& packed);
+
+    /*
+        adds a state if it's new, returns its id and whether it was
+        if it was found this level from an earlier position (smaller rank), it remembers that way instead
+    */
+    std::pair<uint32_t, bool> Insert(uint32_t room, uint32_t layout, uint32_t parent, uint32_t action, uint32_t depth, uint64_t rank);
+
+    /*  double a shard's slots, call with its mutex held  */
+    static void Grow(StateShard &shard);
+    static void Grow(LayoutShard &shard);
+
+    /*  copies a stored state out (the shards may be growing meanwhile), returns its depth  */
+    uint32_t Load(uint32_t id, State &s, uint32_t &layout);
+
+    /*  a stored state's node, only while nothing is being added  */
+    Node& GetNode(uint32_t id);
+
+    /*  location of an item in a state  */
+    uint32_t LocationOf(State const& s, uint32_t item);
+    /*  sets an item's location in a state, keeping items canonical  */
+    void SetLocation(State &s, uint32_t item, uint32_t location);
+
+    /*  label of a session's exit name in the search's numbering (see extraLabels), and back  */
+    uint32_t GlobalLabel(TextBasedGame::Session &session, uint32_t label);
+    uint32_t SessionLabel(uint32_t label);
+    std::string LabelName(uint32_t label);
+
+    /*  sets w.base up as the state  */
+    void Restore(Worker &w, State const& s);
+
+    /*  runs a special command on a copy of w.base, the state it ends up in goes to w.child - false if it threw  */
+    bool RunSpecial(Worker &w, uint32_t special, State const& from);
+
+    /*  tries every command in one state, adding what they lead to  */
+    void Expand(Worker &w, uint32_t id, uint64_t position);
+
+    /*  adds a state as reached from id with action, remembers it in w.found/wins/edges  */
+    void Reach(Worker &w, uint32_t id, uint32_t room, uint32_t layout, uint32_t action, uint32_t depth, uint64_t rank);
+
+    /*  same, for the state in w.child (packing and interning its layout)  */
+    void Reach(Worker &w, uint32_t id, uint32_t action, uint32_t depth, uint64_t rank);
+
+    /*  what to type for an action  */
+    std::string CommandText(uint32_t action);
+
+    /*  the commands that lead from the start to a state  */
+    std::vector<std::string> PathTo(uint32_t id);
+
+    /*  plays commands on a new session, true if it ends up in the goal room  */
+    bool Verify(std::vector<std::string> const& commands);
+
+    /*  marks every state that can't win any more, fills in deadEnds and pointsOfNoReturn  */
+    void FindDeadEnds(Result &result);
+};
+
+#endif /* __SOLVER__ */
@@ -0,0 +1,38 @@
+#include "stdiofrontend.hpp"
+
+StdioFrontend::StdioFrontend(std::istream &_in, std::ostream &_out) : in(_in), out(_out) {}
+
+Frontend::Event StdioFrontend::Poll() {
+    out << Frontend::PlayerPrompt << std::flush;
+    if (!std::getline(in, textIn)) {
+        out << std::endl;
+        return Event::Close;
+    }
+    if (!textIn.empty() && textIn.back() == '\r') {
+        textIn.pop_back();
+    }
+    return Event::Enter;
+}
+
+bool StdioFrontend::WaitsForKeys() {
+    return false;
+}
+
+std::string StdioFrontend::GetTextIn() {
+    return textIn;
+}
+
+void StdioFrontend::SetTextIn(std::string s) {
+    textIn = s;
+}
+
+std::string StdioFrontend::GetTextOut(int line) {
+    return textOut[line];
+}
+
+void StdioFrontend::SetTextOut(std::string s, int line) {
+    textOut[line] = s;
+    if (s.find_first_not_of(" \t\n") != std::string::npos) {
+        out << s.substr(0, s.find_last_not_of(" \t\n") + 1) << '\n';
+    }
+}
@@ -0,0 +1,40 @@
+#ifndef __STDIOFRONTEND__
+#define __STDIOFRONTEND__
+
+#include <iostream>
+#include <string>
+
+#include "frontend.hpp"
+
+/*
+    Plays the game as plain text: every line of game text is printed to an output stream as it's
+    written, and every line read from an input stream is entered like the player typed it + ENTER
+    runs out (Close) at the end of the input, so commands can be piped in:
+        printf "take red key\nn\n" | ./build/game --stdio
+*/
+class StdioFrontend : public Frontend {
+    private:
+
+    std::istream &in;
+    std::ostream &out;
+
+    std::string textIn;
+    std::string textOut[LineOutCount];
+
+    public:
+
+    /*  StdioFrontend constructor - defaults to the terminal  */
+    StdioFrontend(std::istream &_in = std::cin, std::ostream &_out = std::cout);
+
+    /*  prints the prompt and waits for a whole line  */
+    Event Poll() override;
+    bool WaitsForKeys() override;
+
+    std::string GetTextIn() override;
+    void SetTextIn(std::string s) override;
+    std::string GetTextOut(int line) override;
+    /*  prints the line straight away (blank ones are just padding, those are skipped)  */
+    void SetTextOut(std::string s, int line) override;
+};
+
+#endif /* __STDIOFRONTEND__ */
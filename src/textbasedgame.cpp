@@ -2,25 +2,50 @@
 
 /* ------- TEXTBASEDGAME ------- */
 
-TextBasedGame::TextBasedGame() {
-    graphics = new Graphics();
-    state = GameState::Loading;
+TextBasedGame::TextBasedGame(std::unique_ptr<Frontend> _frontend) {
+    frontend = std::move(_frontend);
+    mainSession.frontend = frontend.get();
+    mainSession.roomGraph = std::make_shared<RoomGraph>();
+    worldFingerprint = 0;
+    frameCount = 0;
+    startTime = std::chrono::steady_clock::now();
+    journalFlush = Timers::None;
+    nextFrame = 0;
+    simSteps = 0;
+    hintValid = false;
+    frontend->SetTimers(&timers);
+    frontend->SetProfiler(&profiler);
 }
 
 TextBasedGame::~TextBasedGame() {
-    delete graphics;
+    if (mainSession.transcript) {
+        StopRecording();
+    }
 }
 
 void TextBasedGame::Init() {
 
-    currentRoom = "Kitchen";
-
     InitRooms();
     InitItems();
+    InitNPCs();
+    InitCommands();
+
+    Current()->currentRoom = rooms.GetId("Kitchen");
+    Current()->state = GameState::Playing;
+    SaveWorldTemplate();
+    Write(fmt::format("You are in the {}.", rooms.Get(Current()->currentRoom).GetRepr()));
+}
+
+void TextBasedGame::Init(WorldGen::Config const& worldConfig) {
+
+    WorldGen gen(worldConfig);
+    gen.Generate(*this);
     InitCommands();
 
-    state = GameState::Playing;
-    Write(fmt::format("You are in the {}.", rooms.Get(currentRoom).GetRepr()));
+    Current()->currentRoom = rooms.GetId(gen.GetStartRoom());
+    Current()->state = GameState::Playing;
+    SaveWorldTemplate();
+    Write(fmt::format("You are in the {}.", rooms.Get(Current()->currentRoom).GetRepr()));
 }
 
 void TextBasedGame::InitRooms() {
@@ -28,20 +53,20 @@ void TextBasedGame::InitRooms() {
     /* creating */
 
     for (auto &room : std::vector<Room>{
-        Room("Kitchen", "kitchen", Room::MakeEmptyPaths(), std::unordered_map<Room::Message, std::string>{
+        Room("Kitchen", "kitchen", std::unordered_map<Room::Message, std::string>{
             { Room::Message::OnEnter, "You have entered the kitchen." },
             { Room::Message::OnLook, "You are in the kitchen." }
         }),
-        Room("Bedroom", "bedroom", Room::MakeEmptyPaths(), std::unordered_map<Room::Message, std::string>{
+        Room("Bedroom", "bedroom", std::unordered_map<Room::Message, std::string>{
             { Room::Message::OnEnter, "You have entered the bedroom." },
             { Room::Message::OnLook, "You are in the bedroom." }
         }),
-        Room("Garden", "garden", Room::MakeEmptyPaths(), std::unordered_map<Room::Message, std::string>{
+        Room("Garden", "garden", std::unordered_map<Room::Message, std::string>{
             { Room::Message::OnEnter, "You have entered the garden." },
             { Room::Message::OnLook, "You are in the garden." }
         }),
     }) {
-        rooms.Add(room.GetName(), room);
+        AddRoom(room);
     }
 
     /* linking */
@@ -59,30 +84,69 @@ void TextBasedGame::InitItems() {
         }),
         Item("Red Door", "red door", std::unordered_map<Item::Message, std::string>{
             { Item::Message::OnInspect, "This red door stands on the north side of the room, and it has a keyhole in the knob." }
-        }, std::vector<Command>{
-            Command("unlock (red )?door", {"unlock red door"}, [&]{
-                if (IsItemInInv("Red Key")) {
-                    player.RemoveItemFromInv("Red Key");
-                    LinkRooms("Bedroom", Direction::North, "Garden");
-                    Write(std::vector<std::string>{
-                        "You unlocked the red door.\n...",
-                        "You can now go north.\n...",
-                    });
-                } else {
-                    Write("You don't have a key!");
-                }
-            })
-        },
+        }, std::vector<Command>{},
         Item::Attrs { false } ,
         Item::Flags { false } ),
     }) {
-        items.Add(item.GetName(), item);
+        AddItem(item);
     }
     
     /* adding */
 
     AddItemToRoom("Red Key", "Kitchen");
     AddItemToRoom("Red Door", "Bedroom");
+
+    /* scripts */
+
+    auto unlockRedDoor = AddScript("Red Door", "unlock (red )?door", {"unlock red door"}, R"(
+        if holding "Red Key"
+            move "Red Key" to nowhere
+            link "Bedroom" north "Garden" south
+            say "You unlocked the red door.\n..."
+            say "You can now go north.\n..."
+        else
+            say "You don't have a key!"
+        end
+    )");
+
+    /* rules */
+
+    /* "use red key" does the same as "unlock red door", where there's a door to use it on */
+    AddRule(EventBus::Event::OnUse, "Red Key", [this, unlockRedDoor](uint32_t) -> std::string {
+        if (Current()->currentRoom != rooms.GetId("Bedroom")) {
+            return "There's nothing to use it on here.";
+        }
+        RunScript(unlockRedDoor);
+        return "";
+    });
+}
+
+void TextBasedGame::InitNPCs() {
+
+    /* creating */
+
+    AddNPC(NPC("Gardener", "gardener", std::unordered_map<NPC::Message, std::string>{
+        { NPC::Message::OnInspect, "An old gardener, kneeling in a flower bed." },
+        { NPC::Message::OnRefuse, "\"Keep it, I've got everything I need out here.\"" }
+    }), std::vector<Dialogue::Line>{
+        /* 0 */ { "\"Oh! Nobody's come through that door in years.\"", {
+            { "Who are you?", 1 },
+            { "What is this place?", 2 },
+            { "Bye.", Dialogue::End }
+        } },
+        /* 1 */ { "\"Just the gardener. Somebody has to keep the roses going.\"", {
+            { "What is this place?", 2 },
+            { "Bye.", Dialogue::End }
+        } },
+        /* 2 */ { "\"The garden, of course. That's all there is past the red door.\"", {
+            { "Who are you?", 1 },
+            { "Bye.", Dialogue::End }
+        } }
+    });
+
+    /* adding */
+
+    AddNPCToRoom("Gardener", "Garden");
 }
 
 void TextBasedGame::InitCommands() {
@@ -91,22 +155,31 @@ void TextBasedGame::InitCommands() {
 
     /* movement */
 
-    commands.Add("Move: North", Command("(go|move )?n(orth)?", { "go north", "move north", "north" }, [&]{ TryMove(Direction::North); }));
-    commands.Add("Move: South", Command("(go|move )?s(outh)?", { "go south", "move south", "south" }, [&]{ TryMove(Direction::South); }));
-    commands.Add("Move: East", Command("(go|move )?e(ast)?", { "go east", "move east", "east" }, [&]{ TryMove(Direction::East); }));
-    commands.Add("Move: West", Command("(go|move )?w(est)?", { "go west", "move west", "west" }, [&]{ TryMove(Direction::West); }));
+    commands.Add("Move: North", Command("(go |move )?n(orth)?", { "go north", "move north", "north" }, [&]{ TryMove(Direction::North); }));
+    commands.Add("Move: South", Command("(go |move )?s(outh)?", { "go south", "move south", "south" }, [&]{ TryMove(Direction::South); }));
+    commands.Add("Move: East", Command("(go |move )?e(ast)?", { "go east", "move east", "east" }, [&]{ TryMove(Direction::East); }));
+    commands.Add("Move: West", Command("(go |move )?w(est)?", { "go west", "move west", "west" }, [&]{ TryMove(Direction::West); }));
+    commands.Add("Move: Up", Command("(go |move |climb )?u(p)?", { "go up", "climb up", "up" }, [&]{ TryMove(Direction::Up); }));
+    commands.Add("Move: Down", Command("(go |move |climb )?d(own)?", { "go down", "climb down", "down" }, [&]{ TryMove(Direction::Down); }));
+    commands.Add("Move: In", Command("(go |move )?in(side)?|enter", { "go in", "go inside", "enter" }, [&]{ TryMove(Direction::In); }));
+    commands.Add("Move: Out", Command("(go |move )?out(side)?|leave", { "go out", "go outside", "leave" }, [&]{ TryMove(Direction::Out); }));
+    /* walking somewhere far away - "go to the garden" */
+    commands.Add("Move: Travel", Command("(go|travel|walk) to (the )?(.+)", {}, [&](std::smatch const &m){ TryTravel(m[3].str()); }));
+    /* any other exit name - "go portal", "go through trapdoor" */
+    commands.Add("Move: Named Exit", Command("(go|move) (through |into )?(.+)", {}, [&](std::smatch const &m){ TryMove(m[3].str()); }));
     commands.Add("Move: Unknown Direction", Command("(go|move ).*", {}, [&]{ Write(Messages::InvalidDir); }));
 
     /* inspection + visual */
 
     commands.Add("Get Current Room", Command("(where am i)|((current )?room)", { "current room", "room", "where am i" },
-        [&]{ Write(fmt::format("You are in the {}.", rooms.Get(currentRoom).GetRepr())); })
+        [&]{ Write(fmt::format("You are in the {}.", rooms.Get(Current()->currentRoom).GetRepr())); })
     );
     commands.Add("Look Around", Command("look( around)?", {"look around"}, [&]{
-        for (auto &item : rooms.Get(currentRoom).GetItems()) {
-            items.Get(item).GetAttrs().isFound = true;
+        for (auto itemId : Current()->roomItems.Get(Current()->currentRoom)) {
+            SetItemFound(itemId, true);
         }
-        Write(rooms.Get(currentRoom).GetMessage(Room::Message::OnLook) + " " + CurrentRoomRepr());
+        std::string npcsHere = NPCsHereRepr();
+        Write(rooms.Get(Current()->currentRoom).GetMessage(Room::Message::OnLook) + " " + CurrentRoomRepr() + (npcsHere.empty() ? "" : " " + npcsHere));
     }));
     commands.Add("Check Inventory", Command("(check )?inv(entory)?", { "check inventory", "inventory" }, [&]{ Write(InventoryRepr()); }));
 
@@ -125,6 +198,12 @@ void TextBasedGame::InitCommands() {
 
         commands.Add(fmt::format("Inspect Item: {}", name), Command(fmt::format("(look at|inspect) {}", name), { fmt::format("inspect {}", repr), fmt::format("look at {}", repr) }, [&]{ TryInspectItem(name); }));
         commands.Add(fmt::format("Inspect Item: {} (No Hints)", name), Command(fmt::format("(look at|inspect) {}", name), {}, [&]{ TryInspectItem(name); }));
+
+        /* only items something happens with */
+        if (events.Has(EventBus::Event::OnUse, items.GetId(name))) {
+            commands.Add(fmt::format("Use Item: {}", name), Command(fmt::format("use {}", name), { fmt::format("use {}", repr) }, [&]{ TryUseItem(name); }));
+            commands.Add(fmt::format("Use Item: {} (No Hints)", name), Command(fmt::format("use {}", name), {}, [&]{ TryUseItem(name); }));
+        }
     }
 
     /* take/drop failsafes */
@@ -133,18 +212,41 @@ void TextBasedGame::InitCommands() {
     commands.Add("Take Item: Unknown", Command("take.*", {}, [&]{ Write(Messages::UnknownTake); }));
     commands.Add("Drop Item: Invalid", Command("drop .*", {}, [&]{ Write(Messages::InvalidDrop); }));
     commands.Add("Drop Item: Unknown", Command("drop.*", {}, [&]{ Write(Messages::UnknownDrop); }));
+    commands.Add("Use Item: Invalid", Command("use .*", {}, [&]{ Write(Messages::CannotUse); }));
+    commands.Add("Use Item: Unknown", Command("use.*", {}, [&]{ Write(Messages::UnknownUse); }));
+
+    /* NPCs - talking, giving */
+
+    for (auto& [name, npc] : npcs) {
+        auto repr = npc.GetRepr();
+        commands.Add(fmt::format("Talk To: {}", name), Command(fmt::format("(talk|speak) (to|with) (the )?{}", name), { fmt::format("talk to {}", repr) }, [&]{ TryTalk(name); }));
+        commands.Add(fmt::format("Inspect NPC: {}", name), Command(fmt::format("(look at|inspect) (the )?{}", name), { fmt::format("look at {}", repr) }, [&]{
+            Write(npcs.Get(name).GetMessage(NPC::Message::OnInspect));
+        }));
+    }
+    commands.Add("Talk: Invalid", Command("(talk|speak) .*", {}, [&]{ Write(Messages::InvalidTalk); }));
+    commands.Add("Talk: Unknown", Command("(talk|speak).*", {}, [&]{ Write(Messages::UnknownTalk); }));
+    /* the item and NPC are looked up by repr, so one command does every pair */
+    commands.Add("Give Item", Command("give (the )?(.+) to (the )?(.+)", {}, [&](std::smatch const &m){ TryGiveItem(m[2].str(), m[4].str()); }));
+    commands.Add("Give Item: Unknown", Command("give.*", {}, [&]{ Write(Messages::UnknownGive); }));
 
     /* settings - text scroll speed */
     commands.Add("Set Text Scroll Speed: Slow", Command("set (textspeed|ts) (s(low)?)|(1)", { "set textspeed slow", "set ts slow" }, [&]{
-        graphics->ChangeTextSpeed(Graphics::TextSpeed::Slow);
+        if (Current()->frontend) {
+            Current()->frontend->ChangeTextSpeed(Frontend::TextSpeed::Slow);
+        }
         Write(Messages::TextSpeedSet);
     }));
     commands.Add("Set Text Scroll Speed: Medium", Command("set (textspeed|ts) (m(ed(ium)?)?)|(2)", { "set textspeed med", "set ts med" }, [&]{
-        graphics->ChangeTextSpeed(Graphics::TextSpeed::Medium);
+        if (Current()->frontend) {
+            Current()->frontend->ChangeTextSpeed(Frontend::TextSpeed::Medium);
+        }
         Write(Messages::TextSpeedSet);
     }));
     commands.Add("Set Text Scroll Speed: Fast", Command("set (textspeed|ts) (f(ast)?)|(3)", { "set textspeed fast", "set ts fast" }, [&]{
-        graphics->ChangeTextSpeed(Graphics::TextSpeed::Fast);
+        if (Current()->frontend) {
+            Current()->frontend->ChangeTextSpeed(Frontend::TextSpeed::Fast);
+        }
         Write(Messages::TextSpeedSet);
     }));
     commands.Add("Set Text Scroll Speed: Invalid", Command("set (textspeed|ts).*", {}, [&]{ Write(Messages::InvalidTextSpeed); }));
@@ -155,7 +257,9 @@ void TextBasedGame::InitCommands() {
         "set cursor 1",
         "set cs 1"
     }, [&]{
-        graphics->ChangeCursorStyle(Graphics::CursorStyle::VerticalBar);
+        if (Current()->frontend) {
+            Current()->frontend->ChangeCursorStyle(Frontend::CursorStyle::VerticalBar);
+        }
         Write(Messages::CursorStyleSet);
     }));
     commands.Add("Set Cursor Style: Underline", Command("set (cursor( style)?|cs|c) 2", {
@@ -163,7 +267,9 @@ void TextBasedGame::InitCommands() {
         "set cursor 2",
         "set cs 2"
     }, [&]{
-        graphics->ChangeCursorStyle(Graphics::CursorStyle::Underline);
+        if (Current()->frontend) {
+            Current()->frontend->ChangeCursorStyle(Frontend::CursorStyle::Underline);
+        }
         Write(Messages::CursorStyleSet);
     }));
     commands.Add("Set Cursor Style: OutlineBox", Command("set (cursor( style)?|cs|c) 3", {
@@ -171,7 +277,9 @@ void TextBasedGame::InitCommands() {
         "set cursor 3",
         "set cs 3"
     }, [&]{
-        graphics->ChangeCursorStyle(Graphics::CursorStyle::OutlineBox);
+        if (Current()->frontend) {
+            Current()->frontend->ChangeCursorStyle(Frontend::CursorStyle::OutlineBox);
+        }
         Write(Messages::CursorStyleSet);
     }));
     commands.Add("Set Cursor Style: TransparentBox", Command("set (cursor( style)?|cs|c) 4", {
@@ -179,12 +287,23 @@ void TextBasedGame::InitCommands() {
         "set cursor 4",
         "set cs 4"
     }, [&]{
-        graphics->ChangeCursorStyle(Graphics::CursorStyle::TransparentBox);
+        if (Current()->frontend) {
+            Current()->frontend->ChangeCursorStyle(Frontend::CursorStyle::TransparentBox);
+        }
         Write(Messages::CursorStyleSet);
     }));
     commands.Add("Set Cursor Style: Invalid", Command("set (cursor( style)?|cs|c).*", {}, [&]{
         Write(Messages::InvalidCursorStyle);
     }));
+
+    /* settings - undo depth */
+    commands.Add("Set Undo Depth", Command("set undo (.*)", { "set undo 100" }, [&](std::smatch const &m){ TrySetUndoDepth(m[1].str()); }));
+    commands.Add("Set Undo Depth: Invalid", Command("set undo.*", {}, [&]{ Write(Messages::InvalidUndoDepth); }));
+
+    /* settings - profiler */
+    commands.Add("Set Profiler", Command("set profiler (on|off)", { "set profiler on", "set profiler off" }, [&](std::smatch const &m){ TrySetProfiler(m[1].str()); }));
+    commands.Add("Set Profiler: Invalid", Command("set profiler.*", {}, [&]{ Write(Messages::InvalidProfiler); }));
+    commands.Add("Save Trace", Command("save trace", { "save trace" }, [&]{ TrySaveTrace(); }));
     
     /* misc. system */
     commands.Add("General Help", Command("help( me)?", {
@@ -194,11 +313,15 @@ void TextBasedGame::InitCommands() {
     }, [&]{
         Write(std::vector<std::string>{
             "look around\n"
-            "go <north/south/east/west>\n"
-            "take/drop <item>\n"
+            "go <north/south/east/west/up/down/...>\n"
+            "go to <room>\n"
             "...",
 
+            "take/drop <item>\n"
             "check inventory\n"
+            "save/load\n"
+            "...",
+
             "settings\n"
             "quit\n"
             "..."
@@ -207,103 +330,811 @@ void TextBasedGame::InitCommands() {
     commands.Add("List Settings", Command("settings", { "settings", "game settings" }, [&]{
         Write(
             "set textspeed <slow/med/fast>\n"
-            "set cursor <1/2/3/4>"
+            "set cursor <1/2/3/4>\n"
+            "set undo <number of moves>\n"
+            "set profiler <on/off>\n"
+            "save trace"
         );
     }));
-    commands.Add("Exit Game", Command("(q(uit)?|exit)( game)?", { "exit game", "quit game" }, [&]{ ChangeState(GameState::ExitMenu); }));
+    commands.Add("Save Game", Command("save( game)?", { "save game", "save" }, [&]{ TrySave(); }));
+    commands.Add("Load Game", Command("(load|restore)( game)?", { "load game", "load", "restore" }, [&]{ TryLoad(); }));
+    commands.Add("Restart Game", Command("restart( game)?|new game", { "restart game", "new game" }, [&]{ TryRestart(); }));
+    commands.Add("Undo", Command("undo", { "undo" }, [&]{ TryUndo(); }));
+    commands.Add("Redo", Command("redo", { "redo" }, [&]{ TryRedo(); }));
+    commands.Add("Exit Game", Command("(q(uit)?|exit)( game)?", { "exit game", "quit game" }, [&]{ StartFlow(ExitMenu()); }));
 
     /* failsafes */
     commands.Add("Unknown Setting", Command("set.*", {}, [&]{ Write("What do you want to set?\nUsage: set <setting> <arg>"); }));
     commands.Add("Invalid Command", Command(".*", {}, [&]{ Write(Messages::InvalidCommand); }));
 
-    commands.Add("Exit: Yes", Command("(y(es)?)|(exit)|(quit)", { "yes", "exit", "quit" }, []{ throw ExitGameException(); }));
-    commands.Add("Exit: No", Command("n(o)?", { "no" }, [&]{ ChangeState(GameState::Playing); }));
-    commands.Add("Exit: Unknown", Command(".*", {}, [&]{ Write(Messages::InvalidExitCommand); }));
+    /* what flows accept (see ExitMenu and Talk) - they only match these, never run them */
+    commands.Add("Exit: Yes", Command("(y(es)?)|(exit)|(quit)", { "yes", "exit", "quit" }));
+    commands.Add("Exit: No", Command("n(o)?", { "no" }));
+
+    commands.Add("Talk: Reply", Command("([0-9]+)\\.?", {}));
+    commands.Add("Talk: Bye", Command("(good)?bye|leave|stop( talking)?", { "bye", "goodbye" }));
 }
 
 
 void TextBasedGame::Run() {
-    static Timer backspaceTimer(0.1);
-    while (!WindowShouldClose()) {
-        /*  Get char pressed (unicode character) on the queue  */
-        int key = GetCharPressed();
-
-        /*  Check if more characters have been pressed on the same frame  */
-        while (key > 0) {
-            /*  NOTE: Only allow keys in range [32..125]  */
-            if ((key >= 32) && (key <= 125)) {
-                graphics->AddCharIn((char) key);
-            }
-            /*  Check next character in the queue  */
-            key = GetCharPressed();
-        }
+    while (RunFrame()) {
+        ScheduleJournalFlush();
+        NextFrame(frontend.get());
+    }
+}
 
-        if (IsKeyDown(KEY_BACKSPACE) && backspaceTimer.IntervalPassed()) {
-            graphics->DelCharIn();
-        } else if (IsKeyPressed(KEY_BACKSPACE)) {
-            graphics->DelCharIn();
-        } else if (IsKeyPressed(KEY_ENTER)) {
-            if (!graphics->IsQueueEmpty()) {
-                graphics->DumpText();
+bool TextBasedGame::RunFrame() {
+    {
+        Profiler::Scope frame(Profiling(), Profiler::Phase::Frame);
+        Frontend::Event event;
+        {
+            Profiler::Scope poll(Profiling(), Profiler::Phase::Poll);
+            event = frontend->Poll();
+        }
+        if (event == Frontend::Event::Close) {
+            return false;
+        }
+        if (event == Frontend::Event::Enter) {
+            if (!frontend->IsQueueEmpty()) {
+                frontend->DumpText();
+            } else if (Current()->flow.GetWait() == Flow::Wait::Key) {
+                Current()->flow.Resume();
+                hintValid = false;
             } else {
                 Eval(Read());
             }
-        } else if (IsKeyPressed(KEY_TAB)) {
-            /*  also clears hint  */
-            graphics->AddHintToInput();
+        } else if (event == Frontend::Event::Key && Current()->flow.GetWait() == Flow::Wait::Key) {
+            /* any key turns the page, once it's all showing */
+            if (!frontend->IsQueueEmpty()) {
+                frontend->DumpText();
+            } else {
+                Current()->flow.Resume();
+                hintValid = false;
+            }
         }
 
         UpdateHint();
-        graphics->Draw();
+        Simulate(frontend.get());
+        Render(frontend.get());
+        frameCount++;
+    }
+    if (profiler.IsOn()) {
+        profiler.EndFrame();
     }
+    return true;
 }
 
-void TextBasedGame::ChangeState(TextBasedGame::GameState newState) {
-    /* if user typed "exit" */
-    if (state == GameState::Playing && newState == GameState::ExitMenu) {
-        Write(Messages::ExitConfirmation);
+Profiler const& TextBasedGame::GetProfiler() const {
+    return profiler;
+}
+
+double TextBasedGame::GetRunTime() {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+}
+
+void TextBasedGame::Simulate(Frontend *out) {
+    uint64_t due = static_cast<uint64_t>(GetRunTime() * Frontend::StepRate);
+    if (due - simSteps > MaxStepsPerFrame) {
+        simSteps = due - MaxStepsPerFrame;
     }
-    /* if user typed "exit" then "no" */
-    else if (state == GameState::ExitMenu && newState == GameState::Playing) {
-        Write(fmt::format("You are in the {}.", currentRoom));
+    Profiler::Scope scope(Profiling(), Profiler::Phase::TextReveal);
+    for (; simSteps < due; simSteps++) {
+        out->Step();
+    }
+}
+
+Profiler *TextBasedGame::Profiling() {
+    return (profiler.IsOn() && Current() == &mainSession) ? &profiler : nullptr;
+}
+
+void TextBasedGame::TrySetProfiler(std::string onOff) {
+    if (Current() != &mainSession) {
+        Write(Messages::NoProfiler);
+        return;
+    }
+    profiler.SetOn(onOff == "on");
+    Write(profiler.IsOn() ? Messages::ProfilerOn : Messages::ProfilerOff);
+}
+
+void TextBasedGame::TrySaveTrace() {
+    if constexpr (!Trace::Enabled) {
+        Write(Messages::NoTraceBuilt);
+        return;
+    }
+    if (Current() != &mainSession) {
+        Write(Messages::NoTraceOnline);
+        return;
+    }
+    try {
+        size_t saved = Trace::Save(TraceFileName);
+        Write(fmt::format("{}\n{} spans in {}.", Messages::TraceSaved, saved, TraceFileName));
+    } catch (std::runtime_error &e) {
+        Write(Messages::TraceFailed);
+    }
+}
+
+void TextBasedGame::Render(Frontend *out) {
+    if (out->IsVisible()) {
+        out->Draw();
+    } else {
+        out->SkipFrame();
+    }
+}
+
+void TextBasedGame::NextFrame(Frontend *out) {
+    double interval = out->GetFrameInterval();
+    double now = GetRunTime();
+    if (interval > 0) {
+        if (now >= nextFrame) {
+            /* if it's fallen behind by more than a frame, start counting again from now instead of rushing */
+            nextFrame = std::max(nextFrame + interval, now);
+        }
+        double wake = std::min(nextFrame, timers.NextDeadline());
+        if (wake > now) {
+            out->Sleep(wake - now);
+            now = GetRunTime();
+        }
+    }
+    timers.Update(now);
+}
+
+void TextBasedGame::ScheduleJournalFlush() {
+    if (!Current()->journal || timers.IsPending(journalFlush)) {
+        return;
+    }
+    double delay = Current()->journal->GetFlushDelay();
+    if (delay < 0) {
+        return;
+    }
+    journalFlush = timers.After(delay, [&]{
+        /* the journal couldn't be written - a whole new snapshot (and journal) is the next best thing */
+        if (Current()->journal && !Current()->journal->Poll()) {
+            CompactAutosave();
+        }
+        /* the batch written by BatchSize since could have been followed by a newer one */
+        ScheduleJournalFlush();
+    });
+}
+
+Flow TextBasedGame::ExitMenu() {
+    Write(Messages::ExitConfirmation);
+    while (true) {
+        std::string answer = co_await Flow::NextInput(ExitMenuCommands);
+        if (commands.Get("Exit: Yes").IsMatch(answer)) {
+            throw ExitGameException();
+        }
+        if (commands.Get("Exit: No").IsMatch(answer)) {
+            Write(fmt::format("You are in the {}.", rooms.Get(Current()->currentRoom).GetRepr()));
+            co_return;
+        }
+        Write(Messages::InvalidExitCommand);
+    }
+}
+
+Flow TextBasedGame::Pager(std::vector<std::string> pages) {
+    Frontend *out = Current()->frontend;
+    bool waits = out && out->WaitsForKeys();
+    for (size_t i = 0; i < pages.size(); i++) {
+        if (i > 0 && waits) {
+            co_await Flow::KeyPress();
+        }
+        Write(pages[i]);
+    }
+}
+
+Flow TextBasedGame::Pager(std::shared_ptr<Script const> script, std::array<uint32_t, Script::MaxPages> pages, size_t pageCount) {
+    Frontend *out = Current()->frontend;
+    bool waits = out && out->WaitsForKeys();
+    for (size_t i = 0; i < pageCount; i++) {
+        if (i > 0 && waits) {
+            co_await Flow::KeyPress();
+        }
+        Write(script->GetText(pages[i]));
+    }
+}
+
+void TextBasedGame::StartFlow(Flow flow) {
+    if (flow.IsWaiting()) {
+        Current()->flow = std::move(flow);
+    } else {
+        flow.Rethrow();
     }
-    
-    state = newState;
 }
 
 /* setup */
 
+void TextBasedGame::AddRoom(Room room) {
+    std::string repr = room.GetRepr();
+    std::transform(repr.begin(), repr.end(), repr.begin(), [](unsigned char c) { return std::tolower(c); });
+    if (!rooms.Contains(room.GetName())) {
+        Current()->roomItems.PushBack({});
+        roomVisits.emplace_back();
+    } else if (Current()->state == GameState::Loading) {
+        setupProblems.push_back(fmt::format("AddRoom(\"{}\"): there's already a room called that, this one is ignored", room.GetName()));
+        return;
+    }
+    rooms.Add(room.GetName(), room);
+    worldFingerprint = 0;
+    auto [it, added] = roomIdsByRepr.emplace(repr, rooms.GetId(room.GetName()));
+    if (!added && Current()->state == GameState::Loading) {
+        setupProblems.push_back(fmt::format("AddRoom(\"{}\"): \"{}\" is also what {} is called, \"go to {}\" only finds that one",
+            room.GetName(), room.GetRepr(), rooms.GetName(it->second), repr));
+    }
+}
+
+void TextBasedGame::AddItem(Item item) {
+    if (!items.Contains(item.GetName())) {
+        Current()->itemLocations.PushBack(Delta::Nowhere);
+        Current()->itemFound.PushBack(item.GetAttrs().isFound);
+    } else if (Current()->state == GameState::Loading) {
+        setupProblems.push_back(fmt::format("AddItem(\"{}\"): there's already an item called that, this one is ignored", item.GetName()));
+        return;
+    }
+    items.Add(item.GetName(), item);
+    worldFingerprint = 0;
+    std::string repr = item.GetRepr();
+    std::transform(repr.begin(), repr.end(), repr.begin(), [](unsigned char c) { return std::tolower(c); });
+    itemIdsByRepr.emplace(repr, items.GetId(item.GetName()));
+}
+
+void TextBasedGame::AddNPC(NPC npc, std::vector<Dialogue::Line> lines, std::vector<NPC::Trade> npcTrades) {
+    std::string name = npc.GetName();
+    if (npcs.Contains(name)) {
+        if (Current()->state == GameState::Loading) {
+            setupProblems.push_back(fmt::format("AddNPC(\"{}\"): there's already an NPC called that, this one is ignored", name));
+            return;
+        }
+        throw std::invalid_argument(fmt::format("AddNPC(\"{}\"): there's already an NPC called that", name));
+    }
+
+    /* while Loading, a broken conversation or trade is left out and the NPC is still added */
+    uint32_t root;
+    try {
+        root = dialogue.Add(lines);
+    } catch (std::invalid_argument const& e) {
+        if (Current()->state != GameState::Loading) {
+            throw std::invalid_argument(fmt::format("AddNPC(\"{}\"): {}", name, e.what()));
+        }
+        setupProblems.push_back(fmt::format("AddNPC(\"{}\"): {}, it has nothing to say", name, e.what()));
+        root = Dialogue::End;
+    }
+
+    uint32_t npcId = npcs.Size();
+    for (auto &trade : npcTrades) {
+        if (Current()->state == GameState::Loading) {
+            std::string call = fmt::format("AddNPC(\"{}\")", name);
+            bool knowWants = CheckSetupName(call, trade.wants, false);
+            bool knowGives = trade.gives.empty() || CheckSetupName(call, trade.gives, false);
+            if (!knowWants || !knowGives) {
+                continue;
+            }
+        }
+        uint64_t key = (static_cast<uint64_t>(npcId) << 32) | items.GetId(trade.wants);
+        trades[key] = TradeEntry { trade.gives.empty() ? Delta::Nowhere : items.GetId(trade.gives), dialogue.Intern(trade.message) };
+    }
+
+    std::string repr = npc.GetRepr();
+    std::transform(repr.begin(), repr.end(), repr.begin(), [](unsigned char c) { return std::tolower(c); });
+    npcs.Add(name, npc);
+    npcDialogue.push_back(root);
+    npcSchedules.push_back(NPCSchedule { 0, 0, 0, 0 });
+    npcIdsByRepr.emplace(repr, npcId);
+    npcRooms.push_back(Delta::Nowhere);
+}
+
+void TextBasedGame::AddNPCToRoom(std::string npcName, std::string roomName) {
+    if (Current()->state == GameState::Loading) {
+        std::string call = fmt::format("AddNPCToRoom(\"{}\", \"{}\")", npcName, roomName);
+        bool knowNPC = npcs.Contains(npcName);
+        if (!knowNPC) {
+            setupProblems.push_back(fmt::format("{}: there's no NPC called \"{}\"", call, npcName));
+        }
+        bool knowRoom = CheckSetupName(call, roomName, true);
+        if (!knowNPC || !knowRoom) {
+            return;
+        }
+    }
+    uint32_t npcId = npcs.GetId(npcName), roomId = rooms.GetId(roomName);
+    if (npcSchedules[npcId].count != 0) {
+        throw std::invalid_argument(fmt::format("AddNPCToRoom(\"{}\", \"{}\"): it has a schedule", npcName, roomName));
+    }
+    TakeNPCOut(npcId);
+    npcRooms[npcId] = roomId;
+    roomVisits[roomId].push_back(NPCVisit { npcId, 0, 0 });
+}
+
+void TextBasedGame::AddNPCSchedule(std::string npcName, std::vector<NPC::Stop> stops, uint32_t offset) {
+    std::string call = fmt::format("AddNPCSchedule(\"{}\")", npcName);
+    if (Current()->state == GameState::Loading) {
+        if (!npcs.Contains(npcName)) {
+            setupProblems.push_back(fmt::format("{}: there's no NPC called \"{}\"", call, npcName));
+            return;
+        }
+        /* stops in rooms that don't exist, or that last no time at all, are left out */
+        std::erase_if(stops, [&](NPC::Stop const& stop) {
+            if (stop.turns == 0) {
+                setupProblems.push_back(fmt::format("{}: the stop in \"{}\" lasts 0 turns", call, stop.room));
+                return true;
+            }
+            return !CheckSetupName(call, stop.room, true);
+        });
+        if (stops.empty()) {
+            return;
+        }
+    }
+    uint32_t npcId = npcs.GetId(npcName);
+    if (npcSchedules[npcId].count != 0) {
+        throw std::invalid_argument(fmt::format("{}: it already has a schedule", call));
+    }
+
+    NPCSchedule schedule { static_cast<uint32_t>(scheduleStops.size()), static_cast<uint32_t>(stops.size()), 0, 0 };
+    for (auto &stop : stops) {
+        schedule.period += stop.turns;
+        scheduleStops.push_back(ScheduleStop { rooms.GetId(stop.room), schedule.period });
+    }
+    schedule.offset = offset % schedule.period;
+    npcSchedules[npcId] = schedule;
+    if (schedule.count > 1) {
+        scheduledNPCs.push_back(npcId);
+    }
+
+    TakeNPCOut(npcId);
+    uint32_t start = 0;
+    for (uint32_t i = 0; i < schedule.count; i++) {
+        auto &stop = scheduleStops[schedule.first + i];
+        /* a run of stops in the same room is one visit */
+        if (i + 1 < schedule.count && scheduleStops[schedule.first + i + 1].room == stop.room) {
+            continue;
+        }
+        roomVisits[stop.room].push_back(NPCVisit { npcId, start, stop.end });
+        start = stop.end;
+    }
+}
+
 void TextBasedGame::LinkRooms(std::string a, Direction d, std::string b, bool bothWays) {
-    rooms.Get(a).SetPath(d, b);
-    if (bothWays) {
-        rooms.Get(b).SetPath(DirectionReverse(d), a);
+    LinkRooms(a, DirectionRepr(d, false), b, bothWays ? DirectionRepr(DirectionReverse(d), false) : "");
+}
+
+void TextBasedGame::LinkRooms(std::string a, std::string exitName, std::string b, std::string reverseExitName) {
+    if (Current()->state == GameState::Loading) {
+        std::string call = fmt::format("LinkRooms(\"{}\", \"{}\", \"{}\")", a, exitName, b);
+        bool knowA = CheckSetupName(call, a, true);
+        bool knowB = CheckSetupName(call, b, true);
+        if (!knowA || !knowB) {
+            return;
+        }
+    }
+    uint32_t idA = rooms.GetId(a), idB = rooms.GetId(b);
+    SetExit(idA, MutableRoomGraph().Intern(exitName), idB);
+    if (!reverseExitName.empty()) {
+        SetExit(idB, MutableRoomGraph().Intern(reverseExitName), idA);
+    }
+}
+
+RoomGraph& TextBasedGame::MutableRoomGraph() {
+    if (Current()->roomGraph.use_count() > 1) {
+        Current()->roomGraph = std::make_shared<RoomGraph>(Current()->roomGraph);
+    }
+    return *Current()->roomGraph;
+}
+
+void TextBasedGame::SetExit(uint32_t from, uint32_t label, uint32_t target) {
+    if (Current()->state != GameState::Loading) {
+        Record(Delta { Delta::Kind::Exit, from, label, Current()->roomGraph->GetExit(from, label), target });
+        RememberLink(from, label, target);
+    }
+    if (target == RoomGraph::None) {
+        MutableRoomGraph().RemoveExit(from, label);
+    } else {
+        MutableRoomGraph().SetExit(from, label, target);
+    }
+}
+
+void TextBasedGame::RememberLink(uint32_t from, uint32_t label, uint32_t target) {
+    /* one entry per exit, however often it's set (undo, redo, the journal) - previous stays what the world had */
+    auto &links = Current()->dynamicLinks;
+    auto link = std::find_if(links.begin(), links.end(), [&](DynamicLink const& l) { return l.from == from && l.label == label; });
+    if (link != links.end()) {
+        link->target = target;
+    } else {
+        links.push_back(DynamicLink { from, label, target, Current()->roomGraph->GetExit(from, label) });
+    }
+}
+
+void TextBasedGame::RevertDynamicLinks() {
+    /* the world's exits never change, so just share them again */
+    Current()->roomGraph = worldTemplate.roomGraph;
+    Current()->dynamicLinks.clear();
+    Current()->pathFinder.Invalidate();
+}
+
+bool TextBasedGame::CheckSetupName(std::string const& call, std::string const& name, bool isRoom) {
+    if (isRoom ? rooms.Contains(name) : items.Contains(name)) {
+        return true;
     }
+    setupProblems.push_back(fmt::format("{}: there's no {} called \"{}\"", call, isRoom ? "room" : "item", name));
+    return false;
 }
 
 void TextBasedGame::AddItemToRoom(std::string itemName, std::string roomName) {
-    rooms.Get(roomName).AddItem(itemName);
+    if (Current()->state == GameState::Loading) {
+        std::string call = fmt::format("AddItemToRoom(\"{}\", \"{}\")", itemName, roomName);
+        bool knowItem = CheckSetupName(call, itemName, false);
+        bool knowRoom = CheckSetupName(call, roomName, true);
+        if (!knowItem || !knowRoom) {
+            return;
+        }
+        uint32_t from = Current()->itemLocations.Get(items.GetId(itemName));
+        if (from != Delta::Nowhere) {
+            setupProblems.push_back(fmt::format("{}: it was already {}, it's moved", call,
+                from == Delta::Inventory ? "in the inventory" : "in " + rooms.GetName(from)));
+        }
+    }
+    MoveItem(items.GetId(itemName), rooms.GetId(roomName));
 }
 
 void TextBasedGame::AddItemToInventory(std::string itemName) {
-    player.AddItemToInv(itemName);
+    if (Current()->state == GameState::Loading && !CheckSetupName(fmt::format("AddItemToInventory(\"{}\")", itemName), itemName, false)) {
+        return;
+    }
+    MoveItem(items.GetId(itemName), Delta::Inventory);
+}
+
+void TextBasedGame::AddRule(EventBus::Event event, std::string subject, EventBus::Handler handler) {
+    if (subject.empty()) {
+        events.On(event, EventBus::AnySubject, std::move(handler));
+        return;
+    }
+    bool isRoom = (event == EventBus::Event::OnEnter || event == EventBus::Event::OnTick);
+    if (Current()->state == GameState::Loading && !CheckSetupName(fmt::format("AddRule(\"{}\")", subject), subject, isRoom)) {
+        return;
+    }
+    events.On(event, isRoom ? rooms.GetId(subject) : items.GetId(subject), std::move(handler));
+}
+
+std::shared_ptr<Script const> TextBasedGame::AddScript(std::string itemName, std::string pattern, std::vector<std::string> hints, std::string source) {
+    std::string call = fmt::format("AddScript(\"{}\")", itemName);
+    if (Current()->state == GameState::Loading && !CheckSetupName(call, itemName, false)) {
+        return nullptr;
+    }
+
+    Script::Names names {
+        [&](std::string const& name) { return rooms.Contains(name) ? rooms.GetId(name) : Delta::Nowhere; },
+        [&](std::string const& name) { return items.Contains(name) ? items.GetId(name) : Delta::Nowhere; },
+        [&](std::string const& name) { return MutableRoomGraph().Intern(name); }
+    };
+    std::shared_ptr<Script const> script;
+    try {
+        script = std::make_shared<Script const>(Script::Compile(source, names));
+    } catch (std::invalid_argument const& e) {
+        if (Current()->state != GameState::Loading) {
+            throw std::invalid_argument(fmt::format("{}: {}", call, e.what()));
+        }
+        setupProblems.push_back(fmt::format("{}: {}, the script is ignored", call, e.what()));
+        return nullptr;
+    }
+
+    items.Get(itemName).GetSpecialCommands().push_back(Command(pattern, hints, [this, script]{ RunScript(script); }));
+    return script;
+}
+
+void TextBasedGame::RunScript(std::shared_ptr<Script const> const& script) {
+    auto &code = script->GetCode();
+    uint32_t r[Script::RegisterCount] = {};
+    std::array<uint32_t, Script::MaxPages> pages;
+    size_t pageCount = 0;
+
+    for (uint32_t pc = 0; ; pc++) {
+        auto &in = code[pc];
+        switch (in.op) {
+            case Script::Op::Load: r[in.a] = in.x; break;
+            case Script::Op::LoadRoom: r[in.a] = Current()->currentRoom; break;
+            case Script::Op::LoadItem: r[in.a] = Current()->itemLocations.Get(in.x); break;
+            case Script::Op::LoadFound: r[in.a] = Current()->itemFound.Get(in.x) ? 1 : 0; break;
+            case Script::Op::LoadExit: r[in.a] = Current()->roomGraph->GetExit(in.x, in.y); break;
+            /* jumps land one before where they go, the loop steps onto it */
+            case Script::Op::JumpIfEqual: if (r[in.a] == r[in.b]) { pc = in.x - 1; } break;
+            case Script::Op::JumpIfNotEqual: if (r[in.a] != r[in.b]) { pc = in.x - 1; } break;
+            case Script::Op::Jump: pc = in.x - 1; break;
+            case Script::Op::MoveItem: MoveItem(in.x, r[in.a]); break;
+            case Script::Op::SetExit: SetExit(in.x, in.y, r[in.a]); break;
+            case Script::Op::MoveTo: MoveTo(r[in.a]); break;
+            case Script::Op::SetFound: SetItemFound(in.x, r[in.a] != 0); break;
+            case Script::Op::Say:
+                if (pageCount < pages.size()) {
+                    pages[pageCount++] = in.x;
+                }
+                break;
+            case Script::Op::End:
+                /* one page is written like any other message, more get paged */
+                if (pageCount == 1) {
+                    Write(script->GetText(pages[0]));
+                } else if (pageCount > 1) {
+                    Write(script, std::span<uint32_t const>(pages.data(), pageCount));
+                }
+                return;
+        }
+    }
+}
+
+void TextBasedGame::RemoveItemFromInventory(std::string itemName) {
+    MoveItem(items.GetId(itemName), Delta::Nowhere);
+}
+
+/* state changes */
+
+void TextBasedGame::MoveTo(uint32_t roomId) {
+    uint32_t from = Current()->currentRoom;
+    /* throws out_of_range if there's no such room */
+    auto &roomName = rooms.GetName(roomId);
+    Current()->currentRoom = roomId;
+    if (Current()->frontend) {
+        Current()->frontend->SetBackgroundImage(roomName);
+    }
+    Record(Delta { Delta::Kind::CurrentRoom, 0, 0, from, roomId });
+}
+
+void TextBasedGame::MoveItem(uint32_t itemId, uint32_t location) {
+    uint32_t from = Current()->itemLocations.Get(itemId);
+    /* look the new room up first, so a bad id throws before anything has moved */
+    if (location < Delta::Inventory) {
+        Current()->roomItems.Get(location);
+    }
+    if (from == location) {
+        return;
+    }
+
+    /* room item lists are copied, changed and set back, so they're only this session's once they differ */
+    if (from == Delta::Inventory) {
+        Current()->player.RemoveItemFromInv(itemId);
+    } else if (from != Delta::Nowhere) {
+        auto fromRoom = Current()->roomItems.Get(from);
+        fromRoom.erase(std::find(fromRoom.begin(), fromRoom.end(), itemId));
+        Current()->roomItems.Set(from, std::move(fromRoom));
+    }
+
+    if (location == Delta::Inventory) {
+        Current()->player.AddItemToInv(itemId);
+    } else if (location != Delta::Nowhere) {
+        auto toRoom = Current()->roomItems.Get(location);
+        toRoom.push_back(itemId);
+        Current()->roomItems.Set(location, std::move(toRoom));
+    }
+
+    Current()->itemLocations.Set(itemId, location);
+    Record(Delta { Delta::Kind::ItemLocation, itemId, 0, from, location });
+}
+
+void TextBasedGame::TakeNPCOut(uint32_t npcId) {
+    uint32_t roomId = npcRooms[npcId];
+    if (roomId == Delta::Nowhere) {
+        return;
+    }
+    std::erase_if(roomVisits[roomId], [&](NPCVisit const& visit) { return visit.npc == npcId; });
+    npcRooms[npcId] = Delta::Nowhere;
+}
+
+uint32_t TextBasedGame::GetScheduledRoom(uint32_t npcId, uint32_t turn) {
+    auto &schedule = npcSchedules[npcId];
+    uint32_t t = static_cast<uint32_t>((static_cast<uint64_t>(turn) + schedule.offset) % schedule.period);
+    auto first = scheduleStops.begin() + schedule.first;
+    /* the first stop that ends after t */
+    auto stop = std::upper_bound(first, first + schedule.count, t, [](uint32_t t, ScheduleStop const& stop) { return t < stop.end; });
+    return stop->room;
+}
+
+uint32_t TextBasedGame::NPCRoom(uint32_t npcId, uint32_t turn) {
+    return (npcSchedules[npcId].count == 0) ? npcRooms[npcId] : GetScheduledRoom(npcId, turn);
+}
+
+bool TextBasedGame::IsVisiting(NPCVisit const& visit, uint32_t turn) {
+    auto &schedule = npcSchedules[visit.npc];
+    if (schedule.count == 0) {
+        return true;
+    }
+    uint32_t t = static_cast<uint32_t>((static_cast<uint64_t>(turn) + schedule.offset) % schedule.period);
+    return t >= visit.start && t < visit.end;
+}
+
+uint64_t TextBasedGame::GetNextVisitChange(NPCVisit const& visit, uint32_t turn) {
+    auto &schedule = npcSchedules[visit.npc];
+    if (schedule.count <= 1 || (visit.start == 0 && visit.end == schedule.period)) {
+        return 0;
+    }
+    uint32_t t = static_cast<uint32_t>((static_cast<uint64_t>(turn) + schedule.offset) % schedule.period);
+    /* there until end, or away until start comes round again */
+    uint32_t wait = (t >= visit.start && t < visit.end) ? visit.end - t : (visit.start + schedule.period - t) % schedule.period;
+    return static_cast<uint64_t>(turn) + wait;
+}
+
+void TextBasedGame::WatchNPCs() {
+    auto &s = *Current();
+    s.npcWheel.Reset(s.turn);
+    s.npcWheelRoom = s.currentRoom;
+    auto &visits = roomVisits[s.currentRoom];
+    for (uint32_t i = 0; i < visits.size(); i++) {
+        if (uint64_t due = GetNextVisitChange(visits[i], s.turn)) {
+            s.npcWheel.Schedule(due, i);
+        }
+    }
+}
+
+void TextBasedGame::SetTurn(uint32_t turn) {
+    uint32_t from = Current()->turn;
+    if (turn == from) {
+        return;
+    }
+    Current()->turn = turn;
+    Record(Delta { Delta::Kind::Turn, 0, 0, from, turn });
+}
+
+size_t TextBasedGame::Tick(std::string &text) {
+    if (scheduledNPCs.empty()) {
+        return 0;
+    }
+    auto &s = *Current();
+    /* the player went somewhere else, or the turn jumped (undo, load, wrapping round) since the wheel last moved */
+    if (s.npcWheelRoom != s.currentRoom || s.npcWheel.GetTime() != s.turn) {
+        WatchNPCs();
+    }
+    uint32_t from = s.turn, turn = from + 1;
+    SetTurn(turn);
+
+    /* NPCs anywhere else have moved just by the turn changing - nothing to do for them */
+    s.npcsDue.clear();
+    s.npcWheel.Advance(s.npcsDue);
+    /* in the order they were put in the room, like NPCsHereRepr */
+    std::sort(s.npcsDue.begin(), s.npcsDue.end());
+    auto &visits = roomVisits[s.currentRoom];
+    for (uint32_t i : s.npcsDue) {
+        auto &visit = visits[i];
+        s.npcWheel.Schedule(GetNextVisitChange(visit, turn), i);
+        bool is = IsVisiting(visit, turn);
+        /* going from one visit here straight on to another (round the end of its schedule) isn't coming or going */
+        if (NPCRoom(visit.npc, is ? from : turn) == s.currentRoom) {
+            continue;
+        }
+        if (!text.empty()) {
+            text += '\n';
+        }
+        fmt::format_to(std::back_inserter(text), "The {} {}.", npcs.Get(visit.npc).GetRepr(), is ? "comes in" : "leaves");
+    }
+    return s.npcsDue.size();
+}
+
+void TextBasedGame::SetItemFound(uint32_t itemId, bool found) {
+    if (Current()->itemFound.Get(itemId) == found) {
+        return;
+    }
+    Current()->itemFound.Set(itemId, found);
+    Record(Delta { Delta::Kind::ItemFound, itemId, 0, !found, found });
+}
+
+void TextBasedGame::Record(Delta const& delta) {
+    if (Current()->state == GameState::Loading) {
+        return;
+    }
+    if (Current()->journal) {
+        Current()->journal->Append(delta, (delta.kind == Delta::Kind::Exit) ? std::string_view(Current()->roomGraph->GetLabelName(delta.label)) : std::string_view());
+    }
+    /* items stay found and time keeps going - undo takes back what the player did, not what they've seen */
+    if (!Current()->undoing && delta.kind != Delta::Kind::ItemFound && delta.kind != Delta::Kind::Turn) {
+        Current()->undoLog.Add(delta);
+    }
+}
+
+void TextBasedGame::ApplyDelta(Delta const& delta, bool backwards) {
+    uint32_t value = backwards ? delta.before : delta.after;
+    switch (delta.kind) {
+        case Delta::Kind::CurrentRoom: MoveTo(value); break;
+        case Delta::Kind::ItemLocation: MoveItem(delta.subject, value); break;
+        case Delta::Kind::Exit: SetExit(delta.subject, delta.label, value); break;
+        case Delta::Kind::ItemFound: SetItemFound(delta.subject, value != 0); break;
+        case Delta::Kind::Turn: SetTurn(value); break;
+    }
+}
+
+void TextBasedGame::RebuildItemLocations() {
+    std::vector<uint32_t> locations(items.Size(), Delta::Nowhere);
+    for (auto itemId : Current()->player.GetInventory()) {
+        locations[itemId] = Delta::Inventory;
+    }
+    for (uint32_t r = 0; r < Current()->roomItems.Size(); r++) {
+        for (auto itemId : Current()->roomItems.Get(r)) {
+            locations[itemId] = r;
+        }
+    }
+    for (uint32_t itemId = 0; itemId < locations.size(); itemId++) {
+        Current()->itemLocations.Set(itemId, locations[itemId]);
+    }
 }
 
 /* IO */
 
 std::string TextBasedGame::Read() {
-    return graphics->GetTextIn();
+    return frontend->GetTextIn();
 }
 
 /* Eval(Read()) gets called when user hits enter */
 void TextBasedGame::Eval(std::string input) {
+    Profiler::Scope scope(Profiling(), Profiler::Phase::Eval);
+    TRACE_SPAN("TextBasedGame::Eval");
+    /* whatever it does can change which commands there are, so the hint is looked for again (network sessions don't have one) */
+    if (Current() == &mainSession) {
+        hintValid = false;
+    }
+    Current()->output.clear();
+    if (Current()->transcript) {
+        Current()->transcript->Input(frameCount, GetRunTime(), input);
+    }
+
     Clear();
-    for (auto &cmd : GetCommands()) {
-        if (cmd.TryEval(input)) {
-            break;
+    if (Current()->flow.GetWait() == Flow::Wait::Input) {
+        /* an interaction is waiting for this line - it's not a command */
+        Current()->flow.Resume(input);
+    } else {
+        for (auto &cmd : GetCommands()) {
+            if (cmd.TryEval(input)) {
+                break;
+            }
+        }
+    }
+
+    /* the turn's over (unless an interaction is still waiting for an answer) - NPCs move on, then OnTick rules have their say, after whatever the command printed */
+    if (Current()->state == GameState::Playing && Current()->flow.GetWait() != Flow::Wait::Input && (!scheduledNPCs.empty() || events.Has(EventBus::Event::OnTick, Current()->currentRoom))) {
+        std::string text = fmt::format("{}", fmt::join(Current()->output, "\n"));
+        size_t printed = text.size();
+        Tick(text);
+        events.Emit(EventBus::Event::OnTick, Current()->currentRoom, text);
+        if (text.size() != printed) {
+            Current()->output.clear();
+            Write(text);
+        }
+    }
+
+    if (Current()->frontend) {
+        Current()->frontend->SetTextIn("");
+    }
+
+    if (Current()->transcript) {
+        Current()->transcript->Output(Current()->output);
+    }
+
+    /* everything the command changed is one undo step and one journal entry */
+    Current()->undoLog.Commit();
+    if (Current()->journal) {
+        Current()->journal->Commit();
+        if (Current()->journal->GetFileSize() > JournalCompactSize) {
+            CompactAutosave();
         }
     }
+}
+
+void TextBasedGame::Eval(Session& s, std::string input) {
+    SessionScope scope(this, s);
+    Eval(input);
+}
+
+TextBasedGame::Session *TextBasedGame::Current() {
+    return (evaluating.game == this) ? evaluating.session : &mainSession;
+}
+
+std::unique_ptr<TextBasedGame::Session> TextBasedGame::CreateSession() {
+    auto s = std::make_unique<Session>();
+    s->CopyStateFrom(worldTemplate);
+    return s;
+}
+
+void TextBasedGame::Hibernate(Session& s, ByteWriter& out) {
+    SessionScope scope(this, s);
+    Snapshot::WriteSession(*this, out);
+}
 
-    graphics->SetTextIn("");
+std::unique_ptr<TextBasedGame::Session> TextBasedGame::Rehydrate(ByteReader& in) {
+    auto s = CreateSession();
+    SessionScope scope(this, *s);
+    Snapshot::ReadSession(*this, in);
+    return s;
 }
 
 void TextBasedGame::Clear() {
@@ -311,59 +1142,79 @@ void TextBasedGame::Clear() {
 }
 
 void TextBasedGame::Write(std::string str) {
+    TRACE_SPAN("TextBasedGame::Write");
     /* split text into lines */
     static auto lineRegex = std::regex("(.{1,65})(?:(\\s)+|$|\n)");
     std::vector<std::string> res;
 
     int lc = 0;
     for (auto i = std::sregex_iterator(str.begin(), str.end(), lineRegex); i != std::sregex_iterator(); i++) {
-        if (lc == Graphics::LineOutCount) {
+        if (lc == Frontend::LineOutCount) {
             break;
         }
         res.push_back((*i).str());
         lc++;
     }
 
+    /* remember what was printed, without the padding and line breaks */
+    size_t shown = res.size();
+    while (shown > 0 && res[shown - 1].find_first_not_of(" \t\n") == std::string::npos) {
+        shown--;
+    }
+    for (size_t i = 0; i < shown; i++) {
+        Current()->output.push_back(res[i].substr(0, res[i].find_last_not_of(" \t\n") + 1));
+    }
+
     /* pad it with empty lines */
-    while (res.size() < Graphics::LineOutCount) {
+    while (res.size() < Frontend::LineOutCount) {
         res.push_back("");
     }
 
     /* write all the lines */
-    for (int i = 0; i < Graphics::LineOutCount; i++) {
-        graphics->SetTextOut(res.at(i), i);
+    if (Current()->frontend) {
+        for (int i = 0; i < Frontend::LineOutCount; i++) {
+            Current()->frontend->SetTextOut(res.at(i), i);
+        }
     }
 }
 
 void TextBasedGame::Write(std::vector<std::string> strs) {
-    std::queue<std::string> q;
-    for (auto &str : strs) {
-        q.push(str);
-    }
-    graphics->SetTextIn("");
-    while (!WindowShouldClose()) {
-        if (GetKeyPressed() != KEY_NULL) {
-            if (!graphics->IsQueueEmpty()) {
-                graphics->DumpText();
-            } else {
-                if (q.empty()) {
-                    return;
-                }
-                /* advance */
-                std::string s = q.front();
-                q.pop();
-                Write(s);
-            }
+    /* a flow that's running can't be paused from here, it has to co_await Pager() itself */
+    if (Current()->flow.IsWaiting() && Current()->flow.GetWait() != Flow::Wait::Key) {
+        for (auto &str : strs) {
+            Write(str);
         }
-        graphics->Draw();
+        return;
     }
+    StartFlow(Pager(std::move(strs)));
+}
+
+void TextBasedGame::Write(std::shared_ptr<Script const> script, std::span<uint32_t const> pages) {
+    if (Current()->flow.IsWaiting() && Current()->flow.GetWait() != Flow::Wait::Key) {
+        for (uint32_t page : pages) {
+            Write(script->GetText(page));
+        }
+        return;
+    }
+    std::array<uint32_t, Script::MaxPages> held;
+    size_t pageCount = std::min(pages.size(), held.size());
+    std::copy_n(pages.begin(), pageCount, held.begin());
+    StartFlow(Pager(std::move(script), held, pageCount));
 }
 
 void TextBasedGame::UpdateHint() {
-    std::string input = Read();
+    Profiler::Scope scope(Profiling(), Profiler::Phase::UpdateHint);
+    TRACE_SPAN("TextBasedGame::UpdateHint");
+    /* same as last frame - nothing to do (and nothing to allocate) */
+    if (hintValid && frontend->IsTextIn(hintInput)) {
+        return;
+    }
+    hintInput = Read();
+    hintValid = true;
+    std::string const& input = hintInput;
     auto len = input.length();
     if (len == 0) {
-        graphics->SetHint("");
+        frontend->SetHint("");
         return;
     }
 
@@ -372,26 +1223,29 @@ void TextBasedGame::UpdateHint() {
             // return the first match found
             if (hint.substr(0, len) == input) {
                 // npos = "go to the end of the string"
-                graphics->SetHint(hint.substr(len, std::string::npos));
+                frontend->SetHint(hint.substr(len, std::string::npos));
                 return;
             }
         }
     }
-    graphics->SetHint("");
+    frontend->SetHint("");
 }
 
 /* commands */
 
 std::vector<Command> TextBasedGame::GetCommands() {
-    switch(state) {
-        case GameState::ExitMenu: {
-            return std::vector<Command>{
-                commands.Get("Exit: Yes"),
-                commands.Get("Exit: No"),
-                commands.Get("Exit: Unknown")
-            };
+    Profiler::Scope scope(Profiling(), Profiler::Phase::GetCommands);
+    TRACE_SPAN("TextBasedGame::GetCommands");
+    /* an interaction waiting for an answer - what it accepts, for hints */
+    if (Current()->flow.GetWait() == Flow::Wait::Input) {
+        std::vector<Command> cmds;
+        for (auto &name : Current()->flow.GetMenu()) {
+            cmds.push_back(commands.Get(name));
         }
+        return cmds;
+    }
 
+    switch(Current()->state) {
         case GameState::Loading: {
             return {};
         }
@@ -406,6 +1260,12 @@ std::vector<Command> TextBasedGame::GetCommands() {
             cmds.push_back(commands.Get("Move: South"));
             cmds.push_back(commands.Get("Move: East"));
             cmds.push_back(commands.Get("Move: West"));
+            cmds.push_back(commands.Get("Move: Up"));
+            cmds.push_back(commands.Get("Move: Down"));
+            cmds.push_back(commands.Get("Move: In"));
+            cmds.push_back(commands.Get("Move: Out"));
+            cmds.push_back(commands.Get("Move: Travel"));
+            cmds.push_back(commands.Get("Move: Named Exit"));
             cmds.push_back(commands.Get("Move: Unknown Direction"));
 
             /* inspection/visual */
@@ -416,10 +1276,18 @@ std::vector<Command> TextBasedGame::GetCommands() {
 
             /* take/drop items, special commands */
 
-            for (auto& [name, item] : items) {
-                auto hintText = item.GetAttrs().isFound? "" : " (No Hints)";
-                bool inRoom = IsItemInRoom(name, currentRoom),
-                    inInv = IsItemInInv(name);
+            /* only what's here or carried, in item id order like the full list used to be */
+            std::vector<uint32_t> nearby = Current()->roomItems.Get(Current()->currentRoom);
+            auto &inventory = Current()->player.GetInventory();
+            nearby.insert(nearby.end(), inventory.begin(), inventory.end());
+            std::sort(nearby.begin(), nearby.end());
+
+            for (auto itemId : nearby) {
+                auto &name = items.GetName(itemId);
+                auto &item = items.Get(itemId);
+                auto hintText = Current()->itemFound.Get(itemId) ? "" : " (No Hints)";
+                bool inInv = Current()->itemLocations.Get(itemId) == Delta::Inventory,
+                    inRoom = !inInv;
 
                 if (inRoom && item.GetFlags().canCarry) {
                     cmds.push_back(commands.Get(fmt::format("Take Item: {}{}", name, hintText)));
@@ -430,11 +1298,12 @@ std::vector<Command> TextBasedGame::GetCommands() {
                 if (inRoom) {
                     cmds.push_back(commands.Get(fmt::format("Inspect Item: {}{}", name, hintText)));
                 }
+                if (events.Has(EventBus::Event::OnUse, itemId)) {
+                    cmds.push_back(commands.Get(fmt::format("Use Item: {}{}", name, hintText)));
+                }
 
-                if (inInv || inRoom) {
-                    for (const auto &cmd : item.GetSpecialCommands()) {
-                        cmds.push_back(cmd);
-                    }
+                for (const auto &cmd : item.GetSpecialCommands()) {
+                    cmds.push_back(cmd);
                 }
             }
 
@@ -443,6 +1312,22 @@ std::vector<Command> TextBasedGame::GetCommands() {
             cmds.push_back(commands.Get("Take Item: Unknown"));
             cmds.push_back(commands.Get("Drop Item: Invalid"));
             cmds.push_back(commands.Get("Drop Item: Unknown"));
+            cmds.push_back(commands.Get("Use Item: Invalid"));
+            cmds.push_back(commands.Get("Use Item: Unknown"));
+
+            /* NPCs - only the ones here */
+            for (auto &visit : roomVisits[Current()->currentRoom]) {
+                if (!IsVisiting(visit, Current()->turn)) {
+                    continue;
+                }
+                auto &name = npcs.GetName(visit.npc);
+                cmds.push_back(commands.Get(fmt::format("Talk To: {}", name)));
+                cmds.push_back(commands.Get(fmt::format("Inspect NPC: {}", name)));
+            }
+            cmds.push_back(commands.Get("Talk: Invalid"));
+            cmds.push_back(commands.Get("Talk: Unknown"));
+            cmds.push_back(commands.Get("Give Item"));
+            cmds.push_back(commands.Get("Give Item: Unknown"));
 
             /* settings - text scroll speed */
             cmds.push_back(commands.Get("Set Text Scroll Speed: Slow"));
@@ -456,10 +1341,24 @@ std::vector<Command> TextBasedGame::GetCommands() {
             cmds.push_back(commands.Get("Set Cursor Style: OutlineBox"));
             cmds.push_back(commands.Get("Set Cursor Style: TransparentBox"));
             cmds.push_back(commands.Get("Set Cursor Style: Invalid"));
+
+            /* settings - undo depth */
+            cmds.push_back(commands.Get("Set Undo Depth"));
+            cmds.push_back(commands.Get("Set Undo Depth: Invalid"));
+
+            /* settings - profiler */
+            cmds.push_back(commands.Get("Set Profiler"));
+            cmds.push_back(commands.Get("Set Profiler: Invalid"));
+            cmds.push_back(commands.Get("Save Trace"));
             
             /* misc. system */
             cmds.push_back(commands.Get("General Help"));
             cmds.push_back(commands.Get("List Settings"));
+            cmds.push_back(commands.Get("Save Game"));
+            cmds.push_back(commands.Get("Load Game"));
+            cmds.push_back(commands.Get("Restart Game"));
+            cmds.push_back(commands.Get("Undo"));
+            cmds.push_back(commands.Get("Redo"));
             cmds.push_back(commands.Get("Exit Game"));
 
             /* failsafes */
@@ -475,29 +1374,71 @@ std::vector<Command> TextBasedGame::GetCommands() {
 /* player interaction */
 
 void TextBasedGame::TryMove(Direction d) {
-    std::string targetRoomName = rooms.Get(currentRoom).GetPath(d);
-    
+    TryMove(DirectionRepr(d, false));
+}
+
+void TextBasedGame::TryMove(std::string exitName) {
+    /* exit names are always stored lowercase */
+    std::transform(exitName.begin(), exitName.end(), exitName.begin(), [](unsigned char c) { return std::tolower(c); });
+    uint32_t label = Current()->roomGraph->FindLabel(exitName);
+    uint32_t target = (label == RoomGraph::None) ? RoomGraph::None : Current()->roomGraph->GetExit(Current()->currentRoom, label);
+
+    /* if nothing anywhere is called that */
+    if (label == RoomGraph::None) {
+        Write(Messages::InvalidDir);
+    }
     /* if player cannot go that way */
-    if (targetRoomName == "") {
+    else if (target == RoomGraph::None) {
         Write(Messages::BlockedDir);
     }
     /* if they can */
     else {
-        currentRoom = targetRoomName;
-        graphics->SetBackgroundImage(currentRoom);
-        Write(fmt::format("You went {}.\n{}", DirectionRepr(d, false), rooms.Get(currentRoom).GetMessage(Room::Message::OnEnter)));
+        MoveTo(target);
+        /* "You went north." but "You went through the trapdoor." */
+        auto how = (label < DirectionCount) ? exitName : "through the " + exitName;
+        std::string text = fmt::format("You went {}.\n{}", how, rooms.Get(Current()->currentRoom).GetMessage(Room::Message::OnEnter));
+        events.Emit(EventBus::Event::OnEnter, target, text);
+        Write(text);
+    }
+}
+
+void TextBasedGame::TryTravel(std::string roomRepr) {
+    std::transform(roomRepr.begin(), roomRepr.end(), roomRepr.begin(), [](unsigned char c) { return std::tolower(c); });
+    auto it = roomIdsByRepr.find(roomRepr);
+    if (it == roomIdsByRepr.end()) {
+        Write(Messages::UnknownRoom);
+        return;
     }
+
+    uint32_t from = Current()->currentRoom, to = it->second;
+    if (from == to) {
+        Write(Messages::AlreadyThere);
+        return;
+    }
+
+    auto path = Current()->pathFinder.FindPath(*Current()->roomGraph, from, to);
+    if (path.empty()) {
+        Write(Messages::NoRoute);
+        return;
+    }
+
+    MoveTo(path.back());
+    std::string text = fmt::format("You made your way to the {}.\n{}", rooms.Get(Current()->currentRoom).GetRepr(), rooms.Get(Current()->currentRoom).GetMessage(Room::Message::OnEnter));
+    events.Emit(EventBus::Event::OnEnter, to, text);
+    Write(text);
 }
 
 void TextBasedGame::TryTakeItem(std::string itemName) {
-    bool inInv = IsItemInInv(itemName);
-    bool inRoom = IsItemInRoom(itemName, currentRoom);
+    uint32_t itemId = items.GetId(itemName);
+    bool inInv = Current()->itemLocations.Get(itemId) == Delta::Inventory;
+    bool inRoom = Current()->itemLocations.Get(itemId) == Current()->currentRoom;
     Item::Flags flags = items.Get(itemName).GetFlags();
     if (!inInv && inRoom && flags.canCarry) {
-        player.AddItemToInv(itemName);
-        rooms.Get(currentRoom).RemoveItem(itemName);
-        items.Get(itemName).GetAttrs().isFound = true;
-        Write(fmt::format("You took the {}.", items.Get(itemName).GetRepr()));
+        MoveItem(itemId, Delta::Inventory);
+        SetItemFound(itemId, true);
+        std::string text = fmt::format("You took the {}.", items.Get(itemName).GetRepr());
+        events.Emit(EventBus::Event::OnTake, itemId, text);
+        Write(text);
     } else if (inInv) {
         Write(Messages::InvalidTakeHolding);
     } else if (!inRoom) {
@@ -510,12 +1451,14 @@ void TextBasedGame::TryTakeItem(std::string itemName) {
 }
 
 void TextBasedGame::TryDropItem(std::string itemName) {
-    bool inInv = IsItemInInv(itemName);
-    bool inRoom = IsItemInRoom(itemName, currentRoom);
+    uint32_t itemId = items.GetId(itemName);
+    bool inInv = Current()->itemLocations.Get(itemId) == Delta::Inventory;
+    bool inRoom = Current()->itemLocations.Get(itemId) == Current()->currentRoom;
     if (inInv && !inRoom) {
-        player.RemoveItemFromInv(itemName);
-        rooms.Get(currentRoom).AddItem(itemName);
-        Write(fmt::format("You dropped the {}.", items.Get(itemName).GetRepr()));
+        MoveItem(itemId, Current()->currentRoom);
+        std::string text = fmt::format("You dropped the {}.", items.Get(itemName).GetRepr());
+        events.Emit(EventBus::Event::OnDrop, itemId, text);
+        Write(text);
     } else if (!inInv) {
         Write(Messages::InvalidDrop);
     } else if (inRoom) {
@@ -527,8 +1470,9 @@ void TextBasedGame::TryDropItem(std::string itemName) {
 
 
 void TextBasedGame::TryInspectItem(std::string itemName) {
-    bool inInv = IsItemInInv(itemName);
-    bool inRoom = IsItemInRoom(itemName, currentRoom);
+    uint32_t itemId = items.GetId(itemName);
+    bool inInv = Current()->itemLocations.Get(itemId) == Delta::Inventory;
+    bool inRoom = Current()->itemLocations.Get(itemId) == Current()->currentRoom;
 
     if (inInv || inRoom) {
         Write(items.Get(itemName).GetMessage(Item::Message::OnInspect));
@@ -538,18 +1482,283 @@ void TextBasedGame::TryInspectItem(std::string itemName) {
 }
 
 
+void TextBasedGame::TryUseItem(std::string itemName) {
+    uint32_t itemId = items.GetId(itemName);
+    uint32_t location = Current()->itemLocations.Get(itemId);
+
+    if (location == Delta::Inventory || location == Current()->currentRoom) {
+        std::string text;
+        events.Emit(EventBus::Event::OnUse, itemId, text);
+        /* a rule that printed by itself (pages, like unlocking) leaves text empty */
+        if (!text.empty()) {
+            Write(text);
+        }
+    } else {
+        Write(Messages::InvalidUse);
+    }
+}
+
+
+void TextBasedGame::TryTalk(std::string npcName) {
+    uint32_t npcId = npcs.GetId(npcName);
+    if (NPCRoom(npcId, Current()->turn) != Current()->currentRoom) {
+        Write(Messages::InvalidTalk);
+        return;
+    }
+    if (npcDialogue[npcId] == Dialogue::End) {
+        Write(Messages::NothingToSay);
+        return;
+    }
+    StartFlow(Talk(npcId));
+}
+
+Flow TextBasedGame::Talk(uint32_t npcId) {
+    uint32_t nodeId = npcDialogue[npcId];
+    while (true) {
+        co_await ShowDialogueNode(nodeId);
+        auto &node = dialogue.GetNode(nodeId);
+        /* nothing to reply - the NPC has the last word */
+        if (node.edgeCount == 0) {
+            co_return;
+        }
+
+        uint32_t reply = 0;
+        while (reply == 0) {
+            std::string answer = co_await Flow::NextInput(TalkCommands);
+            if (commands.Get("Talk: Bye").IsMatch(answer)) {
+                StopTalking();
+                co_return;
+            }
+            /* anything that isn't 1..edgeCount, however many digits it has */
+            if (commands.Get("Talk: Reply").IsMatch(answer)) {
+                std::string n = answer.substr(0, answer.find('.'));
+                if (n.size() <= 9 && std::stoul(n) >= 1 && std::stoul(n) <= node.edgeCount) {
+                    reply = static_cast<uint32_t>(std::stoul(n));
+                }
+            }
+            if (reply == 0) {
+                Write(Messages::InvalidReply);
+            }
+        }
+
+        auto &edge = dialogue.GetEdge(node, reply - 1);
+        if (edge.target == Dialogue::End) {
+            StopTalking();
+            co_return;
+        }
+        nodeId = edge.target;
+    }
+}
+
+void TextBasedGame::StopTalking() {
+    Write(fmt::format("{}\nYou are in the {}.", Messages::StoppedTalking, rooms.Get(Current()->currentRoom).GetRepr()));
+}
+
+Flow TextBasedGame::ShowDialogueNode(uint32_t nodeId) {
+    auto &node = dialogue.GetNode(nodeId);
+    auto &said = dialogue.GetText(node.text);
+    if (node.edgeCount == 0) {
+        Write(said);
+        co_return;
+    }
+
+    std::string replies;
+    for (uint32_t i = 0; i < node.edgeCount; i++) {
+        replies += fmt::format("{}{}. {}", (i == 0) ? "" : "\n", i + 1, dialogue.GetText(dialogue.GetEdge(node, i).text));
+    }
+    /* what's said and the replies on one screen if they fit, otherwise a page each */
+    if (node.edgeCount < Frontend::LineOutCount && said.find('\n') == std::string::npos && said.size() <= 65) {
+        Write(said + "\n" + replies);
+    } else {
+        /* (no braced list here, GCC 12 can't build one inside a coroutine) */
+        std::vector<std::string> pages;
+        pages.push_back(said + "\n...");
+        pages.push_back(replies);
+        co_await Pager(std::move(pages));
+    }
+}
+
+void TextBasedGame::TryGiveItem(std::string itemRepr, std::string npcRepr) {
+    std::transform(itemRepr.begin(), itemRepr.end(), itemRepr.begin(), [](unsigned char c) { return std::tolower(c); });
+    std::transform(npcRepr.begin(), npcRepr.end(), npcRepr.begin(), [](unsigned char c) { return std::tolower(c); });
+
+    auto npc = npcIdsByRepr.find(npcRepr);
+    if (npc == npcIdsByRepr.end() || NPCRoom(npc->second, Current()->turn) != Current()->currentRoom) {
+        Write(Messages::InvalidGiveTo);
+        return;
+    }
+    auto item = itemIdsByRepr.find(itemRepr);
+    if (item == itemIdsByRepr.end() || Current()->itemLocations.Get(item->second) != Delta::Inventory) {
+        Write(Messages::InvalidGive);
+        return;
+    }
+
+    auto trade = trades.find((static_cast<uint64_t>(npc->second) << 32) | item->second);
+    if (trade == trades.end()) {
+        auto &refusing = npcs.Get(npc->second);
+        Write(refusing.HasMessage(NPC::Message::OnRefuse) ? refusing.GetMessage(NPC::Message::OnRefuse) : Messages::TradeRefused);
+        return;
+    }
+
+    MoveItem(item->second, Delta::Nowhere);
+    if (trade->second.gives != Delta::Nowhere) {
+        MoveItem(trade->second.gives, Delta::Inventory);
+        SetItemFound(trade->second.gives, true);
+    }
+    Write(dialogue.GetText(trade->second.message));
+}
+
+bool TextBasedGame::EnableAutosave() {
+    bool restored = false;
+    bool journalLost = false;
+    try {
+        restored = Snapshot::LoadFile(*this, AutosaveFileName);
+        if (restored) {
+            bool complete;
+            bool replayed = Journal::Replay(JournalFileName, Snapshot::Fingerprint(*this), rooms.Size(), items.Size(), [&](Delta const& delta, std::string const& exitName) {
+                Delta d = delta;
+                if (d.kind == Delta::Kind::Exit) {
+                    d.label = MutableRoomGraph().Intern(exitName);
+                }
+                ApplyDelta(d);
+            }, complete);
+            /* stopped at a half written or damaged command - the ones before it are in, it and anything after aren't */
+            journalLost = replayed && !complete;
+        }
+    } catch (FormatError &e) {
+        /* autosave from a different world, or damaged - start over */
+    }
+
+    Current()->undoLog.Clear();
+    Current()->journal = std::make_unique<Journal>(JournalFileName);
+    CompactAutosave();
+
+    if (restored) {
+        Write(fmt::format("{}\nYou are in the {}.", journalLost ? Messages::AutosaveJournalLost : Messages::AutosaveRestored, rooms.Get(Current()->currentRoom).GetRepr()));
+    }
+    return restored;
+}
+
+void TextBasedGame::CompactAutosave() {
+    if (!Current()->journal) {
+        return;
+    }
+    /* write the new snapshot next to the old one, then swap, so there's always a complete one on disk */
+    Current()->journal->Flush();
+    std::string tmp = AutosaveFileName + ".tmp";
+    if (Snapshot::SaveFile(*this, tmp) && std::rename(tmp.c_str(), AutosaveFileName.c_str()) == 0) {
+        Current()->journal->Reset(Snapshot::Fingerprint(*this));
+    }
+}
+
+void TextBasedGame::SaveWorldTemplate() {
+    /* compacted/flattened once here, so sessions sharing it only ever read it */
+    Current()->roomGraph->Compact();
+    Current()->roomItems.Flatten();
+    Current()->itemFound.Flatten();
+    Current()->itemLocations.Flatten();
+    worldTemplate.CopyStateFrom(*Current());
+}
+
+void TextBasedGame::StartRecording(std::string path, std::string world) {
+    Current()->transcript = std::make_unique<Transcript>(path, world, Transcript::StateDigest(*this));
+}
+
+void TextBasedGame::StopRecording() {
+    if (!Current()->transcript) {
+        return;
+    }
+    Current()->transcript->End(Transcript::StateDigest(*this));
+    Current()->transcript.reset();
+}
+
+void TextBasedGame::TryRestart() {
+    Current()->CopyStateFrom(worldTemplate);
+    Current()->undoLog.Clear();
+    CompactAutosave();
+    if (Current()->frontend) {
+        Current()->frontend->SetBackgroundImage(rooms.GetName(Current()->currentRoom));
+    }
+    Write(fmt::format("{}\nYou are in the {}.", Messages::GameRestarted, rooms.Get(Current()->currentRoom).GetRepr()));
+}
+
+void TextBasedGame::TrySave() {
+    if (Current() != &mainSession) {
+        Write(Messages::NoSaveOnline);
+        return;
+    }
+    Write(Snapshot::SaveFile(*this, SaveFileName) ? Messages::GameSaved : Messages::SaveFailed);
+}
+
+void TextBasedGame::TryLoad() {
+    if (Current() != &mainSession) {
+        Write(Messages::NoSaveOnline);
+        return;
+    }
+    try {
+        if (!Snapshot::LoadFile(*this, SaveFileName)) {
+            Write(Messages::NoSavedGame);
+            return;
+        }
+    } catch (FormatError &e) {
+        Write(Messages::BadSavedGame);
+        return;
+    }
+    Current()->undoLog.Clear();
+    CompactAutosave();
+    if (Current()->frontend) {
+        Current()->frontend->SetBackgroundImage(rooms.GetName(Current()->currentRoom));
+    }
+    Write(fmt::format("{}\nYou are in the {}.", Messages::GameLoaded, rooms.Get(Current()->currentRoom).GetRepr()));
+}
+
+void TextBasedGame::TryUndo() {
+    if (!Current()->undoLog.CanUndo()) {
+        Write(Messages::NothingToUndo);
+        return;
+    }
+    auto step = Current()->undoLog.Undo();
+    Current()->undoing = true;
+    for (auto it = step.rbegin(); it != step.rend(); it++) {
+        ApplyDelta(*it, true);
+    }
+    Current()->undoing = false;
+    Write(fmt::format("{}\nYou are in the {}.", Messages::Undone, rooms.Get(Current()->currentRoom).GetRepr()));
+}
+
+void TextBasedGame::TryRedo() {
+    if (!Current()->undoLog.CanRedo()) {
+        Write(Messages::NothingToRedo);
+        return;
+    }
+    auto step = Current()->undoLog.Redo();
+    Current()->undoing = true;
+    for (auto &delta : step) {
+        ApplyDelta(delta);
+    }
+    Current()->undoing = false;
+    Write(fmt::format("{}\nYou are in the {}.", Messages::Redone, rooms.Get(Current()->currentRoom).GetRepr()));
+}
+
+void TextBasedGame::TrySetUndoDepth(std::string depth) {
+    if (depth.empty() || depth.size() > 6 || !std::all_of(depth.begin(), depth.end(), [](unsigned char c) { return std::isdigit(c); })) {
+        Write(Messages::InvalidUndoDepth);
+        return;
+    }
+    Current()->undoLog.SetDepth(std::stoul(depth));
+    Write(Messages::UndoDepthSet);
+}
+
 bool TextBasedGame::IsItemInRoom(std::string itemName, std::string roomName) {
-    auto items = rooms.Get(roomName).GetItems();
-    return std::find(items.begin(), items.end(), itemName) != items.end();
+    return Current()->itemLocations.Get(items.GetId(itemName)) == rooms.GetId(roomName);
 }
 
 bool TextBasedGame::IsItemInInv(std::string itemName) {
-    auto inv = player.GetInventory();
-    return std::find(inv.begin(), inv.end(), itemName) != inv.end();
+    return Current()->itemLocations.Get(items.GetId(itemName)) == Delta::Inventory;
 }
 
-std::string TextBasedGame::FullItemRepr(std::string itemName) {
-    std::string repr = items.Get(itemName).GetRepr();
+std::string TextBasedGame::FullItemRepr(uint32_t itemId) {
+    std::string repr = items.Get(itemId).GetRepr();
     for (char c : "aeiou") {
         if (repr[0] == c || repr[0] == c - 32) {
             return fmt::format("an {}", repr);
@@ -559,15 +1768,16 @@ std::string TextBasedGame::FullItemRepr(std::string itemName) {
 }
 
 std::string TextBasedGame::InventoryRepr() {
-    auto inv = player.GetInventory();
+    auto &inv = Current()->player.GetInventory();
     switch(inv.size()) {
         case 0: return "Your inventory is empty.";
         case 1: return fmt::format("Your inventory contains {}.", FullItemRepr(inv[0]));
         case 2: return fmt::format("Your inventory contains {} and {}.", FullItemRepr(inv[0]), FullItemRepr(inv[1]));
         case 3: return fmt::format("Your inventory contains {}, {} and {}.", FullItemRepr(inv[0]), FullItemRepr(inv[1]), FullItemRepr(inv[2]));
         default: {
-            std::stringstream ss("Your inventory contains ");
-            for (uint8_t i = 0; i < inv.size() - 2; i++) {
+            std::stringstream ss;
+            ss << "Your inventory contains ";
+            for (size_t i = 0; i < inv.size() - 2; i++) {
                 ss << (FullItemRepr(inv[i]) + ", ");
             }
             ss << FullItemRepr(inv[inv.size() - 2]);
@@ -577,16 +1787,34 @@ std::string TextBasedGame::InventoryRepr() {
     }
 }
 
+std::string TextBasedGame::NPCsHereRepr() {
+    std::vector<uint32_t> here;
+    for (auto &visit : roomVisits[Current()->currentRoom]) {
+        if (IsVisiting(visit, Current()->turn)) {
+            here.push_back(visit.npc);
+        }
+    }
+    if (here.empty()) {
+        return "";
+    }
+    std::string text = fmt::format("The {}", npcs.Get(here[0]).GetRepr());
+    for (size_t i = 1; i < here.size(); i++) {
+        text += fmt::format("{}the {}", (i == here.size() - 1) ? " and " : ", ", npcs.Get(here[i]).GetRepr());
+    }
+    return text + ((here.size() == 1) ? " is here." : " are here.");
+}
+
 std::string TextBasedGame::CurrentRoomRepr() {
-    auto roomItems = rooms.Get(currentRoom).GetItems();
+    auto &roomItems = Current()->roomItems.Get(Current()->currentRoom);
     switch(roomItems.size()) {
         case 0: return "There's nothing useful in here.";
         case 1: return fmt::format("You see {}.", FullItemRepr(roomItems[0]));
         case 2: return fmt::format("You see {} and {}.", FullItemRepr(roomItems[0]), FullItemRepr(roomItems[1]));
         case 3: return fmt::format("You see {}, {} and {}.", FullItemRepr(roomItems[0]), FullItemRepr(roomItems[1]), FullItemRepr(roomItems[2]));
         default: {
-            std::stringstream ss("You see ");
-            for (uint8_t i = 0; i < roomItems.size() - 2; i++) {
+            std::stringstream ss;
+            ss << "You see ";
+            for (size_t i = 0; i < roomItems.size() - 2; i++) {
                 ss << (FullItemRepr(roomItems[i]) + ", ");
             }
             ss << FullItemRepr(roomItems[roomItems.size() - 2]);
@@ -597,20 +1825,46 @@ std::string TextBasedGame::CurrentRoomRepr() {
 }
 
 
+/* ------- SESSION ------- */
+
+TextBasedGame::Session::Session() {
+    state = GameState::Loading;
+    currentRoom = 0;
+    undoing = false;
+    frontend = nullptr;
+    turn = 0;
+    npcWheelRoom = Delta::Nowhere;
+}
+
+void TextBasedGame::Session::CopyStateFrom(Session const& other) {
+    state = other.state;
+    currentRoom = other.currentRoom;
+    player = other.player;
+    roomItems = other.roomItems;
+    itemFound = other.itemFound;
+    itemLocations = other.itemLocations;
+    turn = other.turn;
+    roomGraph = other.roomGraph;
+    dynamicLinks = other.dynamicLinks;
+    pathFinder.Invalidate();
+    npcWheelRoom = Delta::Nowhere;
+}
+
+
 /* ------- PLAYER ------- */
 
 TextBasedGame::Player::Player() {
-    inventory = std::vector<std::string>();
+    inventory = std::vector<uint32_t>();
 }
 
-std::vector<std::string>& TextBasedGame::Player::GetInventory() {
+std::vector<uint32_t>& TextBasedGame::Player::GetInventory() {
     return inventory;
 }
 
-void TextBasedGame::Player::AddItemToInv(std::string itemName) {
-    inventory.push_back(itemName);
+void TextBasedGame::Player::AddItemToInv(uint32_t itemId) {
+    inventory.push_back(itemId);
 }
 
-void TextBasedGame::Player::RemoveItemFromInv(std::string itemName) {
-    inventory.erase(std::find(inventory.begin(), inventory.end(), itemName));
+void TextBasedGame::Player::RemoveItemFromInv(uint32_t itemId) {
+    inventory.erase(std::find(inventory.begin(), inventory.end(), itemId));
 }
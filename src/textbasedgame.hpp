@@ -2,8 +2,15 @@
 #define __TEXTBASEDGAME__
 
 #include <algorithm>
+#include <array>
+#include <cctype>
+#include <chrono>
+#include <cstdio>
 #include <iostream>
+#include <iterator>
+#include <memory>
 #include <queue>
+#include <span>
 #include <sstream>
 #include <string>
 #include <unordered_map>
@@ -14,23 +21,40 @@
 
 #include "collection.hpp"
 #include "command.hpp"
+#include "cowvector.hpp"
+#include "delta.hpp"
+#include "dialogue.hpp"
+#include "eventbus.hpp"
+#include "flow.hpp"
 #include "item.hpp"
+#include "journal.hpp"
+#include "npc.hpp"
+#include "pathfinder.hpp"
+#include "profiler.hpp"
 #include "room.hpp"
-#include "graphics.hpp"
+#include "roomgraph.hpp"
+#include "script.hpp"
+#include "frontend.hpp"
+#include "snapshot.hpp"
 #include "timer.hpp"
+#include "timingwheel.hpp"
+#include "trace.hpp"
+#include "transcript.hpp"
+#include "undolog.hpp"
+#include "worldgen.hpp"
 
 /*
 
-    TextBasedGame class - runs the game, has a graphics instance
+    TextBasedGame class - runs the game, has a frontend (the window, a terminal or nothing)
     main.cpp is used to start up this class, catch a couple of exceptions, wrap it up and that's it
     nearly all work is done inside here, including:
     - game loop
     - initializing everything
         - TODO find a file format or something to load from lol (much later)
     - reading user input and evaluating to commands
-    - manipulating inventory, room.items, rooms, [npc dialog options]
+    - manipulating inventory, room.items, rooms, npc dialog options
     - sending messages and prompts to the player
-    - all moving around rooms, taking or dropping items, [talking to npcs]
+    - all moving around rooms, taking or dropping items, talking to npcs
     - drawing everything to the screen
 
     TODO pressing up/down cycles through history (a fun one)
@@ -60,20 +84,15 @@ class TextBasedGame {
             normal state of gameplay, player is in this 99% of the time
             this state doesn't need any init logic in SetState()
         */
-        Playing,
+        Playing
         /*
-            when player said quit/exit - this state forms a loop
-            the only commands are:
-            y/yes -> quits
-            n/no -> return to GameState::Playing
-            anything else -> ignores and repeats prompt
+            the exit menu, talking to an NPC and the pager aren't states - they're flows that
+            wait for what the player types next (see Session::flow and Flow)
         */
-        ExitMenu
     };
 
     /*
         when the user quits the game, this gets thrown to go back to main() and unload everything
-        TODO add StopTalkingToNPCException, maybe (prob later)
     */
     class ExitGameException {};
     
@@ -88,6 +107,16 @@ class TextBasedGame {
         static inline std::string TextSpeedSet = "Text speed updated.";
         /*  When player updates cursor style to any value (even the same)  */
         static inline std::string CursorStyleSet = "Cursor style updated.";
+        /*  "save"  */
+        static inline std::string GameSaved = "Game saved.";
+        /*  "load", followed by where the player is now  */
+        static inline std::string GameLoaded = "Game loaded.";
+        /*  "undo", followed by where the player is now  */
+        static inline std::string Undone = "Undone.";
+        /*  "redo", followed by where the player is now  */
+        static inline std::string Redone = "Redone.";
+        /*  When player updates undo depth to any value (even the same)  */
+        static inline std::string UndoDepthSet = "Undo depth updated.";
 
         /*
             Errors
@@ -106,6 +135,12 @@ class TextBasedGame {
             "move"
         */
         static inline std::string InvalidDir = "Which way?";
+        /*  "go to asdfgh" - no room is called that  */
+        static inline std::string UnknownRoom = "You don't know where that is.";
+        /*  "go to garden" - there is a garden, but every way there is locked or missing  */
+        static inline std::string NoRoute = "You can't find a way there.";
+        /*  "go to kitchen" while standing in the kitchen  */
+        static inline std::string AlreadyThere = "You're already there.";
         /*  When the player tries to inspect an item they aren't holding + not in the current room  */
         static inline std::string InvalidInspect = "You don't see that in here.";
         /*  When the player tries to take an item not in the current room  */
@@ -123,6 +158,30 @@ class TextBasedGame {
         static inline std::string UnknownDrop = "What do you want to drop?";
         /*  "carry 900lb elephant corpse"  */
         static inline std::string CannotCarry = "You don't need that.";
+        /*  When the player tries to use an item that's neither here nor held  */
+        static inline std::string InvalidUse = "You don't see that in here.";
+        /*  "use asdfgh", or an item nothing happens with  */
+        static inline std::string CannotUse = "You can't use that.";
+        /*  "use"  */
+        static inline std::string UnknownUse = "What do you want to use?";
+        /*  "talk to asdfgh", or someone who isn't here  */
+        static inline std::string InvalidTalk = "There's nobody here by that name.";
+        /*  "talk"  */
+        static inline std::string UnknownTalk = "Who do you want to talk to?";
+        /*  "talk to <npc>" for an NPC that was given no conversation  */
+        static inline std::string NothingToSay = "They don't have anything to say.";
+        /*  anything but a reply's number or "bye" while talking  */
+        static inline std::string InvalidReply = "Pick a reply by its number, or say bye.";
+        /*  "bye" while talking, followed by where the player is  */
+        static inline std::string StoppedTalking = "You stop talking.";
+        /*  "give lamp to asdfgh", or someone who isn't here  */
+        static inline std::string InvalidGiveTo = "There's nobody here by that name.";
+        /*  "give asdfgh to <npc>", or an item the player isn't holding  */
+        static inline std::string InvalidGive = "You're not holding that item.";
+        /*  "give" without "<item> to <someone>"  */
+        static inline std::string UnknownGive = "Usage: give <item> to <someone>";
+        /*  giving an NPC something it doesn't trade for, if it has no NPC::Message::OnRefuse of its own  */
+        static inline std::string TradeRefused = "They don't want that.";
         /*
             "set textspeed veryfast"
             "set textspeed"
@@ -133,6 +192,45 @@ class TextBasedGame {
             "set cursor"
         */
         static inline std::string InvalidCursorStyle = "Usage: set cursor <1/2/3/4>";
+        /*
+            "set undo lots"
+            "set undo"
+        */
+        static inline std::string InvalidUndoDepth = "Usage: set undo <number of moves>";
+        /*
+            "set profiler maybe"
+            "set profiler"
+        */
+        static inline std::string InvalidProfiler = "Usage: set profiler <on/off>";
+        static inline std::string ProfilerOn = "Profiler on.";
+        static inline std::string ProfilerOff = "Profiler off.";
+        /*  "set profiler on" from a network player - it's the host's window  */
+        static inline std::string NoProfiler = "The profiler only works in the game's own window.";
+        /*  "save trace"  */
+        static inline std::string TraceSaved = "Trace saved.";
+        static inline std::string TraceFailed = "The trace couldn't be saved.";
+        /*  "save trace" in a game built without TBG_TRACE  */
+        static inline std::string NoTraceBuilt = "This game was built without tracing (make trace).";
+        /*  "save trace" from a network player - it's the host's file  */
+        static inline std::string NoTraceOnline = "Only the host can save a trace.";
+        /*  "undo" with nothing (left) to undo  */
+        static inline std::string NothingToUndo = "There's nothing to undo.";
+        /*  "redo" without undoing anything first  */
+        static inline std::string NothingToRedo = "There's nothing to redo.";
+        /*  "save" but the file couldn't be written  */
+        static inline std::string SaveFailed = "Couldn't save the game.";
+        /*  "load" with no save file  */
+        static inline std::string NoSavedGame = "There's no saved game to load.";
+        /*  "load" with a save file that's damaged or was made in a different world  */
+        static inline std::string BadSavedGame = "That saved game can't be loaded.";
+        /*  "save" or "load" from a network session - there's only one save file, and it's the host's  */
+        static inline std::string NoSaveOnline = "Saving isn't available when playing online.";
+        /*  starting up with an autosave to pick up from, followed by where the player is  */
+        static inline std::string AutosaveRestored = "Welcome back.";
+        /*  ... when the journal after the autosave snapshot stopped at a half written or damaged command, so only the moves before it were restored  */
+        static inline std::string AutosaveJournalLost = "Welcome back. (Your last few moves couldn't be restored.)";
+        /*  "restart", followed by where the player is  */
+        static inline std::string GameRestarted = "Starting over.";
         /*  "asjkdgasdfad"  */
         static inline std::string InvalidCommand = "Command not recognized.";
         /*  "asjkdgasdfad" on the quit menu  */
@@ -149,91 +247,459 @@ class TextBasedGame {
     class Player {
         private:
 
-        /*  list of names of all items in the player's inventory  */
-        std::vector<std::string> inventory;
+        /*  list of ids of all items in the player's inventory  */
+        std::vector<uint32_t> inventory;
 
         public:
         
         Player();
 
-        /*  returns a list of names of all items in the player's inventory  */
-        std::vector<std::string>& GetInventory();
+        /*  returns a list of ids of all items in the player's inventory  */
+        std::vector<uint32_t>& GetInventory();
 
         /*  these methods assume item is or is not in inv already  */
 
-        void AddItemToInv(std::string itemName);
-        void RemoveItemFromInv(std::string itemName);
+        void AddItemToInv(uint32_t itemId);
+        void RemoveItemFromInv(uint32_t itemId);
 
     };
 
-    private:
+    /*
+        one exit set while playing (not during Init), like the red door being unlocked
+        previous = where that exit led before (RoomGraph::None if it didn't exist)
+    */
+    struct DynamicLink {
+        uint32_t from;
+        uint32_t label;
+        uint32_t target;
+        uint32_t previous;
+    };
+
+    /*
+        Everything about one player's game that can change while playing. The world itself
+        (rooms, items, commands) belongs to the TextBasedGame and is shared by every session,
+        so one game can run lots of players at once (see Server) - each command runs against
+        one session, see Eval(Session&, ...)
+
+        The game has a session of its own (the one Init() sets up and Run() plays), every
+        other one starts as a copy of how that one was right after Init() (see CreateSession)
+    */
+    class Session {
+        public:
+
+        Session();
+
+        /*  the current state of the game (see GameState)  */
+        GameState state;
+
+        /*  id of the room the player is currently in  */
+        uint32_t currentRoom;
+
+        /*  the player object  */
+        Player player;
+
+        /*
+            ids of the items in every room, indexed by room id - no duplicates
+            this and the next two are shared with the world, each session only keeps what it changed (see CowVector)
+        */
+        CowVector<std::vector<uint32_t>> roomItems;
+
+        /*  Item::Attrs::isFound of every item (0/1), indexed by item id  */
+        CowVector<uint8_t> itemFound;
+
+        /*
+            where every item is - a room id, Delta::Inventory or Delta::Nowhere, indexed by item id
+            kept in sync with roomItems and the inventory by MoveItem
+        */
+        CowVector<uint32_t> itemLocations;
+
+        /*
+            how many turns have gone by (only counted if NPCs have schedules, see Tick)
+            where every NPC is follows from it (see NPCRoom), so it's all a session keeps about them
+        */
+        uint32_t turn;
+
+        /*
+            every exit between rooms, indexed by room id (rooms.GetId)
+            shared with the world (and every other session) until this session changes an exit,
+            then it becomes an overlay of its own that only copies the rooms whose exits changed
+            (see MutableRoomGraph)
+        */
+        std::shared_ptr<RoomGraph> roomGraph;
+
+        /*  every exit set while playing, one entry per exit in the order they were first set - these are what snapshots save instead of the whole graph  */
+        std::vector<DynamicLink> dynamicLinks;
+
+        /*  shortest routes for "go to <room>" (and its reverse exit index for the session's graph)  */
+        PathFinder pathFinder;
+
+        /*
+            when each NPC visit to the player's room next starts or ends (ids are indexes into roomVisits of
+            npcWheelRoom), so a turn only touches the NPCs coming or going there - worked out again from the
+            turn whenever the player is somewhere else or the turn jumped (see WatchNPCs)
+        */
+        TimingWheel npcWheel;
+        /*  the room npcWheel is for, Delta::Nowhere if it needs working out  */
+        uint32_t npcWheelRoom;
+        /*  the visits npcWheel says are due this turn, kept so ticking doesn't allocate  */
+        std::vector<uint32_t> npcsDue;
+
+        /*  what every command changed, for "undo" and "redo"  */
+        UndoLog undoLog;
+
+        /*  true while undo/redo is applying deltas, so they don't end up back in undoLog  */
+        bool undoing;
+
+        /*  every line written by the command being evaluated (trailing spaces trimmed), see Eval  */
+        std::vector<std::string> output;
+
+        /*  where output is shown as well, nullptr if it's only collected in output (network players)  */
+        Frontend *frontend;
 
-    /*  the graphics instance  */
-    Graphics *graphics;
+        /*  the autosave journal, nullptr if autosave is off (see EnableAutosave)  */
+        std::unique_ptr<Journal> journal;
 
-    /*  the current state of the game (see GameState)  */
-    GameState state;
+        /*  records every Eval, nullptr if not recording (see StartRecording)  */
+        std::unique_ptr<Transcript> transcript;
+
+        /*
+            the interaction that's waiting for the player (the exit menu, a conversation, the pager), if any -
+            Eval() gives it the next line instead of running a command, Run() the next key. Not saved or
+            copied: a session that's hibernated or saved mid-interaction comes back just playing
+        */
+        Flow flow;
+
+        /*
+            copies the game state (everything up to dynamicLinks) from another session,
+            the exits stay shared until one of them changes
+        */
+        void CopyStateFrom(Session const& other);
+    };
+
+    private:
+
+    /*  whatever the player sees and types into (see Frontend)  */
+    std::unique_ptr<Frontend> frontend;
 
     Collection<Command> commands;
     Collection<Item> items;
     Collection<Room> rooms;
+    Collection<NPC> npcs;
+
+    /*  every NPC's conversations (see Dialogue), and where each NPC's starts (Dialogue::End if it has none), indexed by NPC id  */
+    Dialogue dialogue;
+    std::vector<uint32_t> npcDialogue;
 
     /*
-        name of the room the player is currently in
-        common idiom for this is rooms.at(currentRoom).doWhatever()
+        what NPCs take in trade, by (NPC id << 32 | offered item id) - the item they give back
+        (Delta::Nowhere if nothing) and what they say, interned in dialogue
     */
-    std::string currentRoom;
-    
-    /*  the player object  */
-    Player player;
+    struct TradeEntry {
+        uint32_t gives;
+        uint32_t message;
+    };
+    std::unordered_map<uint64_t, TradeEntry> trades;
+
+    /*
+        NPC schedules, flattened - NPC i's stops are scheduleStops[first .. first + count) of npcSchedules[i]
+        (count 0 = no schedule), each with the turn into the period it ends on, offset = where in the period
+        turn 0 is, so NPCs with the same schedule don't all move at once
+    */
+    struct ScheduleStop {
+        uint32_t room;
+        uint32_t end;
+    };
+    struct NPCSchedule {
+        uint32_t first;
+        uint32_t count;
+        uint32_t period;
+        uint32_t offset;
+    };
+    std::vector<ScheduleStop> scheduleStops;
+    std::vector<NPCSchedule> npcSchedules;
+    /*  NPCs with more than one stop - the only ones that ever move  */
+    std::vector<uint32_t> scheduledNPCs;
+
+    /*  the room every NPC without a schedule was put in (AddNPCToRoom), Delta::Nowhere if none, indexed by NPC id  */
+    std::vector<uint32_t> npcRooms;
+
+    /*
+        who can be in each room, indexed by room id - an NPC without a schedule has one visit where it was put,
+        one with a schedule has one per run of its stops in the room, for the turns [start, end) into its period
+        NPCs don't go anywhere their schedule doesn't say, so this never changes after setup and every session
+        reads the same one
+    */
+    struct NPCVisit {
+        uint32_t npc;
+        uint32_t start;
+        uint32_t end;
+    };
+    std::vector<std::vector<NPCVisit>> roomVisits;
+
+    /*  rules reacting to what the player does, part of the world like rooms and items (see AddRule)  */
+    EventBus events;
+
+    /*  lowercase room repr -> room id, so "go to <room>" doesn't have to scan every room  */
+    std::unordered_map<std::string, uint32_t> roomIdsByRepr;
+
+    /*  the same for items and NPCs, for "give <item> to <npc>"  */
+    std::unordered_map<std::string, uint32_t> itemIdsByRepr;
+    std::unordered_map<std::string, uint32_t> npcIdsByRepr;
+
+    /*  the game's own session, the one Run() plays  */
+    Session mainSession;
+
+    /*  the world right after Init() - what new sessions and "restart" start from  */
+    Session worldTemplate;
+
+    /*
+        the session Eval(Session&, ...) is running on this thread, and whose game that is
+        (server workers run lots of sessions of one game at once, see Server)
+    */
+    struct Evaluating {
+        TextBasedGame const *game;
+        Session *session;
+    };
+    static inline thread_local Evaluating evaluating = { nullptr, nullptr };
+
+    /*  points Current() at another session until it goes out of scope, exceptions or not  */
+    class SessionScope {
+        Evaluating previous;
+        public:
+        SessionScope(TextBasedGame const *game, Session &s) : previous(evaluating) { evaluating = { game, &s }; }
+        ~SessionScope() { evaluating = previous; }
+    };
+
+    /*  the session every method works on - mainSession, unless this thread is in Eval(Session&, ...)  */
+    Session *Current();
+
+    /*  the session's roomGraph, turned into an overlay of its own first if it's still shared with anyone (world, other sessions)  */
+    RoomGraph& MutableRoomGraph();
+
+    /*
+        sets an exit in the session's roomGraph (target None removes it), remembering it in dynamicLinks
+        and recording it if the game has started
+    */
+    void SetExit(uint32_t from, uint32_t label, uint32_t target);
+
+    /*  adds an exit that's about to be set to dynamicLinks, or updates its entry if it's already there - doesn't touch the graph  */
+    void RememberLink(uint32_t from, uint32_t label, uint32_t target);
+
+    /*  undoes every dynamic link, back to the world as Init() made it  */
+    void RevertDynamicLinks();
+
+    /*  rebuilds itemLocations from the room item lists and the inventory  */
+    void RebuildItemLocations();
+
+    /*  fills in worldTemplate, end of Init()  */
+    void SaveWorldTemplate();
+
+    /*
+        every change to the game state while playing goes through these four,
+        which Record() what they did (nothing is recorded while Loading)
+    */
+
+    /*  puts the player in another room  */
+    void MoveTo(uint32_t roomId);
+    /*  moves an item to a room id, Delta::Inventory or Delta::Nowhere  */
+    void MoveItem(uint32_t itemId, uint32_t location);
+    /*  sets Item::Attrs::isFound  */
+    void SetItemFound(uint32_t itemId, bool found);
+
+    /*  takes an NPC without a schedule out of the room it was put in, if any - only during setup, so nothing is recorded  */
+    void TakeNPCOut(uint32_t npcId);
+
+    /*  the room an NPC's schedule has it in on a turn  */
+    uint32_t GetScheduledRoom(uint32_t npcId, uint32_t turn);
+
+    /*  the room an NPC is in on a turn, Delta::Nowhere if it isn't anywhere  */
+    uint32_t NPCRoom(uint32_t npcId, uint32_t turn);
+
+    /*  is the visit's NPC in its room on a turn?  */
+    bool IsVisiting(NPCVisit const& visit, uint32_t turn);
+
+    /*  the first turn after turn that the visit starts or ends on, 0 if it never does (no schedule, or always there)  */
+    uint64_t GetNextVisitChange(NPCVisit const& visit, uint32_t turn);
+
+    /*  fills the session's npcWheel with the next change of every visit to the player's room, as of the session's turn  */
+    void WatchNPCs();
+
+    /*  sets the session's turn (which is what moves NPCs, see NPCRoom) and records it  */
+    void SetTurn(uint32_t turn);
+
+    /*  writes what a dialogue node says and the numbered replies (a page each if they don't fit on one)  */
+    Flow ShowDialogueNode(uint32_t nodeId);
+
+    /*
+        "Do you want to exit?" until the answer is yes (throws ExitGameException) or no (back to playing),
+        anything else is InvalidExitCommand
+    */
+    Flow ExitMenu();
+
+    /*
+        a conversation with an NPC, from its first dialogue node - every node is shown with numbered replies,
+        the player types a number (InvalidReply if there's no such reply) or bye, and it ends when a reply or
+        node leads nowhere
+    */
+    Flow Talk(uint32_t npcId);
+
+    /*  shows pages one at a time, the next one when a key is hit (all at once if nobody's there to hit one)  */
+    Flow Pager(std::vector<std::string> pages);
+
+    /*  the same for a script's texts, by index - holds on to the script instead of copying them  */
+    Flow Pager(std::shared_ptr<Script const> script, std::array<uint32_t, Script::MaxPages> pages, size_t pageCount);
+
+    /*  what ExitMenu and Talk accept, names in commands  */
+    static inline const std::vector<std::string> ExitMenuCommands = { "Exit: Yes", "Exit: No" };
+    static inline const std::vector<std::string> TalkCommands = { "Talk: Reply", "Talk: Bye" };
+
+    /*  makes flow the session's flow if it's waiting for something, rethrows if it threw before it got that far  */
+    void StartFlow(Flow flow);
+
+    /*  hands a delta to the journal and the undo log  */
+    void Record(Delta const& delta);
+
+    /*  makes the change a delta describes (after), or takes it back (before)  */
+    void ApplyDelta(Delta const& delta, bool backwards = false);
+
+    /*  writes a fresh autosave snapshot and starts the journal over  */
+    void CompactAutosave();
+
+    /*  cached Snapshot::Fingerprint() of the world, 0 = not worked out yet (reset by AddRoom/AddItem)  */
+    uint64_t worldFingerprint;
+
+    /*  reads and writes all of the above  */
+    friend class Snapshot;
+
+    /*  how many frames Run() has drawn, and when the game was created - transcript timestamps  */
+    uint64_t frameCount;
+    std::chrono::steady_clock::time_point startTime;
+
+    /*  everything Run() does on a delay, on the GetRunTime() clock (the frontend gets these too)  */
+    Timers timers;
+    /*  writes the autosave journal's batch once it's waited long enough, see ScheduleJournalFlush  */
+    Timers::Handle journalFlush;
+    /*  when Run() should draw its next frame  */
+    double nextFrame;
+    /*  frame timings for "set profiler on" (see Profiling)  */
+    Profiler profiler;
+
+    /*
+        what was typed when UpdateHint() last looked for a hint - it doesn't look again until that or the commands change
+        (only the game's own session has a hint, so network sessions running Eval on other threads leave these alone)
+    */
+    std::string hintInput;
+    bool hintValid;
+
+    /*  how many of the frontend's fixed steps have run (see Simulate)  */
+    uint64_t simSteps;
+
+    /*  steps Simulate() runs at most in one frame - if it's further behind than that (a stall), the rest are dropped  */
+    static inline constexpr uint64_t MaxStepsPerFrame = 8;
+
+    /*  seconds since the game was created  */
+    double GetRunTime();
+
+    /*
+        the fixed timestep: runs out->Step() once for every 1 / Frontend::StepRate seconds since the
+        last time, so text scrolls and the cursor blinks at the same speed whatever the frame rate
+    */
+    void Simulate(Frontend *out);
+
+    /*  the profiler if it's on and this is the game's own session (network players aren't timed), otherwise nullptr  */
+    Profiler *Profiling();
+
+    /*  draws a frame if out is visible, otherwise lets it do the rest of a frame without drawing  */
+    void Render(Frontend *out);
+
+    /*
+        the frame pacer - waits until the next frame is due or the next timer fires, whichever is first,
+        then runs the timers that are due (doesn't wait if out doesn't draw frames)
+    */
+    void NextFrame(Frontend *out);
+
+    /*  makes sure a timer is set for when the journal's batch is due to be written  */
+    void ScheduleJournalFlush();
+
+    /*  replays transcripts through Eval and checks output  */
+    friend class Transcript;
+
+    /*  plays sessions of the world to see if it can be won  */
+    friend class Solver;
+
+    /*
+        what setup calls got wrong while Loading (a room or item name that doesn't exist, a name used twice...),
+        one line each - those calls are skipped instead of throwing, so one Validator pass finds every mistake
+        (once playing, bad names throw std::out_of_range like they always did)
+    */
+    std::vector<std::string> setupProblems;
+
+    /*  true if there's a room (or item) called name, otherwise remembers it in setupProblems (call = what was called, for the message)  */
+    bool CheckSetupName(std::string const& call, std::string const& name, bool isRoom);
+
+    /*  checks the world for mistakes Init() can't see by itself  */
+    friend class Validator;
+
+    /*  times the hot paths on generated worlds  */
+    friend class Bench;
 
     public:
 
     /*
         TextBasedGame constructor - initializeaz:
-        - graphics instance
+        - frontend (Graphics for the real game, NullFrontend for replaying transcripts...)
         - gamestate - playing
         - all rooms
         - all items
         and:
         - links rooms
         - adds items to rooms
-        - TODO adds npcs to rooms
+        - adds npcs to rooms
         - sets current room
         - writes starting message (You are in the ...)
     */
-    TextBasedGame();
+    TextBasedGame(std::unique_ptr<Frontend> _frontend);
 
     /*
         TextBasedGame destructor
-        pretty much just deletes the graphics instance
+        pretty much just ends the transcript if recording
     */
     ~TextBasedGame();
 
     void Init();
+    /*  same as Init(), but with a procedurally generated world instead of InitRooms() + InitItems()  */
+    void Init(WorldGen::Config const& worldConfig);
     void InitCommands();
     void InitRooms();
     void InitItems();
+    void InitNPCs();
 
     /*
-        Runs the entire game loop
-        Manages key inputs:
-        - chars pressed on kb
-        - sends them to graphics to add/del chars from textIn
-        - eval if ENTER is pressed and there's text in the box
-        - dump if any key is pressed and there's text in the queue
-        - add hint if TAB is pressed and there's a hint
-        and draws graphics
+        Runs the entire game loop, until the frontend closes
+        Every frame:
+        - polls the frontend (it handles typing, backspace, TAB for hints by itself)
+        - on ENTER, dumps the text queue if it's still scrolling, otherwise evals what was typed
+        - updates the hint
+        - runs the frontend's fixed simulation steps that are due (Simulate)
+        - draws the frontend, unless it's hidden (Render)
+        - sleeps until the next frame or timer and runs the timers that are due (NextFrame)
     */
     void Run();
-    /*
-        change the gamestate
-        contains initialization logic (and status messages) based on old state and new state
-    */
-    void ChangeState(GameState newState);
+
+    /*  one frame of Run() without the wait for the next one, returns false once the frontend closes  */
+    bool RunFrame();
+
+    /*  the frame timings (and allocations) of "set profiler on"  */
+    Profiler const& GetProfiler() const;
 
     /* setup */
 
+    /*  adds a room to the world, the room's name must be unique  */
+    void AddRoom(Room room);
+
+    /*  adds an item to the world (not to any room), the item's name must be unique  */
+    void AddItem(Item item);
+
     /*
         Links rooms A and B (those are the names) in the given direction with an optional argument for going both ways
         bothways = false:
@@ -245,12 +711,61 @@ class TextBasedGame {
     */
     void LinkRooms(std::string a, Direction d, std::string b, bool bothWays = true);
 
+    /*
+        Links rooms A and B with an exit of any name ("portal", "trapdoor", "ladder", ...)
+        if reverseExitName isn't empty, B also gets an exit with that name back to A:
+            LinkRooms("Cellar", "ladder", "Kitchen", "trapdoor")
+        relinking an exit that already exists just points it somewhere else
+    */
+    void LinkRooms(std::string a, std::string exitName, std::string b, std::string reverseExitName = "");
+
     /*  adds an item to a room's item list, given their names  */
     void AddItemToRoom(std::string itemName, std::string roomName);
    
     /*  adds an item to the player's inventory (mainly used for setup like addItemToRoom is, i think)  */
     void AddItemToInventory(std::string itemName);
 
+    /*
+        adds a rule for event (see EventBus) - subject is the name of the room (OnEnter, OnTick) or
+        item (OnTake, OnDrop, OnUse) it's about, "" for all of them
+        add rules before InitCommands(), that's when items with OnUse rules get their "use" command
+    */
+    void AddRule(EventBus::Event event, std::string subject, EventBus::Handler handler);
+
+    /*
+        compiles source (see Script) and gives the item a special command running it, returns the script
+        (nullptr if it didn't compile) so rules can run it too - compile errors throw std::invalid_argument,
+        or during setup are noted in setupProblems like bad names are
+    */
+    std::shared_ptr<Script const> AddScript(std::string itemName, std::string pattern, std::vector<std::string> hints, std::string source);
+
+    /*  removes an item from the player's inventory, assumes it's there (for special commands, like using up a key)  */
+    void RemoveItemFromInventory(std::string itemName);
+
+    /*
+        adds an NPC, with what it says (see Dialogue::Line, the first line is what it starts with)
+        and what it trades (the items have to be added first)
+    */
+    void AddNPC(NPC npc, std::vector<Dialogue::Line> lines = {}, std::vector<NPC::Trade> npcTrades = {});
+
+    /*  puts an NPC without a schedule in a room, given their names  */
+    void AddNPCToRoom(std::string npcName, std::string roomName);
+
+    /*
+        gives an NPC a schedule to follow, turn by turn - it goes round the stops, starting offset turns in,
+        and is put wherever that has it on turn 0 (replacing AddNPCToRoom)
+    */
+    void AddNPCSchedule(std::string npcName, std::vector<NPC::Stop> stops, uint32_t offset = 0);
+
+    /*
+        the end of a turn: moves the session on one turn, and any NPC whose schedule says so to its next stop,
+        adding what the player sees of that ("The cook comes in.") to text - called by Eval after every command
+        while Playing, does nothing if no NPC has a schedule
+        only the NPCs coming or going where the player is are touched (see npcWheel), however many there are
+        anywhere else or just staying put - returns how many that was
+    */
+    size_t Tick(std::string &text);
+
     /*  IO functions  */
 
     /*
@@ -264,6 +779,22 @@ class TextBasedGame {
         (should be) only ever used with TBG::read()
     */
     void Eval(std::string input);
+
+    /*
+        same as above, but for another player's session (see Server) - whatever it printed ends up in s.output
+        the game's own session stays current for everything else
+        any number of threads can do this at once, as long as each session is only on one of them at a time
+    */
+    void Eval(Session& s, std::string input);
+
+    /*  a new player, starting where the game starts (call after Init())  */
+    std::unique_ptr<Session> CreateSession();
+
+    /*  appends what s changed compared to a new session to out, to put it away while idle (see Snapshot::WriteSession)  */
+    void Hibernate(Session& s, ByteWriter& out);
+
+    /*  the session Hibernate() wrote, throws FormatError if it's damaged or from a different world  */
+    std::unique_ptr<Session> Rehydrate(ByteReader& in);
     
     /*  literally just a call to TBG::write(""), clears everything  */
     void Clear();
@@ -275,12 +806,15 @@ class TextBasedGame {
     void Write(std::string str);
 
     /*
-        writes a list of strings to textOut - has an internal loop that goes until it's done
-        paginates output, ends with ..., waits for keypress, then displays next page
-        the ... must be added manually (for now) (TODO)
+        writes a list of strings to textOut a page at a time - the first one now, the rest with the Pager flow
+        (all at once if nobody's there to hit a key, or another flow is already running)
+        pages should end with ..., which must be added manually (for now) (TODO)
     */
     void Write(std::vector<std::string> strs);
 
+    /*  writes a script's texts (indices for Script::GetText) like the list above, without copying them into one  */
+    void Write(std::shared_ptr<Script const> script, std::span<uint32_t const> pages);
+
     /*  looks through the hints of every command in getCommands and the first one to match is displayed  */
     void UpdateHint();
 
@@ -309,6 +843,21 @@ class TextBasedGame {
     */
     void TryMove(Direction d);
 
+    /*
+        same as above but for any exit name, prints Messages::InvalidDir if no room
+        anywhere has an exit called that
+    */
+    void TryMove(std::string exitName);
+
+    /*
+        walk the shortest route from the current room to the room with this repr ("go to garden"),
+        only taking exits that are already linked (so never through locked doors), or print:
+        - UnknownRoom if no room is called that
+        - AlreadyThere if the player is standing in it
+        - NoRoute if it can't be reached from here
+    */
+    void TryTravel(std::string roomRepr);
+
     /*
         try to take the given item, either print that you took it, or one of several errors:
         - InvalidTakeHolding if you're already holding it
@@ -334,6 +883,91 @@ class TextBasedGame {
     */
     void TryInspectItem(std::string itemName);
 
+    /*
+        use the item, running its OnUse rules and printing what they say, or:
+        - InvalidUse if it's nowhere to be seen (inv or currentroom)
+    */
+    void TryUseItem(std::string itemName);
+
+    /*  start a conversation with an NPC (the Talk flow) if it's here, otherwise InvalidTalk  */
+    void TryTalk(std::string npcName);
+
+    /*  says the conversation's over and where the player is  */
+    void StopTalking();
+
+    /*
+        give an item to an NPC - both looked up by repr (lowercase), the NPC has to be here and the item held:
+        - the trade happens if the NPC wants it (the item's gone, the player gets what it gives back)
+        - NPC::Message::OnRefuse (or TradeRefused) if it doesn't
+        - InvalidGiveTo / InvalidGive otherwise
+    */
+    void TryGiveItem(std::string itemRepr, std::string npcRepr);
+
+    /*  runs a compiled script on the current session, writing what it says  */
+    void RunScript(std::shared_ptr<Script const> const& script);
+
+    /*  save/load  */
+
+    /*  where autosave keeps its snapshot and journal, next to the game  */
+    static inline std::string AutosaveFileName = "autosave.tbgs";
+    static inline std::string JournalFileName = "autosave.tbgj";
+
+    /*  the journal gets folded into a new autosave snapshot once it's bigger than this (bytes)  */
+    static inline constexpr uint64_t JournalCompactSize = 64 * 1024;
+
+    /*
+        turns on autosave, call after Init()
+        picks up where the last session left off (autosave snapshot + journal) if there is one,
+        then writes every change from here on to the journal
+        returns true if an earlier session was restored
+    */
+    bool EnableAutosave();
+
+    /*  transcripts  */
+
+    /*
+        records every line entered from now on to a transcript at path, call after Init()
+        world = the startup options the world was made with (empty for the built-in one),
+        so a replay can build the same world
+        throws std::runtime_error if the file can't be written
+    */
+    void StartRecording(std::string path, std::string world);
+
+    /*  writes the final state to the transcript and closes it  */
+    void StopRecording();
+
+    /*  puts everything back the way Init() left it, prints GameRestarted + the current room  */
+    void TryRestart();
+
+    /*  where "save" and "load" put the snapshot, next to the game  */
+    static inline std::string SaveFileName = "savegame.tbgs";
+
+    /*  saves a snapshot to SaveFileName, prints GameSaved or SaveFailed (NoSaveOnline for network sessions)  */
+    void TrySave();
+
+    /*  loads the snapshot in SaveFileName, prints GameLoaded + the current room, or NoSavedGame/BadSavedGame/NoSaveOnline  */
+    void TryLoad();
+
+    /*  undo/redo  */
+
+    /*  takes back everything the last command changed, prints Undone + the current room, or NothingToUndo  */
+    void TryUndo();
+
+    /*  puts back whatever the last undo took back, prints Redone + the current room, or NothingToRedo  */
+    void TryRedo();
+
+    /*  sets how many commands can be undone, prints UndoDepthSet or InvalidUndoDepth  */
+    void TrySetUndoDepth(std::string depth);
+
+    /*  turns the profiler overlay on or off ("on"/"off"), prints ProfilerOn/ProfilerOff, or NoProfiler for network players  */
+    void TrySetProfiler(std::string onOff);
+
+    /*  where "save trace" (and quitting, in a TBG_TRACE build) puts the Chrome trace, next to the game  */
+    static inline std::string TraceFileName = "trace.json";
+
+    /*  saves every span so far to TraceFileName, prints TraceSaved or TraceFailed (NoTraceBuilt/NoTraceOnline)  */
+    void TrySaveTrace();
+
     /*  is this item in this room?  */
     bool IsItemInRoom(std::string itemName, std::string roomName);
     /*  is this item in the player's inventory?  */
@@ -347,7 +981,7 @@ class TextBasedGame {
         - some shoes
         TODO plurals, like some ^
     */
-    std::string FullItemRepr(std::string itemName);
+    std::string FullItemRepr(uint32_t itemId);
 
     /*
         gets a string representation of the player's inventory - cases below:
@@ -369,6 +1003,13 @@ class TextBasedGame {
     */
     std::string CurrentRoomRepr();
 
+    /*
+        who's in the current room, "" if nobody:
+        - 1 NPC -> <The guard> is here.
+        - 2+ NPCs -> <The guard> and <the cook> are here.
+    */
+    std::string NPCsHereRepr();
+
 };
 
 #endif /* __TEXTBASEDGAME__ */
\ No newline at end of file
@@ -0,0 +1,98 @@
+#include "threadpool.hpp"
+
+#include <algorithm>
+
+ThreadPool::ThreadPool(size_t threads) {
+    if (threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    queued = 0;
+    nextQueue = 0;
+    steals = 0;
+    stopping = false;
+
+    for (size_t i = 0; i < threads; i++) {
+        queues.push_back(std::make_unique<Queue>());
+    }
+    for (size_t i = 0; i < threads; i++) {
+        workers.emplace_back([this, i]{ WorkerLoop(i); });
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (auto &w : workers) {
+        w.join();
+    }
+}
+
+void ThreadPool::Submit(Task task) {
+    size_t index = (workerPool == this) ? (size_t)workerIndex : nextQueue++ % queues.size();
+    {
+        std::lock_guard<std::mutex> lock(queues[index]->mutex);
+        /* counted before it can be taken, so a worker taking it straight away never takes queued below 0 */
+        queued++;
+        queues[index]->tasks.push_back(std::move(task));
+    }
+    /* taking the lock makes sure a worker that just found nothing is either not asleep yet (and sees queued) or gets woken */
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+    }
+    wake.notify_one();
+}
+
+size_t ThreadPool::GetThreadCount() {
+    return workers.size();
+}
+
+uint64_t ThreadPool::GetStealCount() {
+    return steals;
+}
+
+void ThreadPool::WorkerLoop(size_t index) {
+    workerIndex = index;
+    workerPool = this;
+
+    Task task;
+    while (true) {
+        if (TryTake(index, task)) {
+            task();
+            task = nullptr;
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        wake.wait(lock, [this]{ return queued > 0 || stopping; });
+        if (stopping && queued == 0) {
+            return;
+        }
+    }
+}
+
+bool ThreadPool::TryTake(size_t index, Task &task) {
+    {
+        Queue &own = *queues[index];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.tasks.empty()) {
+            task = std::move(own.tasks.front());
+            own.tasks.pop_front();
+            queued--;
+            return true;
+        }
+    }
+    for (size_t i = 1; i < queues.size(); i++) {
+        Queue &other = *queues[(index + i) % queues.size()];
+        std::lock_guard<std::mutex> lock(other.mutex);
+        if (!other.tasks.empty()) {
+            task = std::move(other.tasks.back());
+            other.tasks.pop_back();
+            queued--;
+            steals++;
+            return true;
+        }
+    }
+    return false;
+}
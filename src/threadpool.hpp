@@ -0,0 +1,81 @@
+#ifndef __THREADPOOL__
+#define __THREADPOOL__
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/*
+    Work-stealing thread pool - every worker has its own queue and takes from the front of it,
+    when that's empty it steals from the back of someone else's, so a burst of work landing on
+    one worker spreads out by itself. Owners go oldest first (not newest first like fork-join pools)
+    because tasks here are players waiting on a reply, and thieves working the other end keeps
+    them out of the owner's way
+
+    Tasks submitted from outside the pool are dealt out round-robin, tasks submitted by a
+    worker (from inside a task) go on that worker's own queue
+
+    No ordering between tasks at all - anything that needs to run in order has to chain
+    itself (see Server, one task per session at a time)
+*/
+class ThreadPool {
+
+    public:
+
+    using Task = std::function<void()>;
+
+    /*  starts the workers, 0 = one per core  */
+    ThreadPool(size_t threads = 0);
+
+    /*  runs whatever is still queued, then joins every worker  */
+    ~ThreadPool();
+
+    ThreadPool(ThreadPool const&) = delete;
+    ThreadPool& operator=(ThreadPool const&) = delete;
+
+    /*  queues a task, some worker runs it eventually  */
+    void Submit(Task task);
+
+    /*  how many workers there are  */
+    size_t GetThreadCount();
+
+    /*  how many tasks were taken from another worker's queue, for tuning  */
+    uint64_t GetStealCount();
+
+    private:
+
+    /*  one worker's queue, the owner's end is the front  */
+    struct Queue {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    std::vector<std::unique_ptr<Queue>> queues;
+    std::vector<std::thread> workers;
+
+    /*  tasks queued anywhere and not taken yet, workers sleep while it's 0  */
+    std::atomic<size_t> queued;
+    std::atomic<size_t> nextQueue;
+    std::atomic<uint64_t> steals;
+    bool stopping;
+
+    std::mutex sleepMutex;
+    std::condition_variable wake;
+
+    /*  index of the worker running on this thread (in whichever pool), -1 off the pool  */
+    static inline thread_local int workerIndex = -1;
+    static inline thread_local ThreadPool const *workerPool = nullptr;
+
+    void WorkerLoop(size_t index);
+
+    /*  own queue first, then everyone else's, false if there's nothing anywhere  */
+    bool TryTake(size_t index, Task &task);
+};
+
+#endif
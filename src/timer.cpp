@@ -1,26 +1,95 @@
 #include "timer.hpp"
 
-Timer::Timer(double _interval, std::function<void()> _callback) {
-    interval = _interval;
-    lastRecorded = 0;
-    callback = _callback;
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+
+Timers::Timers() {
+    now = 0;
+    nextHandle = None + 1;
+}
+
+bool Timers::Later(Deadline const& a, Deadline const& b) {
+    return (a.time != b.time) ? a.time > b.time : a.handle > b.handle;
+}
+
+void Timers::Push(double time, Handle handle) {
+    heap.push_back(Deadline { time, handle });
+    std::push_heap(heap.begin(), heap.end(), Later);
 }
 
-bool Timer::IntervalPassed() {
-    double newTime = GetTime();
-    if (lastRecorded + interval <= newTime) {
-        lastRecorded = newTime;
-        return true;
+Timers::Handle Timers::After(double delay, Callback callback) {
+    Handle handle = nextHandle++;
+    timers.emplace(handle, Timer { std::move(callback), 0 });
+    Push(now + std::max(delay, 0.0), handle);
+    return handle;
+}
+
+Timers::Handle Timers::Every(double interval, Callback callback) {
+    if (!(interval > 0)) {
+        throw std::invalid_argument("Timers::Every: the interval has to be more than 0");
     }
-    return false;
+    Handle handle = nextHandle++;
+    timers.emplace(handle, Timer { std::move(callback), interval });
+    Push(now + interval, handle);
+    return handle;
+}
+
+bool Timers::Cancel(Handle handle) {
+    return timers.erase(handle) > 0;
 }
 
-void Timer::CheckTime() {
-    if (IntervalPassed()) {
+bool Timers::IsPending(Handle handle) const {
+    return timers.count(handle) > 0;
+}
+
+size_t Timers::Update(double _now) {
+    now = std::max(now, _now);
+    size_t ran = 0;
+    while (!heap.empty() && heap.front().time <= now) {
+        Deadline due = heap.front();
+        std::pop_heap(heap.begin(), heap.end(), Later);
+        heap.pop_back();
+
+        auto it = timers.find(due.handle);
+        if (it == timers.end()) {
+            /* cancelled */
+            continue;
+        }
+        /* the callback is moved out while it runs, so it can cancel itself or add timers */
+        Callback callback = std::move(it->second.callback);
+        double interval = it->second.interval;
+        if (interval == 0) {
+            timers.erase(it);
+            callback();
+            ran++;
+            continue;
+        }
         callback();
+        ran++;
+        it = timers.find(due.handle);
+        if (it == timers.end()) {
+            continue;
+        }
+        it->second.callback = std::move(callback);
+        double next = due.time + interval;
+        Push((next > now) ? next : now + interval, due.handle);
     }
+    return ran;
 }
 
-void Timer::Reset() {
-    lastRecorded = 0;
-}
\ No newline at end of file
+double Timers::NextDeadline() {
+    while (!heap.empty() && !timers.count(heap.front().handle)) {
+        std::pop_heap(heap.begin(), heap.end(), Later);
+        heap.pop_back();
+    }
+    return heap.empty() ? std::numeric_limits<double>::infinity() : heap.front().time;
+}
+
+double Timers::GetTime() const {
+    return now;
+}
+
+size_t Timers::Size() const {
+    return timers.size();
+}
@@ -1,41 +1,90 @@
 #ifndef __TIMER__
 #define __TIMER__
 
+#include <cstddef>
+#include <cstdint>
 #include <functional>
-
-#include "raylib/raylib.h"
+#include <unordered_map>
+#include <vector>
 
 /*
-    utility class that returns true every x seconds (ignoring any granularity with how often it's called)
-    has an optional callback that can run after the interval passed
+    Every timed thing in one place - backspace repeating while it's held, the autosave journal's
+    batch delay, and whatever comes next - instead of one object per timer that has to be polled
+    by hand every frame
+
+    Timers are one-shot (After) or repeating (Every), and give back a Handle to Cancel() them with.
+    Deadlines sit in a min-heap, so Update() only looks at the ones that are due, and NextDeadline()
+    says when the next one is - TextBasedGame::Run() sleeps until then (or the next frame) instead of
+    spinning. Cancelled timers are left in the heap and skipped when they come up.
+
+    Time is seconds on whatever clock the owner passes to Update() (Run() uses seconds since the game
+    started), nothing here reads a clock itself. Not thread safe - it's the game loop's.
 */
-class Timer {
-    private:
-        
-    double interval;
-    double lastRecorded;
-    std::function<void()> callback;
+class Timers {
 
     public:
 
-    /* does nothing */
-    static inline const std::function<void()> DefaultCallback = []{};
+    /*  names a timer for Cancel(), None is never handed out  */
+    using Handle = uint64_t;
+    static inline constexpr Handle None = 0;
+
+    using Callback = std::function<void()>;
+
+    Timers();
+
+    /*  runs callback once, delay seconds after the time of the last Update()  */
+    Handle After(double delay, Callback callback);
+
+    /*
+        runs callback every interval seconds (first one interval from now) until it's cancelled
+        throws std::invalid_argument if interval isn't > 0
+    */
+    Handle Every(double interval, Callback callback);
+
+    /*  stops a timer (a callback can cancel its own), returns false if it already fired or was cancelled  */
+    bool Cancel(Handle handle);
+
+    /*  true if the timer is still going to fire (a one-shot isn't while its callback runs)  */
+    bool IsPending(Handle handle) const;
 
     /*
-        Timer constructor
-        _interval - the interval
-        _callback - the optional callback
+        moves the time on to now and runs every callback that's due, in deadline order (ties in the order
+        they were added), returns how many ran - a repeating timer that fell behind runs once and carries on
+        from now, it doesn't catch up
     */
-    Timer(double _interval, std::function<void()> _callback = DefaultCallback);
-    
-    /*  returns true if an interval has passed, then resets the interval  */
-    bool IntervalPassed();
-    
-    /*  checks interval, calls the callback if needed  */
-    void CheckTime();
-    
-    /*  potential BUG here idk, maybe make it set to GetTime instead of 0  */
-    void Reset();
+    size_t Update(double now);
+
+    /*  when the next timer fires, infinity if there aren't any  */
+    double NextDeadline();
+
+    /*  the time of the last Update()  */
+    double GetTime() const;
+
+    /*  how many timers are pending  */
+    size_t Size() const;
+
+    private:
+
+    struct Timer {
+        Callback callback;
+        /*  0 for one-shot  */
+        double interval;
+    };
+
+    struct Deadline {
+        double time;
+        Handle handle;
+    };
+
+    /*  ordering for the heap - the earliest deadline on top  */
+    static bool Later(Deadline const& a, Deadline const& b);
+
+    void Push(double time, Handle handle);
+
+    double now;
+    Handle nextHandle;
+    std::unordered_map<Handle, Timer> timers;
+    std::vector<Deadline> heap;
 };
 
-#endif /* __TIMER__ */
\ No newline at end of file
+#endif /* __TIMER__ */
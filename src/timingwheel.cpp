@@ -0,0 +1,71 @@
+#include "timingwheel.hpp"
+
+#include <bit>
+
+TimingWheel::TimingWheel(uint64_t _now) {
+    now = _now;
+    size = 0;
+}
+
+void TimingWheel::Reset(uint64_t _now) {
+    for (auto &level : slots) {
+        for (auto &slot : level) {
+            slot.clear();
+        }
+    }
+    overflow.clear();
+    now = _now;
+    size = 0;
+}
+
+void TimingWheel::Schedule(uint64_t due, uint32_t id) {
+    Place(Entry { (due > now) ? due : now + 1, id });
+    size++;
+}
+
+void TimingWheel::Place(Entry entry) {
+    /* the highest bit due and now differ in says how far away it is, which says the level */
+    int level = (entry.due == now) ? 0 : (std::bit_width(entry.due ^ now) - 1) / SlotBits;
+    if (level >= Levels) {
+        overflow.push_back(entry);
+        return;
+    }
+    slots[level][(entry.due >> (level * SlotBits)) & (Slots - 1)].push_back(entry);
+}
+
+void TimingWheel::Advance(std::vector<uint32_t> &due) {
+    now++;
+
+    /* every wheel that came round drops its next slot a level - top first, so entries can drop more than once */
+    for (int level = Levels; level >= 1; level--) {
+        uint64_t span = uint64_t(1) << (level * SlotBits);
+        if ((now & (span - 1)) != 0) {
+            continue;
+        }
+        moving.clear();
+        if (level == Levels) {
+            moving.swap(overflow);
+        } else {
+            auto &slot = slots[level][(now >> (level * SlotBits)) & (Slots - 1)];
+            moving.swap(slot);
+        }
+        for (auto &entry : moving) {
+            Place(entry);
+        }
+    }
+
+    auto &slot = slots[0][now & (Slots - 1)];
+    for (auto &entry : slot) {
+        due.push_back(entry.id);
+    }
+    size -= slot.size();
+    slot.clear();
+}
+
+uint64_t TimingWheel::GetTime() const {
+    return now;
+}
+
+size_t TimingWheel::Size() const {
+    return size;
+}
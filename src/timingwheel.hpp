@@ -0,0 +1,67 @@
+#ifndef __TIMINGWHEEL__
+#define __TIMINGWHEEL__
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/*
+    Things to do at some tick in the future (ids, with when they're due), for when there are lots
+    of them and only a few come up at once - NPCs coming and going where the player is (see TextBasedGame::Tick)
+
+    A hierarchical timing wheel: Levels wheels of Slots slots each. Level 0 has one slot per tick
+    for the next 64 ticks, level 1 one slot per 64 ticks for the next 64 * 64, and so on - an entry
+    goes in the lowest level whose span reaches it, and drops down a level each time the wheel below
+    comes round to its slot, until it's in level 0 and fires. Anything further away than the top
+    level reaches waits in overflow.
+
+    So Schedule() is O(1), and Advance() only touches the entries due on that tick plus the ones
+    dropping down (each entry drops at most Levels - 1 times) - never the ones that aren't near yet,
+    however many there are. Slots keep their capacity, so once it's warmed up it doesn't allocate.
+*/
+class TimingWheel {
+
+    public:
+
+    static inline constexpr int SlotBits = 6;
+    static inline constexpr int Slots = 1 << SlotBits;
+    static inline constexpr int Levels = 4;
+
+    TimingWheel(uint64_t _now = 0);
+
+    /*  forgets everything, the time is now now  */
+    void Reset(uint64_t now);
+
+    /*  id fires when the time gets to due (on the next Advance if due isn't after now)  */
+    void Schedule(uint64_t due, uint32_t id);
+
+    /*  moves time on by one tick, adds the ids due then to due (in no particular order)  */
+    void Advance(std::vector<uint32_t> &due);
+
+    uint64_t GetTime() const;
+
+    /*  how many ids are waiting  */
+    size_t Size() const;
+
+    private:
+
+    struct Entry {
+        uint64_t due;
+        uint32_t id;
+    };
+
+    /*  puts an entry in the slot for when it's due, relative to now  */
+    void Place(Entry entry);
+
+    std::array<std::array<std::vector<Entry>, Slots>, Levels> slots;
+    /*  entries further than the top level reaches, placed again every time it comes round  */
+    std::vector<Entry> overflow;
+    /*  entries being moved down a level, kept so that doesn't allocate either  */
+    std::vector<Entry> moving;
+
+    uint64_t now;
+    size_t size;
+};
+
+#endif /* __TIMINGWHEEL__ */
@@ -0,0 +1,124 @@
+#include "trace.hpp"
+
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+
+#define FMT_HEADER_ONLY
+#include "fmt/core.h"
+
+namespace {
+    struct Event {
+        const char *name;
+        /*  nanoseconds since epoch  */
+        uint64_t start;
+        uint64_t duration;
+    };
+
+    /*
+        a thread's spans - chunks that only its thread appends to, each one published by its count
+        (and the next chunk by next), so Save() can read them while the thread carries on
+    */
+    struct Chunk {
+        static inline constexpr size_t Size = 4096;
+        Event events[Size];
+        std::atomic<size_t> count { 0 };
+        std::atomic<Chunk*> next { nullptr };
+    };
+
+    struct Buffer {
+        uint32_t thread;
+        Chunk first;
+        /*  only touched by the buffer's thread  */
+        Chunk *last = &first;
+        size_t total = 0;
+        std::vector<std::unique_ptr<Chunk>> chunks;
+        std::atomic<size_t> dropped { 0 };
+    };
+
+    /*  every thread's buffer, kept after the thread ends so its spans still get saved  */
+    std::mutex buffersLock;
+    std::vector<std::unique_ptr<Buffer>> buffers;
+    Trace::Clock::time_point const epoch = Trace::Clock::now();
+
+    Buffer &ThreadBuffer() {
+        thread_local Buffer *buffer = [] {
+            std::lock_guard lock(buffersLock);
+            buffers.push_back(std::make_unique<Buffer>());
+            buffers.back()->thread = static_cast<uint32_t>(buffers.size());
+            return buffers.back().get();
+        }();
+        return *buffer;
+    }
+}
+
+Trace::Span::Span(const char *_name) : name(_name), start(Clock::now()) { }
+
+Trace::Span::~Span() {
+    Add(name, start, Clock::now());
+}
+
+void Trace::Add(const char *name, Clock::time_point start, Clock::time_point end) {
+    Buffer &buffer = ThreadBuffer();
+    if (buffer.total >= MaxEvents) {
+        buffer.dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    Chunk *chunk = buffer.last;
+    size_t n = chunk->count.load(std::memory_order_relaxed);
+    if (n == Chunk::Size) {
+        buffer.chunks.push_back(std::make_unique<Chunk>());
+        Chunk *next = buffer.chunks.back().get();
+        chunk->next.store(next, std::memory_order_release);
+        buffer.last = chunk = next;
+        n = 0;
+    }
+    chunk->events[n] = Event {
+        name,
+        static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(start - epoch).count()),
+        static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count())
+    };
+    chunk->count.store(n + 1, std::memory_order_release);
+    buffer.total++;
+}
+
+size_t Trace::Save(std::string const& path) {
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out) {
+        throw std::runtime_error(fmt::format("can't write {}", path));
+    }
+
+    /* ts and dur are microseconds, with the nanoseconds after the point */
+    out << "{\"traceEvents\":[\n";
+    out << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"textbasedgame\"}}";
+    size_t saved = 0;
+    std::lock_guard lock(buffersLock);
+    for (auto &buffer : buffers) {
+        out << fmt::format(",\n{{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":{},\"args\":{{\"name\":\"thread {}\"}}}}", buffer->thread, buffer->thread);
+        for (Chunk *chunk = &buffer->first; chunk; chunk = chunk->next.load(std::memory_order_acquire)) {
+            size_t count = chunk->count.load(std::memory_order_acquire);
+            for (size_t i = 0; i < count; i++) {
+                auto &e = chunk->events[i];
+                out << fmt::format(",\n{{\"name\":\"{}\",\"ph\":\"X\",\"pid\":1,\"tid\":{},\"ts\":{}.{:03},\"dur\":{}.{:03}}}",
+                    e.name, buffer->thread, e.start / 1000, e.start % 1000, e.duration / 1000, e.duration % 1000);
+                saved++;
+            }
+        }
+    }
+    out << "\n]}\n";
+    if (!out) {
+        throw std::runtime_error(fmt::format("can't write {}", path));
+    }
+    return saved;
+}
+
+size_t Trace::GetDropped() {
+    size_t dropped = 0;
+    std::lock_guard lock(buffersLock);
+    for (auto &buffer : buffers) {
+        dropped += buffer->dropped.load(std::memory_order_relaxed);
+    }
+    return dropped;
+}
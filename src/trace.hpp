@@ -0,0 +1,76 @@
+#ifndef __TRACE__
+#define __TRACE__
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/*
+    Spans of what the engine was doing and when (Eval, every TryEval, Write wrapping lines, asset
+    loads, Draw...), saved as Chrome trace-event JSON - open it in chrome://tracing or ui.perfetto.dev
+
+        void TextBasedGame::Eval(std::string input) {
+            TRACE_SPAN("Eval");
+            ...
+
+    Only built in with TBG_TRACE defined (make trace). Without it TRACE_SPAN is nothing at all, so
+    normal builds don't pay for it. With it, a span is two clock reads and a store into a buffer of
+    the thread it ran on - no locks, nothing shared - so the server's threads trace side by side.
+    Save() can run while other threads are still adding spans, it only writes what they'd finished.
+
+    Spans are kept until the game ends, up to MaxEvents per thread (the rest are counted, not kept).
+*/
+class Trace {
+
+    public:
+
+    /*  true if TRACE_SPAN does anything in this build  */
+#ifdef TBG_TRACE
+    static inline constexpr bool Enabled = true;
+#else
+    static inline constexpr bool Enabled = false;
+#endif
+
+    /*  spans kept per thread  */
+    static inline constexpr size_t MaxEvents = 1 << 20;
+
+    using Clock = std::chrono::steady_clock;
+
+    /*  a span from construction to destruction, name has to be a string literal (it's kept as a pointer)  */
+    class Span {
+        public:
+
+        Span(const char *_name);
+        ~Span();
+        Span(Span const&) = delete;
+        Span& operator=(Span const&) = delete;
+
+        private:
+
+        const char *name;
+        Clock::time_point start;
+    };
+
+    /*  writes every finished span so far to path as Chrome trace JSON, returns how many (throws std::runtime_error if it can't write)  */
+    static size_t Save(std::string const& path);
+
+    /*  spans that didn't fit in MaxEvents  */
+    static size_t GetDropped();
+
+    private:
+
+    static void Add(const char *name, Clock::time_point start, Clock::time_point end);
+};
+
+#define TRACE_CONCAT_(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_(a, b)
+
+#ifdef TBG_TRACE
+#define TRACE_SPAN(name) Trace::Span TRACE_CONCAT(traceSpan, __LINE__)(name)
+#else
+#define TRACE_SPAN(name) do { } while (false)
+#endif
+
+#endif /* __TRACE__ */
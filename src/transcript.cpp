@@ -0,0 +1,197 @@
+#include "transcript.hpp"
+
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <stdexcept>
+#include <utility>
+
+#define FMT_HEADER_ONLY
+#include "fmt/core.h"
+
+#include "serial.hpp"
+#include "snapshot.hpp"
+#include "textbasedgame.hpp"
+
+namespace {
+    /*  "a / b / c", for printing a few lines of output on one line  */
+    std::string JoinLines(std::vector<std::string> const& lines) {
+        std::string res;
+        for (auto &line : lines) {
+            if (!res.empty()) {
+                res += " / ";
+            }
+            res += line;
+        }
+        return res;
+    }
+}
+
+bool Transcript::ReplayResult::Passed() const {
+    return startMatches && outputMismatches == 0 && endMatches;
+}
+
+Transcript::Transcript(std::string const& path, std::string const& world, uint64_t startDigest) {
+    out.open(path, std::ios::trunc);
+    if (!out) {
+        throw std::runtime_error(fmt::format("can't write transcript {}", path));
+    }
+    out << Header << '\n';
+    out << "world " << world << '\n';
+    out << fmt::format("start {:016x}\n", startDigest);
+    out.flush();
+}
+
+void Transcript::Input(uint64_t frame, double seconds, std::string const& input) {
+    out << fmt::format("> {} {:.3f} {}\n", frame, seconds, input);
+}
+
+void Transcript::Output(std::vector<std::string> const& lines) {
+    for (auto &line : lines) {
+        out << "< " << line << '\n';
+    }
+    out.flush();
+}
+
+void Transcript::End(uint64_t endDigest) {
+    out << fmt::format("end {:016x}\n", endDigest);
+    out.close();
+}
+
+uint64_t Transcript::StateDigest(TextBasedGame& game) {
+    ByteWriter state;
+    Snapshot::Write(game, state);
+    /* FNV-1a, same as Snapshot::Fingerprint */
+    uint64_t hash = 0xcbf29ce484222325ull;
+    for (uint8_t b : state.GetBytes()) {
+        hash ^= b;
+        hash *= 0x100000001b3ull;
+    }
+    return hash;
+}
+
+Transcript::Recording Transcript::Load(std::string const& path) {
+    std::ifstream in(path);
+    if (!in) {
+        throw std::runtime_error(fmt::format("can't read transcript {}", path));
+    }
+
+    Recording recording;
+    std::string line;
+    size_t lineNumber = 0;
+    auto bad = [&]{ return std::runtime_error(fmt::format("{}:{}: not a transcript line", path, lineNumber)); };
+
+    while (std::getline(in, line)) {
+        lineNumber++;
+        if (!line.empty() && line.back() == '\r') {
+            line.pop_back();
+        }
+
+        if (lineNumber == 1) {
+            if (line != Header) {
+                throw bad();
+            }
+            continue;
+        }
+
+        try {
+            if (line.rfind("world", 0) == 0) {
+                recording.world = (line.size() > 6) ? line.substr(6) : "";
+            } else if (line.rfind("start ", 0) == 0) {
+                recording.startDigest = std::stoull(line.substr(6), nullptr, 16);
+            } else if (line.rfind("end ", 0) == 0) {
+                recording.endDigest = std::stoull(line.substr(4), nullptr, 16);
+                recording.hasEnd = true;
+            } else if (line.rfind("> ", 0) == 0) {
+                /* > frame seconds input - input is everything after the second space, spaces and all */
+                size_t frameEnd = line.find(' ', 2);
+                size_t secondsEnd = (frameEnd == std::string::npos) ? std::string::npos : line.find(' ', frameEnd + 1);
+                if (secondsEnd == std::string::npos) {
+                    throw bad();
+                }
+                recording.entries.push_back(Entry {
+                    std::stoull(line.substr(2, frameEnd - 2)),
+                    std::stod(line.substr(frameEnd + 1, secondsEnd - frameEnd - 1)),
+                    line.substr(secondsEnd + 1),
+                    {}
+                });
+            } else if (line.rfind("<", 0) == 0 && !recording.entries.empty()) {
+                recording.entries.back().output.push_back((line.size() > 2) ? line.substr(2) : "");
+            } else if (!line.empty()) {
+                throw bad();
+            }
+        } catch (std::logic_error &e) {
+            /* stoull/stod */
+            throw bad();
+        }
+    }
+
+    if (lineNumber == 0) {
+        throw std::runtime_error(fmt::format("{} is empty", path));
+    }
+    return recording;
+}
+
+Transcript::ReplayResult Transcript::Replay(TextBasedGame& game, Recording const& recording) {
+    /*
+        the save files point into a directory of the replay's own until it's done, so "save" in a transcript
+        doesn't overwrite the player's and "load" doesn't depend on whatever they last saved
+    */
+    struct ScratchSaveFiles {
+        std::filesystem::path dir;
+        std::string saveFileName, autosaveFileName, journalFileName;
+
+        ScratchSaveFiles() {
+            std::string pattern = (std::filesystem::temp_directory_path() / "tbg-replay-XXXXXX").string();
+            if (!mkdtemp(pattern.data())) {
+                throw std::runtime_error(fmt::format("can't make a directory for the replay's save files in {}", std::filesystem::temp_directory_path().string()));
+            }
+            dir = pattern;
+            saveFileName = std::exchange(TextBasedGame::SaveFileName, (dir / "savegame.tbgs").string());
+            autosaveFileName = std::exchange(TextBasedGame::AutosaveFileName, (dir / "autosave.tbgs").string());
+            journalFileName = std::exchange(TextBasedGame::JournalFileName, (dir / "autosave.tbgj").string());
+        }
+
+        ~ScratchSaveFiles() {
+            TextBasedGame::SaveFileName = saveFileName;
+            TextBasedGame::AutosaveFileName = autosaveFileName;
+            TextBasedGame::JournalFileName = journalFileName;
+            std::error_code error;
+            std::filesystem::remove_all(dir, error);
+        }
+    } scratch;
+
+    ReplayResult result;
+    result.startMatches = (StateDigest(game) == recording.startDigest);
+
+    auto start = std::chrono::steady_clock::now();
+    for (auto &entry : recording.entries) {
+        bool exited = false;
+        try {
+            game.Eval(entry.input);
+        } catch (TextBasedGame::ExitGameException &e) {
+            /* "quit" then "y" - nothing gets printed after that */
+            game.Current()->output.clear();
+            exited = true;
+        }
+        result.commands++;
+
+        if (game.Current()->output != entry.output) {
+            if (result.outputMismatches == 0) {
+                result.firstMismatch = fmt::format("command {} \"{}\": expected \"{}\", got \"{}\"",
+                    result.commands, entry.input, JoinLines(entry.output), JoinLines(game.Current()->output));
+            }
+            result.outputMismatches++;
+        }
+
+        if (exited) {
+            break;
+        }
+    }
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    if (recording.hasEnd) {
+        result.endMatches = (StateDigest(game) == recording.endDigest);
+    }
+    return result;
+}
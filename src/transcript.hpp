@@ -0,0 +1,99 @@
+#ifndef __TRANSCRIPT__
+#define __TRANSCRIPT__
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+class TextBasedGame;
+
+/*
+    Records every line the player enters (everything passed to TextBasedGame::Eval) with when it was
+    entered and what the game printed back, so a session can be replayed later without a window
+    and checked against what happened the first time.
+
+    Plain text, one thing per line, so expected output can be read and edited by hand:
+        tbg-transcript 1
+        world <startup options>             - the --world-* options the game was started with, empty = built-in world
+        start <digest>                      - StateDigest() right after Init()
+        > <frame> <seconds> <input>         - a line the player entered, on which frame and how long after startup
+        < <output>                          - a line the game printed for the input above (any number of these)
+        end <digest>                        - StateDigest() when the game was closed (missing if it crashed)
+*/
+class Transcript {
+
+    public:
+
+    /*  first line of every transcript  */
+    static inline constexpr const char* Header = "tbg-transcript 1";
+
+    /*  one line the player entered, and what the game printed back  */
+    struct Entry {
+        uint64_t frame;
+        double seconds;
+        std::string input;
+        std::vector<std::string> output;
+    };
+
+    /*  a whole transcript, as read by Load()  */
+    struct Recording {
+        std::string world;
+        uint64_t startDigest = 0;
+        std::vector<Entry> entries;
+        bool hasEnd = false;
+        uint64_t endDigest = 0;
+    };
+
+    /*  what Replay() found  */
+    struct ReplayResult {
+        /*  how many entries were replayed, and in how long  */
+        size_t commands = 0;
+        double seconds = 0;
+        /*  the game didn't start in the state the transcript did (different world or build)  */
+        bool startMatches = true;
+        /*  entries whose output was different, and the first one of them (as text)  */
+        size_t outputMismatches = 0;
+        std::string firstMismatch;
+        /*  the final state matched "end" (always true if the transcript has no end)  */
+        bool endMatches = true;
+
+        bool Passed() const;
+    };
+
+    private:
+
+    std::ofstream out;
+
+    public:
+
+    /*  starts recording to path (overwriting it), throws std::runtime_error if it can't be opened  */
+    Transcript(std::string const& path, std::string const& world, uint64_t startDigest);
+
+    /*  one line the player entered, written before running it so a crash still leaves it behind  */
+    void Input(uint64_t frame, double seconds, std::string const& input);
+
+    /*  what the game printed for the last Input()  */
+    void Output(std::vector<std::string> const& lines);
+
+    /*  writes the end line and flushes, nothing can be written after this  */
+    void End(uint64_t endDigest);
+
+    /*  hash of everything a snapshot would save, to compare two games cheaply  */
+    static uint64_t StateDigest(TextBasedGame& game);
+
+    /*  reads a whole transcript, throws std::runtime_error if it can't be opened or isn't one  */
+    static Recording Load(std::string const& path);
+
+    /*
+        plays every entry of the recording into the game as fast as possible and compares
+        the output and the final state with what was recorded
+        the game must have been set up the same way (see Recording::world), without autosave
+        save files go to a temporary directory meanwhile (TextBasedGame::SaveFileName etc point there),
+        throws std::runtime_error if it can't be made
+    */
+    static ReplayResult Replay(TextBasedGame& game, Recording const& recording);
+
+};
+
+#endif /* __TRANSCRIPT__ */
@@ -0,0 +1,153 @@
+#include "undolog.hpp"
+
+#include <algorithm>
+
+UndoLog::UndoLog(size_t _depth) {
+    depth = _depth;
+    pending = 0;
+}
+
+void UndoLog::Add(Delta const& delta) {
+    if (depth == 0) {
+        return;
+    }
+    undoDeltas.push_back(delta);
+    pending++;
+}
+
+void UndoLog::Commit() {
+    if (pending == 0) {
+        return;
+    }
+    undoSizes.push_back(pending);
+    pending = 0;
+    redoDeltas.clear();
+    redoSizes.clear();
+    Trim();
+}
+
+void UndoLog::Trim() {
+    while (undoSizes.size() > depth) {
+        undoDeltas.erase(undoDeltas.begin(), undoDeltas.begin() + undoSizes.front());
+        undoSizes.pop_front();
+    }
+}
+
+void UndoLog::SetDepth(size_t _depth) {
+    depth = _depth;
+    Trim();
+}
+
+size_t UndoLog::GetDepth() {
+    return depth;
+}
+
+bool UndoLog::CanUndo() {
+    return !undoSizes.empty();
+}
+
+bool UndoLog::CanRedo() {
+    return !redoSizes.empty();
+}
+
+std::vector<Delta> UndoLog::Undo() {
+    if (!CanUndo()) {
+        return {};
+    }
+    uint32_t size = undoSizes.back();
+    undoSizes.pop_back();
+    std::vector<Delta> step(undoDeltas.end() - size, undoDeltas.end());
+    undoDeltas.erase(undoDeltas.end() - size, undoDeltas.end());
+
+    redoDeltas.insert(redoDeltas.end(), step.begin(), step.end());
+    redoSizes.push_back(size);
+    return step;
+}
+
+std::vector<Delta> UndoLog::Redo() {
+    if (!CanRedo()) {
+        return {};
+    }
+    uint32_t size = redoSizes.back();
+    redoSizes.pop_back();
+    std::vector<Delta> step(redoDeltas.end() - size, redoDeltas.end());
+    redoDeltas.erase(redoDeltas.end() - size, redoDeltas.end());
+
+    undoDeltas.insert(undoDeltas.end(), step.begin(), step.end());
+    undoSizes.push_back(size);
+    return step;
+}
+
+void UndoLog::Clear() {
+    undoDeltas.clear();
+    undoSizes.clear();
+    redoDeltas.clear();
+    redoSizes.clear();
+    pending = 0;
+}
+
+namespace {
+    template<class Deltas, class Sizes>
+    void WriteSteps(ByteWriter& out, Deltas const& deltas, Sizes const& sizes) {
+        out.Var(sizes.size());
+        auto delta = deltas.begin();
+        for (auto size : sizes) {
+            out.Var(size);
+            for (uint32_t i = 0; i < size; i++, delta++) {
+                out.U8(static_cast<uint8_t>(delta->kind));
+                out.Var(delta->subject);
+                out.Var(delta->label);
+                out.Var(delta->before);
+                out.Var(delta->after);
+            }
+        }
+    }
+
+    template<class Deltas, class Sizes>
+    void ReadSteps(ByteReader& in, Deltas& deltas, Sizes& sizes) {
+        /* every step takes at least a byte, don't trust a count bigger than what's left */
+        uint32_t limit = static_cast<uint32_t>(std::min<size_t>(in.Remaining(), UINT32_MAX - 1)) + 1;
+        uint32_t count = in.Index(limit);
+        for (uint32_t s = 0; s < count; s++) {
+            uint32_t size = in.Index(limit);
+            for (uint32_t i = 0; i < size; i++) {
+                Delta d;
+                uint8_t kind = in.U8();
+                if (kind < static_cast<uint8_t>(Delta::Kind::CurrentRoom) || kind > static_cast<uint8_t>(Delta::Kind::ItemFound)) {
+                    throw FormatError("bad delta kind");
+                }
+                d.kind = static_cast<Delta::Kind>(kind);
+                d.subject = in.Index(UINT32_MAX);
+                d.label = in.Index(UINT32_MAX);
+                /* Nowhere is UINT32_MAX, which Index() can't take */
+                uint64_t before = in.Var(), after = in.Var();
+                if (before > UINT32_MAX || after > UINT32_MAX) {
+                    throw FormatError("delta value out of range");
+                }
+                d.before = static_cast<uint32_t>(before);
+                d.after = static_cast<uint32_t>(after);
+                deltas.push_back(d);
+            }
+            sizes.push_back(size);
+        }
+    }
+}
+
+void UndoLog::Write(ByteWriter& out) {
+    out.Var(depth);
+    WriteSteps(out, undoDeltas, undoSizes);
+    WriteSteps(out, redoDeltas, redoSizes);
+}
+
+void UndoLog::Read(ByteReader& in) {
+    Clear();
+    uint64_t newDepth = in.Var();
+    try {
+        ReadSteps(in, undoDeltas, undoSizes);
+        ReadSteps(in, redoDeltas, redoSizes);
+    } catch (FormatError &e) {
+        Clear();
+        throw;
+    }
+    depth = static_cast<size_t>(newDepth);
+}
@@ -0,0 +1,91 @@
+#ifndef __UNDOLOG__
+#define __UNDOLOG__
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+#include "delta.hpp"
+#include "serial.hpp"
+
+/*
+    Undo/redo history, made of the Deltas each command recorded (not copies of the game)
+    so memory grows with how much actually changed, no matter how big the world is
+
+    Deltas of the running command are collected with Add() and closed off with Commit(),
+    each committed command is one step of undo. Only the newest Depth steps are kept.
+    Doing anything new after an undo throws the redo steps away, like every editor ever.
+*/
+class UndoLog {
+
+    private:
+
+    /*  deltas of every undoable command, oldest first  */
+    std::deque<Delta> undoDeltas;
+    /*  how many deltas each undoable command has, oldest first  */
+    std::deque<uint32_t> undoSizes;
+
+    /*  same thing for commands that were undone, newest undo last  */
+    std::vector<Delta> redoDeltas;
+    std::vector<uint32_t> redoSizes;
+
+    /*  how many deltas the running command has added so far  */
+    uint32_t pending;
+
+    /*  max number of undo steps  */
+    size_t depth;
+
+    /*  drops the oldest steps until there are at most depth  */
+    void Trim();
+
+    public:
+
+    /*  default max number of undo steps  */
+    static inline constexpr size_t DefaultDepth = 100;
+
+    /*  UndoLog constructor  */
+    UndoLog(size_t _depth = DefaultDepth);
+
+    /*  adds a delta to the running command  */
+    void Add(Delta const& delta);
+
+    /*  ends the running command - if it changed anything it becomes an undo step and redo is cleared  */
+    void Commit();
+
+    /*  changes the max number of undo steps (0 turns undo off), dropping the oldest if needed  */
+    void SetDepth(size_t _depth);
+
+    size_t GetDepth();
+
+    bool CanUndo();
+    bool CanRedo();
+
+    /*
+        takes the newest undo step and moves it to redo
+        returns its deltas in the order they happened (apply them backwards, last first)
+    */
+    std::vector<Delta> Undo();
+
+    /*
+        takes the newest redo step and moves it back to undo
+        returns its deltas in the order they happened (apply them forwards, first first)
+    */
+    std::vector<Delta> Redo();
+
+    /*  forgets everything (after loading a game etc)  */
+    void Clear();
+
+    /*
+        appends the depth and every undo/redo step to out (not a running command), for hibernating sessions
+        format: depth:Var  undo steps  redo steps, a list of steps being
+            count:Var  (size:Var  (kind:U8 subject:Var label:Var before:Var after:Var)...)...
+    */
+    void Write(ByteWriter& out);
+
+    /*  replaces everything with what Write() wrote, throws FormatError if it doesn't make sense  */
+    void Read(ByteReader& in);
+
+};
+
+#endif /* __UNDOLOG__ */
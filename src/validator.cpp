@@ -0,0 +1,462 @@
+#include "validator.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <latch>
+
+namespace {
+    /*  rooms/items a worker takes at a time - big enough that the cursor isn't fought over  */
+    constexpr size_t Chunk = 4096;
+    /*  special commands a worker takes at a time, each one runs a command  */
+    constexpr size_t SpecialChunk = 16;
+
+    std::string Lowercase(std::string s) {
+        std::transform(s.begin(), s.end(), s.begin(), [](unsigned char c) { return std::tolower(c); });
+        return s;
+    }
+}
+
+Validator::Validator(TextBasedGame& _game, Config _config) : game(_game), config(std::move(_config)) { }
+
+size_t Validator::Report::GetErrorCount() const {
+    size_t count = 0;
+    for (auto &check : checks) {
+        count += check.isError ? check.count : 0;
+    }
+    return count;
+}
+
+size_t Validator::Report::GetWarningCount() const {
+    size_t count = 0;
+    for (auto &check : checks) {
+        count += check.isError ? 0 : check.count;
+    }
+    return count;
+}
+
+template<class F>
+void Validator::ParallelFor(ThreadPool &pool, size_t count, size_t chunk, F f) {
+    size_t workers = problems.size();
+    std::atomic<size_t> cursor = 0;
+    std::latch done(static_cast<ptrdiff_t>(workers));
+    for (size_t w = 0; w < workers; w++) {
+        pool.Submit([&, w]{
+            for (size_t begin; (begin = cursor.fetch_add(chunk)) < count; ) {
+                f(w, begin, std::min(begin + chunk, count));
+            }
+            done.count_down();
+        });
+    }
+    done.wait();
+}
+
+Validator::Report Validator::Validate() {
+    auto startTime = std::chrono::steady_clock::now();
+    Report report;
+    report.rooms = game.rooms.Size();
+    report.items = game.items.Size();
+
+    ThreadPool pool(config.threads);
+    report.threads = pool.GetThreadCount();
+    problems.assign(report.threads, {});
+    links.assign(report.threads, {});
+
+    /* listed once, rather than asking the file system about every room */
+    imageNames.clear();
+    if (!config.imageDirectory.empty()) {
+        std::error_code error;
+        for (auto &entry : std::filesystem::directory_iterator(config.imageDirectory, error)) {
+            imageNames.insert(entry.path().filename().string());
+        }
+    }
+
+    for (uint32_t i = 0; i < game.setupProblems.size(); i++) {
+        problems[0].push_back(Problem { Setup, i, 0 });
+    }
+    CheckRooms(pool);
+    CheckItems(pool);
+    FindSpecialLinks(pool, report);
+    CheckReachable(pool, report);
+
+    /* sorted, so the examples are the same however the threads went */
+    std::vector<Problem> all;
+    for (auto &p : problems) {
+        all.insert(all.end(), p.begin(), p.end());
+        std::vector<Problem>().swap(p);
+    }
+    std::sort(all.begin(), all.end(), [](Problem const &x, Problem const &y) {
+        return (x.kind != y.kind) ? x.kind < y.kind : (x.a != y.a) ? x.a < y.a : x.b < y.b;
+    });
+
+    report.checks = {
+        Check { "setup calls", true, 0, {} },
+        Check { "exits", true, 0, {} },
+        Check { "item lists", true, 0, {} },
+        Check { "start room", true, 0, {} },
+        Check { "unreachable rooms", true, 0, {} },
+        Check { "items nowhere", false, 0, {} },
+        Check { "items in unreachable rooms", false, 0, {} },
+        Check { "room images", false, 0, {} },
+    };
+    for (auto &p : all) {
+        auto &check = report.checks[CheckOf(p.kind)];
+        check.count++;
+        if (check.examples.size() < config.maxExamples) {
+            check.examples.push_back(Describe(p));
+        }
+    }
+
+    report.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+    return report;
+}
+
+void Validator::CheckRooms(ThreadPool &pool) {
+    auto &world = game.worldTemplate;
+    auto &graph = *world.roomGraph;
+    uint32_t roomCount = game.rooms.Size(), itemCount = game.items.Size(), labelCount = graph.GetLabelCount();
+
+    if (graph.RoomCount() > roomCount) {
+        problems[0].push_back(Problem { ExtraGraphRooms, graph.RoomCount(), 0 });
+    }
+
+    ParallelFor(pool, roomCount, Chunk, [&](size_t w, size_t begin, size_t end) {
+        auto &found = problems[w];
+        std::vector<uint32_t> sorted;
+        for (uint32_t r = static_cast<uint32_t>(begin); r < end; r++) {
+            for (auto &exit : graph.GetExits(r)) {
+                if (exit.target >= roomCount) {
+                    found.push_back(Problem { ExitTarget, r, exit.target });
+                }
+                if (exit.label >= labelCount) {
+                    found.push_back(Problem { ExitLabel, r, exit.label });
+                }
+            }
+
+            auto &list = world.roomItems.Get(r);
+            for (auto item : list) {
+                if (item >= itemCount) {
+                    found.push_back(Problem { ItemId, r, item });
+                } else if (world.itemLocations.Get(item) != r) {
+                    found.push_back(Problem { MisplacedItem, r, item });
+                }
+            }
+            if (list.size() > 1) {
+                sorted.assign(list.begin(), list.end());
+                std::sort(sorted.begin(), sorted.end());
+                for (size_t k = 1; k < sorted.size(); k++) {
+                    if (sorted[k] == sorted[k - 1] && (k == 1 || sorted[k] != sorted[k - 2])) {
+                        found.push_back(Problem { DuplicateItem, r, sorted[k] });
+                    }
+                }
+            }
+
+            if (!config.imageDirectory.empty() && !imageNames.contains(Lowercase(game.rooms.GetName(r)) + ".png")) {
+                found.push_back(Problem { MissingImage, r, 0 });
+            }
+        }
+    });
+}
+
+void Validator::CheckItems(ThreadPool &pool) {
+    auto &world = game.worldTemplate;
+    uint32_t roomCount = game.rooms.Size(), itemCount = game.items.Size();
+
+    /* the inventory is one list, small enough for one thread */
+    std::vector<uint8_t> inInventory(itemCount, 0);
+    for (auto item : world.player.GetInventory()) {
+        if (item >= itemCount) {
+            problems[0].push_back(Problem { ItemId, Delta::Inventory, item });
+        } else if (inInventory[item]++ == 1) {
+            problems[0].push_back(Problem { DuplicateItem, Delta::Inventory, item });
+        } else if (world.itemLocations.Get(item) != Delta::Inventory) {
+            problems[0].push_back(Problem { MisplacedItem, Delta::Inventory, item });
+        }
+    }
+
+    ParallelFor(pool, itemCount, Chunk, [&](size_t w, size_t begin, size_t end) {
+        auto &found = problems[w];
+        for (uint32_t i = static_cast<uint32_t>(begin); i < end; i++) {
+            uint32_t location = world.itemLocations.Get(i);
+            if (location == Delta::Nowhere) {
+                found.push_back(Problem { Nowhere, i, 0 });
+            } else if (location == Delta::Inventory) {
+                if (!inInventory[i]) {
+                    found.push_back(Problem { NotInInventory, i, 0 });
+                }
+            } else if (location >= roomCount) {
+                found.push_back(Problem { NotInRoom, i, location });
+            } else {
+                auto &list = world.roomItems.Get(location);
+                if (std::find(list.begin(), list.end(), i) == list.end()) {
+                    found.push_back(Problem { NotInRoom, i, location });
+                }
+            }
+        }
+    });
+}
+
+void Validator::FindSpecialLinks(ThreadPool &pool, Report &report) {
+    auto &world = game.worldTemplate;
+    uint32_t roomCount = game.rooms.Size(), itemCount = game.items.Size();
+
+    std::vector<std::pair<uint32_t, uint32_t>> specials;
+    for (uint32_t i = 0; i < itemCount; i++) {
+        auto &commands = game.items.Get(i).GetSpecialCommands();
+        for (uint32_t k = 0; k < commands.size(); k++) {
+            if (!commands[k].GetHints().empty()) {
+                specials.emplace_back(i, k);
+            }
+        }
+    }
+    report.specialCommands = specials.size();
+    linkOffsets.assign(roomCount + 1, 0);
+    linkTargets.clear();
+    if (specials.empty() || world.currentRoom >= roomCount) {
+        return;
+    }
+
+    /*
+        the world with every carriable item held, flattened so copies of it share everything -
+        only items the lists agree about are moved (MoveItem trusts them, CheckItems reports the rest)
+    */
+    TextBasedGame::Session held;
+    held.CopyStateFrom(world);
+    {
+        TextBasedGame::SessionScope scope(&game, held);
+        held.state = TextBasedGame::GameState::Loading;
+        for (uint32_t i = 0; i < itemCount; i++) {
+            uint32_t location = world.itemLocations.Get(i);
+            if (!game.items.Get(i).GetFlags().canCarry || location == Delta::Inventory || (location != Delta::Nowhere && location >= roomCount)) {
+                continue;
+            }
+            if (location != Delta::Nowhere) {
+                auto &list = world.roomItems.Get(location);
+                if (std::find(list.begin(), list.end(), i) == list.end()) {
+                    continue;
+                }
+            }
+            game.MoveItem(i, Delta::Inventory);
+        }
+    }
+    held.roomItems.Flatten();
+    held.itemFound.Flatten();
+    held.itemLocations.Flatten();
+
+    /*
+        every worker runs its commands on one copy of held, undoing each one's changes afterwards -
+        copying held for every command would copy the whole inventory every time
+    */
+    std::vector<std::unique_ptr<TextBasedGame::Session>> sessions(problems.size());
+    ParallelFor(pool, specials.size(), SpecialChunk, [&](size_t w, size_t begin, size_t end) {
+        if (!sessions[w]) {
+            sessions[w] = std::make_unique<TextBasedGame::Session>();
+            sessions[w]->CopyStateFrom(held);
+        }
+        auto &c = *sessions[w];
+        TextBasedGame::SessionScope scope(&game, c);
+
+        for (size_t s = begin; s < end; s++) {
+            auto [item, index] = specials[s];
+            /* where the command's item is, so it's run the way a player would */
+            uint32_t owner = world.itemLocations.Get(item);
+            c.currentRoom = (owner < roomCount) ? owner : world.currentRoom;
+            c.undoLog.Clear();
+            c.output.clear();
+            c.state = TextBasedGame::GameState::Playing;
+
+            /* a copy, regexes aren't shared between threads */
+            Command command = game.items.Get(item).GetSpecialCommands()[index];
+            std::string input = command.GetHints().front();
+            try {
+                command.TryEval(input);
+            } catch (...) {
+                /* ExitGameException or worse, it didn't link anything */
+            }
+
+            for (auto &link : c.dynamicLinks) {
+                if (link.from < roomCount && link.target < roomCount) {
+                    links[w].push_back(Link { link.from, link.target });
+                }
+            }
+
+            /* back to held - items through the undo log, the rest is just shared again */
+            c.state = TextBasedGame::GameState::Loading;
+            c.undoLog.Commit();
+            if (c.undoLog.CanUndo()) {
+                auto step = c.undoLog.Undo();
+                for (auto it = step.rbegin(); it != step.rend(); it++) {
+                    if (it->kind == Delta::Kind::ItemLocation) {
+                        game.ApplyDelta(*it, true);
+                    }
+                }
+            }
+            c.itemFound = held.itemFound;
+            c.roomGraph = held.roomGraph;
+            c.dynamicLinks.clear();
+        }
+    });
+
+    /* one CSR of them, like the exits */
+    std::vector<Link> all;
+    for (auto &l : links) {
+        all.insert(all.end(), l.begin(), l.end());
+        std::vector<Link>().swap(l);
+    }
+    for (auto &link : all) {
+        linkOffsets[link.from + 1]++;
+    }
+    for (uint32_t r = 0; r < roomCount; r++) {
+        linkOffsets[r + 1] += linkOffsets[r];
+    }
+    linkTargets.resize(all.size());
+    std::vector<uint32_t> next(linkOffsets.begin(), linkOffsets.end() - 1);
+    for (auto &link : all) {
+        linkTargets[next[link.from]++] = link.target;
+    }
+}
+
+void Validator::CheckReachable(ThreadPool &pool, Report &report) {
+    auto &world = game.worldTemplate;
+    uint32_t roomCount = game.rooms.Size(), itemCount = game.items.Size();
+
+    reached.assign(roomCount, 0);
+    if (world.currentRoom >= roomCount) {
+        problems[0].push_back(Problem { StartRoom, world.currentRoom, 0 });
+        return;
+    }
+
+    /* by exits alone first, then on from wherever a special command makes an exit */
+    reached[world.currentRoom] = 1;
+    Spread(pool, { world.currentRoom }, 1, false);
+    std::vector<uint32_t> frontier;
+    for (uint32_t r = 0; r < roomCount; r++) {
+        if (reached[r] && linkOffsets[r] != linkOffsets[r + 1]) {
+            frontier.push_back(r);
+        }
+    }
+    Spread(pool, std::move(frontier), 2, true);
+
+    std::vector<size_t> counts(problems.size() * 2, 0);
+    ParallelFor(pool, roomCount, Chunk, [&](size_t w, size_t begin, size_t end) {
+        for (uint32_t r = static_cast<uint32_t>(begin); r < end; r++) {
+            if (reached[r] == 0) {
+                problems[w].push_back(Problem { Unreachable, r, 0 });
+            } else {
+                counts[w * 2] += 1;
+                counts[w * 2 + 1] += (reached[r] == 2);
+            }
+        }
+    });
+    for (size_t w = 0; w < problems.size(); w++) {
+        report.reachableRooms += counts[w * 2];
+        report.roomsBehindSpecials += counts[w * 2 + 1];
+    }
+
+    ParallelFor(pool, itemCount, Chunk, [&](size_t w, size_t begin, size_t end) {
+        for (uint32_t i = static_cast<uint32_t>(begin); i < end; i++) {
+            uint32_t location = world.itemLocations.Get(i);
+            if (location < roomCount && reached[location] == 0) {
+                problems[w].push_back(Problem { InUnreachableRoom, i, location });
+            }
+        }
+    });
+}
+
+void Validator::Spread(ThreadPool &pool, std::vector<uint32_t> frontier, uint8_t mark, bool useLinks) {
+    auto &graph = *game.worldTemplate.roomGraph;
+    uint32_t roomCount = game.rooms.Size();
+    std::vector<std::vector<uint32_t>> next(problems.size());
+
+    /* one level at a time, whoever marks a room first gets to carry on from it */
+    while (!frontier.empty()) {
+        ParallelFor(pool, frontier.size(), Chunk, [&](size_t w, size_t begin, size_t end) {
+            auto visit = [&](uint32_t target) {
+                if (target >= roomCount) {
+                    return;
+                }
+                std::atomic_ref<uint8_t> seen(reached[target]);
+                uint8_t expected = 0;
+                if (seen.load(std::memory_order_relaxed) == 0 && seen.compare_exchange_strong(expected, mark, std::memory_order_relaxed)) {
+                    next[w].push_back(target);
+                }
+            };
+            for (size_t i = begin; i < end; i++) {
+                uint32_t r = frontier[i];
+                for (auto &exit : graph.GetExits(r)) {
+                    visit(exit.target);
+                }
+                if (useLinks) {
+                    for (uint32_t k = linkOffsets[r]; k < linkOffsets[r + 1]; k++) {
+                        visit(linkTargets[k]);
+                    }
+                }
+            }
+        });
+        frontier.clear();
+        for (auto &n : next) {
+            frontier.insert(frontier.end(), n.begin(), n.end());
+            n.clear();
+        }
+    }
+}
+
+size_t Validator::CheckOf(Kind kind) {
+    switch (kind) {
+        case Setup: return 0;
+        case ExitTarget: case ExitLabel: case ExtraGraphRooms: return 1;
+        case ItemId: case DuplicateItem: case MisplacedItem: case NotInRoom: case NotInInventory: return 2;
+        case StartRoom: return 3;
+        case Unreachable: return 4;
+        case Nowhere: return 5;
+        case InUnreachableRoom: return 6;
+        case MissingImage: default: return 7;
+    }
+}
+
+std::string Validator::Describe(Problem const& p) {
+    auto &world = game.worldTemplate;
+    uint32_t roomCount = game.rooms.Size(), itemCount = game.items.Size();
+    auto where = [&](uint32_t location) -> std::string {
+        if (location == Delta::Inventory) {
+            return "the inventory";
+        }
+        if (location == Delta::Nowhere) {
+            return "nowhere";
+        }
+        return (location < roomCount) ? game.rooms.GetName(location) : fmt::format("room #{}", location);
+    };
+
+    switch (p.kind) {
+        case Setup:
+            return game.setupProblems[p.a];
+        case ExitTarget:
+            return fmt::format("{} has an exit to room #{}, there are only {} rooms", where(p.a), p.b, roomCount);
+        case ExitLabel:
+            return fmt::format("{} has an exit named #{}, there are only {} exit names", where(p.a), p.b, world.roomGraph->GetLabelCount());
+        case ExtraGraphRooms:
+            return fmt::format("the exits know about {} rooms, there are only {}", p.a, roomCount);
+        case ItemId:
+            return fmt::format("{} lists item #{}, there are only {} items", where(p.a), p.b, itemCount);
+        case DuplicateItem:
+            return fmt::format("{} lists {} more than once", where(p.a), game.items.GetName(p.b));
+        case MisplacedItem:
+            return fmt::format("{} lists {}, but it's in {}", where(p.a), game.items.GetName(p.b), where(world.itemLocations.Get(p.b)));
+        case NotInRoom:
+            return fmt::format("{} is in {}, but isn't on its list", game.items.GetName(p.a), where(p.b));
+        case NotInInventory:
+            return fmt::format("{} is in the inventory, but isn't on its list", game.items.GetName(p.a));
+        case StartRoom:
+            return fmt::format("the game starts in room #{}, there are only {} rooms", p.a, roomCount);
+        case Unreachable:
+            return where(p.a);
+        case Nowhere:
+            return game.items.GetName(p.a);
+        case InUnreachableRoom:
+            return fmt::format("{} is in {}", game.items.GetName(p.a), where(p.b));
+        case MissingImage:
+        default:
+            return (std::filesystem::path(config.imageDirectory) / (Lowercase(game.rooms.GetName(p.a)) + ".png")).string() + " doesn't exist";
+    }
+}
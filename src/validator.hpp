@@ -0,0 +1,153 @@
+#ifndef __VALIDATOR__
+#define __VALIDATOR__
+
+#include <cstdint>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include "textbasedgame.hpp"
+#include "threadpool.hpp"
+
+/*
+    World checker - looks for the mistakes in a world that only show up while playing, if at all:
+    - setup calls with names that don't exist (AddItemToRoom("Lamp", "Atic"), LinkRooms to a typo),
+      names used twice (see TextBasedGame::setupProblems)
+    - exits leading to rooms that don't exist, room item lists that don't match where the items are
+    - rooms that can't be got to from the start
+    - items that aren't anywhere, or only in rooms that can't be got to
+    - rooms without an image (<lowercase room name>.png in Config::imageDirectory)
+
+    A room counts as reachable if an exit leads there, or an exit some special command makes -
+    every special command with a hint is run once, with every carriable item held and standing
+    where its item is, and whatever exits it adds are followed too. That can't know about
+    commands that only work after other ones (pull the lever, then the door opens), so rooms
+    behind those show up as unreachable.
+
+    Rooms, items and special commands are each split into chunks that a ThreadPool's
+    workers take one at a time; problems are kept as three numbers until the end, sorted
+    (so the report doesn't depend on thread timing), and only the first few of each kind
+    turned into text.
+*/
+class Validator {
+
+    public:
+
+    struct Config {
+        /*  where room images are, "" = don't check images (generated worlds don't have any)  */
+        std::string imageDirectory;
+        /*  threads checking, 0 = one per core  */
+        size_t threads = 0;
+        /*  problems each check lists at most, the rest are only counted  */
+        size_t maxExamples = 10;
+    };
+
+    /*  what one check found  */
+    struct Check {
+        std::string name;
+        /*  errors make the world wrong, warnings might be on purpose  */
+        bool isError;
+        size_t count = 0;
+        /*  the first Config::maxExamples problems, one line each  */
+        std::vector<std::string> examples;
+    };
+
+    struct Report {
+        /*  every check, in the order they're described above (empty ones too)  */
+        std::vector<Check> checks;
+
+        size_t rooms = 0;
+        size_t items = 0;
+        /*  rooms reachable from the start, and how many of those only through exits special commands make  */
+        size_t reachableRooms = 0;
+        size_t roomsBehindSpecials = 0;
+        /*  special commands run to find those exits  */
+        size_t specialCommands = 0;
+
+        double seconds = 0;
+        size_t threads = 0;
+
+        /*  how many problems the error/warning checks found altogether  */
+        size_t GetErrorCount() const;
+        size_t GetWarningCount() const;
+    };
+
+    /*  game must be Init()ed, and isn't played while validating  */
+    Validator(TextBasedGame& _game, Config _config);
+
+    Validator(Validator const&) = delete;
+    Validator& operator=(Validator const&) = delete;
+
+    /*  runs every check  */
+    Report Validate();
+
+    private:
+
+    /*  every kind of problem, grouped by check (see CheckOf)  */
+    enum Kind : uint32_t {
+        Setup,
+        ExitTarget, ExitLabel, ExtraGraphRooms,
+        ItemId, DuplicateItem, MisplacedItem, NotInRoom, NotInInventory,
+        StartRoom,
+        Unreachable,
+        Nowhere, InUnreachableRoom,
+        MissingImage
+    };
+
+    /*  one problem - a and b are ids, which ones depends on kind  */
+    struct Problem {
+        Kind kind;
+        uint32_t a;
+        uint32_t b;
+    };
+
+    /*  an exit a special command made  */
+    struct Link {
+        uint32_t from;
+        uint32_t target;
+    };
+
+    TextBasedGame &game;
+    Config config;
+
+    /*  per worker, merged at the end  */
+    std::vector<std::vector<Problem>> problems;
+    std::vector<std::vector<Link>> links;
+
+    /*  the exits special commands make, merged like RoomGraph's - targets of room r's are linkTargets[linkOffsets[r] .. linkOffsets[r + 1])  */
+    std::vector<uint32_t> linkOffsets;
+    std::vector<uint32_t> linkTargets;
+
+    /*  file names in Config::imageDirectory  */
+    std::unordered_set<std::string> imageNames;
+
+    /*  per room: 0 = not reached, 1 = reached by exits, 2 = only with special commands' exits too  */
+    std::vector<uint8_t> reached;
+
+    /*
+        calls f(worker, begin, end) for chunks of [0, count) on every worker of the pool, until they're all done
+        each worker index is only ever used by one thread at a time
+    */
+    template<class F>
+    void ParallelFor(ThreadPool &pool, size_t count, size_t chunk, F f);
+
+    /*  room item lists, exits and images  */
+    void CheckRooms(ThreadPool &pool);
+    /*  where every item is, and the inventory  */
+    void CheckItems(ThreadPool &pool);
+    /*  runs special commands, fills links  */
+    void FindSpecialLinks(ThreadPool &pool, Report &report);
+    /*  fills reached and the reachability problems  */
+    void CheckReachable(ThreadPool &pool, Report &report);
+
+    /*  breadth first from every room in frontier, marking new rooms mark (with the special links too if useLinks)  */
+    void Spread(ThreadPool &pool, std::vector<uint32_t> frontier, uint8_t mark, bool useLinks);
+
+    /*  which check a kind of problem belongs to (index into Report::checks)  */
+    static size_t CheckOf(Kind kind);
+
+    /*  one line about a problem  */
+    std::string Describe(Problem const& p);
+};
+
+#endif /* __VALIDATOR__ */
@@ -0,0 +1,193 @@
+#include "worldgen.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+#include <unordered_set>
+
+#include "textbasedgame.hpp"
+
+namespace {
+    constexpr std::string_view RoomNouns[] = { "Hall", "Cellar", "Study", "Attic", "Pantry", "Gallery", "Library", "Chapel" };
+    constexpr std::string_view ItemNouns[] = { "Lamp", "Coin", "Book", "Candle", "Spoon", "Rope", "Map", "Bottle" };
+    constexpr std::string_view NPCNouns[] = { "Guard", "Cook", "Monk", "Clerk", "Tinker", "Porter", "Maid", "Scholar" };
+
+    std::string Lowercase(std::string s) {
+        std::transform(s.begin(), s.end(), s.begin(), [](unsigned char c) { return std::tolower(c); });
+        return s;
+    }
+}
+
+WorldGen::WorldGen(Config _config) {
+    CheckConfig(_config);
+    config = _config;
+    config.lockedDoors = std::min(config.lockedDoors, config.roomCount - 1);
+    rngState = config.seed;
+}
+
+void WorldGen::CheckConfig(Config const& config) {
+    if (config.roomCount < 1 || config.roomCount > MaxRooms) {
+        throw std::invalid_argument(fmt::format("roomCount has to be 1 to {}, not {}", MaxRooms, config.roomCount));
+    }
+    if (config.itemCount > MaxItems) {
+        throw std::invalid_argument(fmt::format("itemCount has to be at most {}, not {}", MaxItems, config.itemCount));
+    }
+    /* written so NaN fails too */
+    if (!(config.branching >= 0 && config.branching <= MaxBranching)) {
+        throw std::invalid_argument(fmt::format("branching has to be 0 to {}, not {}", MaxBranching, config.branching));
+    }
+    if (config.npcCount > MaxNPCs) {
+        throw std::invalid_argument(fmt::format("npcCount has to be at most {}, not {}", MaxNPCs, config.npcCount));
+    }
+}
+
+uint64_t WorldGen::Next() {
+    uint64_t z = (rngState += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+uint32_t WorldGen::Below(uint32_t n) {
+    return static_cast<uint32_t>(Next() % n);
+}
+
+Direction WorldGen::ClaimDirection(uint32_t a, uint32_t b) {
+    int start = static_cast<int>(Below(LinkDirections));
+    for (int i = 0; i < LinkDirections; i++) {
+        auto d = static_cast<Direction>((start + i) % LinkDirections);
+        int bit = 1 << static_cast<int>(d);
+        int revBit = 1 << static_cast<int>(DirectionReverse(d));
+        if (!(usedDirs[a] & bit) && !(usedDirs[b] & revBit)) {
+            usedDirs[a] |= bit;
+            usedDirs[b] |= revBit;
+            return d;
+        }
+    }
+    return Direction::Invalid;
+}
+
+std::string WorldGen::RoomName(uint32_t i) {
+    return fmt::format("{} {}", RoomNouns[i % std::size(RoomNouns)], i);
+}
+
+std::string WorldGen::GetStartRoom() {
+    return RoomName(0);
+}
+
+void WorldGen::Generate(TextBasedGame& game) {
+    uint32_t n = config.roomCount;
+    usedDirs.assign(n, 0);
+
+    /* rooms */
+
+    for (uint32_t i = 0; i < n; i++) {
+        auto name = RoomName(i);
+        auto repr = Lowercase(name);
+        game.AddRoom(Room(name, repr, std::unordered_map<Room::Message, std::string>{
+            { Room::Message::OnEnter, fmt::format("You have entered the {}.", repr) },
+            { Room::Message::OnLook, fmt::format("You are in the {}.", repr) }
+        }));
+    }
+
+    /* which tree exits start locked - always leading to a room further from the start */
+
+    std::unordered_set<uint32_t> locked;
+    while (locked.size() < config.lockedDoors) {
+        locked.insert(1 + Below(n - 1));
+    }
+
+    /*
+        spanning tree - every room links back to an earlier one, so room i is only ever
+        behind doors leading to rooms <= i, and a key for room i's door can go anywhere before it
+    */
+
+    for (uint32_t i = 1; i < n; i++) {
+        uint32_t parent = Below(i);
+        auto d = ClaimDirection(parent, i);
+        /* parent is full, fall back to the previous room (can't fail: i - 1 has no children yet, only its own way back is taken) */
+        if (d == Direction::Invalid) {
+            parent = i - 1;
+            d = ClaimDirection(parent, i);
+        }
+
+        auto parentName = RoomName(parent), childName = RoomName(i);
+        if (!locked.contains(i)) {
+            game.LinkRooms(parentName, d, childName);
+            continue;
+        }
+
+        auto doorName = fmt::format("Door {}", i), keyName = fmt::format("Key {}", i);
+        auto doorRepr = Lowercase(doorName), keyRepr = Lowercase(keyName);
+        game.AddItem(Item(keyName, keyRepr, std::unordered_map<Item::Message, std::string>{
+            { Item::Message::OnInspect, fmt::format("A plain iron key, stamped with the number {}.", i) }
+        }));
+        game.AddItem(Item(doorName, doorRepr, std::unordered_map<Item::Message, std::string>{
+            { Item::Message::OnInspect, fmt::format("This door leads {}, and it's locked. The number {} is painted on it.", DirectionRepr(d, false), i) }
+        }, std::vector<Command>{},
+        Item::Attrs { false },
+        Item::Flags { false }));
+        game.AddScript(doorName, fmt::format("unlock {}", doorRepr), { fmt::format("unlock {}", doorRepr) }, fmt::format(
+            "if holding {}\n"
+            "    move {} to nowhere\n"
+            "    link {} {} {} {}\n"
+            "    say {}\n"
+            "else\n"
+            "    say \"You don't have the key!\"\n"
+            "end\n",
+            Script::Quote(keyName), Script::Quote(keyName),
+            Script::Quote(parentName), DirectionRepr(d, false), Script::Quote(childName), DirectionRepr(DirectionReverse(d), false),
+            Script::Quote(fmt::format("You unlocked the {}.\nYou can now go {}.", doorRepr, DirectionRepr(d, false)))));
+        game.AddItemToRoom(doorName, parentName);
+        game.AddItemToRoom(keyName, RoomName(Below(i)));
+    }
+
+    /* extra exits */
+
+    uint64_t extra = static_cast<uint64_t>(config.branching * n);
+    for (uint64_t e = 0; e < extra && n > 1; e++) {
+        uint32_t a = Below(n), b = Below(n);
+        if (a == b) {
+            continue;
+        }
+        auto d = ClaimDirection(a, b);
+        if (d != Direction::Invalid) {
+            game.LinkRooms(RoomName(a), d, RoomName(b));
+        }
+    }
+
+    /* loose items */
+
+    for (uint32_t i = 0; i < config.itemCount; i++) {
+        auto name = fmt::format("{} {}", ItemNouns[i % std::size(ItemNouns)], i);
+        auto repr = Lowercase(name);
+        game.AddItem(Item(name, repr, std::unordered_map<Item::Message, std::string>{
+            { Item::Message::OnInspect, fmt::format("A perfectly ordinary {}.", repr) }
+        }));
+        game.AddItemToRoom(name, RoomName(Below(n)));
+    }
+
+    /* NPCs - the same conversation with a different name in it, so most of the text is interned once */
+
+    for (uint32_t i = 0; i < config.npcCount; i++) {
+        auto name = fmt::format("{} {}", NPCNouns[i % std::size(NPCNouns)], i);
+        auto repr = Lowercase(name);
+        std::vector<NPC::Trade> trades;
+        if (config.itemCount > 0) {
+            uint32_t item = Below(config.itemCount);
+            auto wants = fmt::format("{} {}", ItemNouns[item % std::size(ItemNouns)], item);
+            trades.push_back(NPC::Trade { wants, "", fmt::format("The {} takes the {} and thanks you.", repr, Lowercase(wants)) });
+        }
+        game.AddNPC(NPC(name, repr, std::unordered_map<NPC::Message, std::string>{
+            { NPC::Message::OnInspect, fmt::format("The {}, going about their day.", repr) }
+        }), std::vector<Dialogue::Line>{
+            { fmt::format("\"I'm the {}. Busy day.\"", repr), { { "Where are you going?", 1 }, { "Bye.", Dialogue::End } } },
+            { "\"Wherever I'm needed next.\"", { { "Bye.", Dialogue::End } } }
+        }, trades);
+
+        std::vector<NPC::Stop> stops(2 + Below(3));
+        for (auto &stop : stops) {
+            stop = NPC::Stop { RoomName(Below(n)), 5 + Below(46) };
+        }
+        game.AddNPCSchedule(name, stops, Below(1000));
+    }
+}
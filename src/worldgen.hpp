@@ -0,0 +1,100 @@
+#ifndef __WORLDGEN__
+#define __WORLDGEN__
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "globals.hpp"
+
+class TextBasedGame;
+
+/*
+    Procedural world generator, for stress testing and benchmarks
+    Builds a world through the same setup calls InitRooms()/InitItems() use
+    (AddRoom, AddItem, LinkRooms, AddItemToRoom), so whatever it makes is a normal world.
+
+    The same Config (including the seed) always makes exactly the same world,
+    on any platform - it uses its own RNG instead of <random>'s distributions.
+
+    Layout:
+    - rooms are connected by a random spanning tree first, so everything is reachable
+    - then extra exits are sprinkled in according to Config::branching
+    - some tree exits are locked: they start unlinked, with a door item on the near side
+      and a key somewhere that can be reached without going through that door, like the red door
+    - loose items are scattered over random rooms
+    - NPCs start at the first stop of a schedule of 2-4 random rooms, 5-50 turns each,
+      and each one takes one random loose item in trade
+*/
+class WorldGen {
+
+    public:
+
+    /*  everything that can be tweaked about a generated world  */
+    struct Config {
+        /*  same seed = same world  */
+        uint64_t seed = 1;
+        /*  number of rooms, 1 to MaxRooms  */
+        uint32_t roomCount = 1000;
+        /*  number of loose items (not counting keys and doors), up to MaxItems  */
+        uint32_t itemCount = 1000;
+        /*  extra exits per room on average, on top of the spanning tree (0 = pure tree), up to MaxBranching  */
+        float branching = 0.5f;
+        /*  number of locked doors (capped at roomCount - 1)  */
+        uint32_t lockedDoors = 10;
+        /*  number of NPCs, each with a short conversation and a schedule of a few random rooms, up to MaxNPCs  */
+        uint32_t npcCount = 0;
+    };
+
+    private:
+
+    Config config;
+
+    /*  splitmix64 state  */
+    uint64_t rngState;
+
+    /*  per room, bit d is set if the standard direction d is already taken  */
+    std::vector<uint8_t> usedDirs;
+
+    /*  next random number  */
+    uint64_t Next();
+
+    /*  random number in [0, n)  */
+    uint32_t Below(uint32_t n);
+
+    /*
+        picks a random standard direction that's free going a -> b and free coming back b -> a,
+        marks both as taken, returns Direction::Invalid if there isn't one
+    */
+    Direction ClaimDirection(uint32_t a, uint32_t b);
+
+    public:
+
+    /*  standard directions the generator links rooms with (north through down)  */
+    static inline constexpr int LinkDirections = 6;
+
+    /*  limits on Config - past these a world wouldn't fit in memory, or (branching) couldn't be made  */
+    static inline constexpr uint32_t MaxRooms = 1u << 24;
+    static inline constexpr uint32_t MaxItems = 1u << 24;
+    /*  every extra exit takes a direction at both ends, and there are only LinkDirections of those per room  */
+    static inline constexpr float MaxBranching = LinkDirections / 2;
+    static inline constexpr uint32_t MaxNPCs = 1u << 20;
+
+    /*  WorldGen constructor - throws invalid_argument if _config is out of range (see CheckConfig)  */
+    WorldGen(Config _config);
+
+    /*  throws invalid_argument saying what's wrong if any of config is outside the limits above  */
+    static void CheckConfig(Config const& config);
+
+    /*  internal name of the i-th generated room ("Hall 17")  */
+    static std::string RoomName(uint32_t i);
+
+    /*  the room the player should start in  */
+    std::string GetStartRoom();
+
+    /*  builds the whole world into the game, call before InitCommands()  */
+    void Generate(TextBasedGame& game);
+
+};
+
+#endif /* __WORLDGEN__ */
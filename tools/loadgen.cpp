@@ -0,0 +1,250 @@
+/*
+    Load generator for the multi-player server (./build/game --serve ...)
+
+    Opens a lot of connections, has every one of them play a short script of commands
+    (one at a time, waiting for the "> " prompt in between like a person would),
+    then reports throughput and latency, and optionally keeps the connections open and idle
+    so the server's memory per player can be looked at
+
+    usage: loadgen [--connect <address>] [--sessions <n>] [--rounds <n>] [--script "cmd;cmd;..."] [--hold <seconds>]
+        --connect   same addresses as --serve: "4000", "host:4000" or "unix:/path" (default 4000)
+        --sessions  how many players to connect (default 1000)
+        --rounds    how many times every player runs the script, 0 just connects (default 10)
+        --script    the commands, separated by ';' (default "look around;go north;go south;inventory")
+        --hold      seconds to stay connected after the rounds are done (default 0)
+
+    linux only (epoll), build with: make loadgen
+*/
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+struct Client {
+    int fd = -1;
+    /*  what's come back since the last command  */
+    std::string in;
+    /*  next command in the script, and how many times the script has run  */
+    size_t step = 0;
+    size_t round = 0;
+    /*  when the last command (or the connect) was sent  */
+    Clock::time_point sentAt;
+    bool greeted = false;
+    bool done = false;
+};
+
+struct Options {
+    std::string address = "4000";
+    size_t sessions = 1000;
+    size_t rounds = 10;
+    std::vector<std::string> script = { "look around", "go north", "go south", "inventory" };
+    double hold = 0;
+};
+
+int Connect(std::string const& address) {
+    int fd;
+    if (address.rfind("unix:", 0) == 0) {
+        sockaddr_un addr = {};
+        addr.sun_family = AF_UNIX;
+        std::strncpy(addr.sun_path, address.c_str() + 5, sizeof(addr.sun_path) - 1);
+        fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (fd >= 0 && ::connect(fd, (sockaddr*)&addr, sizeof(addr)) < 0) {
+            ::close(fd);
+            return -1;
+        }
+    } else {
+        std::string host = "127.0.0.1", port = address;
+        size_t colon = address.rfind(':');
+        if (colon != std::string::npos) {
+            host = address.substr(0, colon);
+            port = address.substr(colon + 1);
+        }
+        sockaddr_in addr = {};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(std::atoi(port.c_str()));
+        ::inet_pton(AF_INET, host.c_str(), &addr.sin_addr);
+        fd = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (fd >= 0 && ::connect(fd, (sockaddr*)&addr, sizeof(addr)) < 0) {
+            ::close(fd);
+            return -1;
+        }
+        int on = 1;
+        ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+    }
+    return fd;
+}
+
+bool SendLine(Client &c, std::string const& line) {
+    std::string data = line + "\n";
+    c.sentAt = Clock::now();
+    return ::send(c.fd, data.data(), data.size(), MSG_NOSIGNAL) == (ssize_t)data.size();
+}
+
+/*  percentile p (0-1) of sorted samples  */
+double Percentile(std::vector<double> const& sorted, double p) {
+    if (sorted.empty()) {
+        return 0;
+    }
+    return sorted[std::min(sorted.size() - 1, (size_t)(p * sorted.size()))];
+}
+
+int main(int argc, char **argv) {
+    Options opt;
+    std::vector<std::string> args(argv + 1, argv + argc);
+    for (size_t i = 0; i + 1 < args.size(); i += 2) {
+        if (args[i] == "--connect") {
+            opt.address = args[i + 1];
+        } else if (args[i] == "--sessions") {
+            opt.sessions = std::stoul(args[i + 1]);
+        } else if (args[i] == "--rounds") {
+            opt.rounds = std::stoul(args[i + 1]);
+        } else if (args[i] == "--hold") {
+            opt.hold = std::stod(args[i + 1]);
+        } else if (args[i] == "--script") {
+            opt.script.clear();
+            std::istringstream s(args[i + 1]);
+            for (std::string cmd; std::getline(s, cmd, ';'); ) {
+                if (!cmd.empty()) {
+                    opt.script.push_back(cmd);
+                }
+            }
+        } else {
+            std::cerr << "unknown option " << args[i] << std::endl;
+            return 2;
+        }
+    }
+    if (opt.script.empty()) {
+        opt.rounds = 0;
+    }
+
+    rlimit limit;
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur < limit.rlim_max) {
+        limit.rlim_cur = limit.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &limit);
+    }
+
+    int epollFd = ::epoll_create1(EPOLL_CLOEXEC);
+    std::vector<Client> clients(opt.sessions);
+
+    /* connecting is blocking, the server's listen backlog takes care of bursts */
+    auto connectStart = Clock::now();
+    for (size_t i = 0; i < clients.size(); i++) {
+        Client &c = clients[i];
+        c.fd = Connect(opt.address);
+        if (c.fd < 0) {
+            std::cerr << "connection " << i << " failed: " << std::strerror(errno) << std::endl;
+            return 1;
+        }
+        c.sentAt = Clock::now();
+        epoll_event ev = {};
+        ev.events = EPOLLIN;
+        ev.data.u64 = i;
+        ::epoll_ctl(epollFd, EPOLL_CTL_ADD, c.fd, &ev);
+    }
+
+    std::vector<double> latencies;
+    latencies.reserve(opt.sessions * opt.rounds * opt.script.size());
+    size_t greeted = 0, finished = 0, failed = 0;
+    Clock::time_point runStart;
+    std::vector<epoll_event> events(1024);
+    char buffer[65536];
+
+    while (finished + failed < clients.size()) {
+        int n = ::epoll_wait(epollFd, events.data(), events.size(), 10000);
+        if (n == 0) {
+            std::cerr << "server stopped answering" << std::endl;
+            return 1;
+        }
+        for (int e = 0; e < n; e++) {
+            Client &c = clients[events[e].data.u64];
+            ssize_t got = ::recv(c.fd, buffer, sizeof(buffer), 0);
+            if (got <= 0) {
+                if (got < 0 && errno == EINTR) {
+                    continue;
+                }
+                ::epoll_ctl(epollFd, EPOLL_CTL_DEL, c.fd, nullptr);
+                failed++;
+                continue;
+            }
+            c.in.append(buffer, got);
+
+            /* a whole reply ends with the prompt */
+            if (!(c.in == "> " || (c.in.size() >= 3 && c.in.compare(c.in.size() - 3, 3, "\n> ") == 0))) {
+                continue;
+            }
+            double ms = std::chrono::duration<double, std::milli>(Clock::now() - c.sentAt).count();
+            c.in.clear();
+
+            if (!c.greeted) {
+                c.greeted = true;
+                greeted++;
+                if (greeted == clients.size()) {
+                    /* nobody starts playing before everyone's in, so the numbers don't include connecting */
+                    double connectMs = std::chrono::duration<double, std::milli>(Clock::now() - connectStart).count();
+                    std::cout << clients.size() << " sessions connected in " << connectMs << " ms" << std::endl;
+                    runStart = Clock::now();
+                    for (auto &other : clients) {
+                        if (opt.rounds == 0) {
+                            other.done = true;
+                            finished++;
+                        } else if (!SendLine(other, opt.script[0])) {
+                            failed++;
+                        }
+                    }
+                }
+                continue;
+            }
+
+            latencies.push_back(ms);
+            if (++c.step == opt.script.size()) {
+                c.step = 0;
+                c.round++;
+            }
+            if (c.round == opt.rounds) {
+                c.done = true;
+                finished++;
+            } else if (!SendLine(c, opt.script[c.step])) {
+                failed++;
+            }
+        }
+    }
+
+    if (opt.rounds > 0) {
+        double seconds = std::chrono::duration<double>(Clock::now() - runStart).count();
+        std::sort(latencies.begin(), latencies.end());
+        std::cout << latencies.size() << " commands in " << seconds * 1000 << " ms ("
+                  << (seconds > 0 ? latencies.size() / seconds : 0) << " commands/sec)" << std::endl;
+        std::cout << "latency ms: p50 " << Percentile(latencies, 0.5) << ", p99 " << Percentile(latencies, 0.99)
+                  << ", max " << (latencies.empty() ? 0 : latencies.back()) << std::endl;
+    }
+    if (failed > 0) {
+        std::cout << failed << " sessions failed" << std::endl;
+    }
+
+    if (opt.hold > 0) {
+        std::cout << "holding " << clients.size() - failed << " idle sessions for " << opt.hold << " s" << std::endl;
+        std::this_thread::sleep_for(std::chrono::duration<double>(opt.hold));
+    }
+
+    for (auto &c : clients) {
+        ::close(c.fd);
+    }
+    return failed > 0 ? 1 : 0;
+}